@@ -25,6 +25,11 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+
+// The extra field padding the local header of a stored entry, as zipalign
+// writes it: the uint16 alignment, then zeros.
+#define ZIP_ALIGN_EXTRA_ID      0xD935
+#define ZIP_LOCAL_HEADER_SIZE   30
   
 ZipMaker::ZipMaker() :
     m_zDoc(NULL)
@@ -32,6 +37,19 @@ ZipMaker::ZipMaker() :
     m_error[0] = 0; 
     m_opt_compress_level = Z_BEST_SPEED;
     m_zi = NULL;
+    m_stream = NULL;
+
+    fill_fopen64_filefunc(&m_filefunc);
+    m_open_file = m_filefunc.zopen64_file;
+    m_filefunc.zopen64_file = OpenFile;
+    m_filefunc.opaque = this;
+}
+
+voidpf ZCALLBACK ZipMaker::OpenFile(voidpf opaque, const void *filename, int mode)
+{
+    ZipMaker *self = (ZipMaker*)opaque;
+    self->m_stream = self->m_open_file(NULL, filename, mode);
+    return self->m_stream;
 }
 
 ZipMaker::~ZipMaker()
@@ -45,7 +63,7 @@ bool ZipMaker::CreateNew(const char *fileName, bool bAppend)
 
      Release();
  
-     m_zDoc = zipOpen64(fileName, bAppend); 
+     m_zDoc = zipOpen2_64(fileName, bAppend, NULL, &m_filefunc); 
      if (m_zDoc == NULL) {
         strcpy(m_error, "zipOpen64 error");
     } 
@@ -77,6 +95,7 @@ void ZipMaker::Release()
        zipClose((zipFile)m_zDoc, NULL);
        m_zDoc = NULL;       
    }
+   m_stream = NULL;
    if (m_zi){
        delete ((zip_fileinfo*)m_zi);
        m_zi = NULL;
@@ -87,34 +106,147 @@ bool ZipMaker::Close(){
     if (m_zDoc){
        zipClose((zipFile)m_zDoc, NULL);
        m_zDoc = NULL;
+       m_stream = NULL;
        return true;
    }
    return false;     
 }
 
-bool ZipMaker::AddFromBuffer(const char *innerFile, const char *buffer, unsigned int buferSize)
+int ZipMaker::GetCompressLevel()
 {
-    assert(buffer);
-    assert(innerFile);
-    assert(m_zDoc);   
     int level = m_opt_compress_level;
 
     if (level < Z_DEFAULT_COMPRESSION  || level > Z_BEST_COMPRESSION){
         level = Z_DEFAULT_COMPRESSION;
     }
+    return level;
+}
+
+bool ZipMaker::AddFromBuffer(const char *innerFile, const char *buffer, unsigned int buferSize)
+{
+    return AddFromBuffer(innerFile, buffer, buferSize, NULL, 0);
+}
+
+bool ZipMaker::AddFromBuffer(const char *innerFile, const char *buffer, unsigned int buferSize,
+                             const void *extra, unsigned int extraSize)
+{
+    assert(buffer || buferSize == 0);
+    assert(innerFile);
+    assert(m_zDoc);   
+    int level = GetCompressLevel();
 
     zipOpenNewFileInZip((zipFile)m_zDoc,innerFile,(zip_fileinfo*)m_zi,
-                                NULL,0,NULL,0,NULL ,
+                                NULL,0,extra,extraSize,NULL ,
                                 Z_DEFLATED,
                                 level);
 
-    zipWriteInFileInZip((zipFile)m_zDoc, buffer, (unsigned int)buferSize);
+    if (buferSize > 0)
+        zipWriteInFileInZip((zipFile)m_zDoc, buffer, (unsigned int)buferSize);
 
     zipCloseFileInZip((zipFile)m_zDoc);
 
     return true;
 }
 
+bool ZipMaker::AddStored(const char *innerFile, const char *buffer, unsigned int buferSize,
+                          const void *extra, unsigned int extraSize, unsigned int align)
+{
+    assert(buffer);
+    assert(innerFile);
+    assert(m_zDoc);
+    assert(m_stream);
+    assert(align > 0 && align <= 0xffff);
+
+    // The data follows the local header, its file name and its extra field.
+    ZPOS64_T pos = m_filefunc.ztell64_file(m_filefunc.opaque, m_stream);
+    if (pos == (ZPOS64_T)-1){
+        strcpy(m_error, "ztell64 error");
+        return false;
+    }
+    pos += ZIP_LOCAL_HEADER_SIZE + strlen(innerFile) + 6;
+
+    unsigned int pad = (unsigned int)((align - pos % align) % align);
+    std::vector<unsigned char> local_extra(6 + pad, 0);
+    local_extra[0] = ZIP_ALIGN_EXTRA_ID & 0xff;
+    local_extra[1] = ZIP_ALIGN_EXTRA_ID >> 8;
+    local_extra[2] = (2 + pad) & 0xff;
+    local_extra[3] = (2 + pad) >> 8;
+    local_extra[4] = align & 0xff;
+    local_extra[5] = align >> 8;
+
+    if (zipOpenNewFileInZip((zipFile)m_zDoc, innerFile, (zip_fileinfo*)m_zi,
+                                local_extra.data(), (uInt)local_extra.size(), extra, extraSize, NULL,
+                                0, 0) != ZIP_OK){
+        strcpy(m_error, "zipOpenNewFileInZip error");
+        return false;
+    }
+
+    zipWriteInFileInZip((zipFile)m_zDoc, buffer, buferSize);
+
+    if (zipCloseFileInZip((zipFile)m_zDoc) != ZIP_OK){
+        strcpy(m_error, "zipCloseFileInZip error");
+        return false;
+    }
+    return true;
+}
+
+bool ZipMaker::AddDeflated(const char *innerFile, const ZipDeflateData &data)
+{
+    assert(innerFile);
+    assert(m_zDoc);
+
+    if (zipOpenNewFileInZip2((zipFile)m_zDoc, innerFile, (zip_fileinfo*)m_zi,
+                                NULL, 0, NULL, 0, NULL,
+                                Z_DEFLATED,
+                                GetCompressLevel(), 1) != ZIP_OK){
+        strcpy(m_error, "zipOpenNewFileInZip2 error");
+        return false;
+    }
+
+    if (data.data.size() > 0){
+        zipWriteInFileInZip((zipFile)m_zDoc, data.data.data(), (unsigned int)data.data.size());
+    }
+
+    if (zipCloseFileInZipRaw((zipFile)m_zDoc, data.raw_size, data.crc) != ZIP_OK){
+        strcpy(m_error, "zipCloseFileInZipRaw error");
+        return false;
+    }
+    return true;
+}
+
+bool ZipMaker::Deflate(const char *buffer, unsigned int size, int level, ZipDeflateData &out)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    if (level < Z_DEFAULT_COMPRESSION  || level > Z_BEST_COMPRESSION){
+        level = Z_DEFAULT_COMPRESSION;
+    }
+
+    // Negative window bits, a raw stream as minizip writes it.
+    if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+        return false;
+    }
+
+    out.data.resize(deflateBound(&zs, size));
+    zs.next_in = (Bytef*)buffer;
+    zs.avail_in = size;
+    zs.next_out = out.data.data();
+    zs.avail_out = (uInt)out.data.size();
+
+    int ret = deflate(&zs, Z_FINISH);
+    out.data.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    if (ret != Z_STREAM_END){
+        return false;
+    }
+
+    out.raw_size = size;
+    out.crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)buffer, size);
+    return true;
+}
+
 bool ZipMaker::AddFromFile(const char *localFile, const char *innerFile)
 {
     assert(localFile);
@@ -25,7 +25,16 @@
 
 #include <minizip/zip.h>
 #include <minizip/unzip.h>
+#include <vector>
  
+//raw deflate stream of a buffer, made by ZipMaker::Deflate()
+struct ZipDeflateData
+{
+    std::vector<unsigned char> data;
+    unsigned long raw_size;
+    unsigned long crc;
+};
+
 
 class ZipMaker
 {
@@ -46,6 +55,21 @@ public:
     //add a inner file from  buffer
     bool AddFromBuffer(const char *innerFile, const char *buffer, unsigned int buferSize);
 
+    //add a inner file from buffer, with a global extra field
+    bool AddFromBuffer(const char *innerFile, const char *buffer, unsigned int buferSize,
+                       const void *extra, unsigned int extraSize);
+
+    //add a inner file without compression, the data can be mapped from the file,
+    //its offset in the file is a multiple of align
+    bool AddStored(const char *innerFile, const char *buffer, unsigned int buferSize,
+                   const void *extra, unsigned int extraSize, unsigned int align);
+
+    //add a inner file that was compressed by Deflate()
+    bool AddDeflated(const char *innerFile, const ZipDeflateData &data);
+
+    //compress a buffer to raw deflate data, thread safe
+    static bool Deflate(const char *buffer, unsigned int size, int level, ZipDeflateData &out);
+
     //add a inner file from local file
     bool AddFromFile(const char *localFile, const char *innerFile);
 
@@ -55,9 +79,17 @@ public:
 public:
     int m_opt_compress_level;
 
+private:
+    int GetCompressLevel();
+
+    static voidpf ZCALLBACK OpenFile(voidpf opaque, const void *filename, int mode);
+
 private:
     zipFile         m_zDoc; //zip file handle
     zip_fileinfo    *m_zi; //life must as m_zDoc; 
+    zlib_filefunc64_def m_filefunc;
+    open64_file_func    m_open_file;
+    voidpf          m_stream; //the file stream of m_zDoc, to know the write position
     char     m_error[500];
 };
 
@@ -123,6 +123,10 @@ static void _loadApp(AppOptions &o, QSettings &st)
     getFiled("swapBackBufferAlways", st, o.swapBackBufferAlways, false);
     getFiled("fontSize", st, o.fontSize, 9.0);
     getFiled("autoScrollLatestData", st, o.autoScrollLatestData, true);
+    getFiled("decodeThreadCount", st, o.decodeThreadCount, 0);
+    getFiled("saveMipmap", st, o.saveMipmap, false);
+    getFiled("paintTimeOverlay", st, o.paintTimeOverlay, false);
+    getFiled("hugePageBlocks", st, o.hugePageBlocks, false);
     getFiled("version", st, o.version, 1);
 
     o.warnofMultiTrig = true;
@@ -160,6 +164,10 @@ static void _saveApp(AppOptions &o, QSettings &st)
     setFiled("swapBackBufferAlways", st, o.swapBackBufferAlways);
     setFiled("fontSize", st, o.fontSize);
     setFiled("autoScrollLatestData", st, o.autoScrollLatestData);
+    setFiled("decodeThreadCount", st, o.decodeThreadCount);
+    setFiled("saveMipmap", st, o.saveMipmap);
+    setFiled("paintTimeOverlay", st, o.paintTimeOverlay);
+    setFiled("hugePageBlocks", st, o.hugePageBlocks);
     setFiled("version", st, APP_CONFIG_VERSION);
 
     QString fmt =  FormatArrayToString(o.m_protocolFormats);
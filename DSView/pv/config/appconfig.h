@@ -72,6 +72,10 @@ struct AppOptions
     bool  swapBackBufferAlways;
     bool  autoScrollLatestData;
     float fontSize;
+    int   decodeThreadCount; // 0: auto
+    bool  saveMipmap; // save logic blocks uncompressed with the mipmap
+    bool  paintTimeOverlay; // show the logic repaint time histogram
+    bool  hugePageBlocks; // back the logic blocks with huge pages, Linux only
 
     std::vector<StringPair> m_protocolFormats;
 };
@@ -56,53 +56,26 @@ Annotation::Annotation(const srd_proto_data *const pdata, DecoderStatus *status)
 	_resIndex 	= -1;
 	_status 	= status;
  
-	//make resource find key
-	std::string key;
-
-    char **annotations = pda->ann_text;
-    while(annotations && *annotations) {
-		if ((*annotations)[0] != '\n'){
-			key.append(*annotations, strlen(*annotations));
-		}		
-		annotations++;  
-	}
-	
-	if (pda->str_number_hex[0]){
-		//append numeric string
-		key.append(pda->str_number_hex, strlen(pda->str_number_hex));
-	}
- 
 	AnnotationSourceItem *resItem = NULL;
-    _resIndex = _status->m_resTable.MakeIndex(key, resItem);
+    _resIndex = _status->m_resTable.MakeIndex(pda->ann_text, pda->str_number_hex, resItem);
      
      //is a new item
 	if (resItem != NULL){ 
-        char **annotations = pda->ann_text;
-    	while(annotations && *annotations) {
-			if ((*annotations)[0] != '\n'){
-				resItem->src_lines.push_back(QString::fromUtf8(*annotations));
-			}
-			annotations++;  
-		}
- 
-		//get numeric data
-		if (pda->str_number_hex[0]){
-			int str_len = strlen(pda->str_number_hex);
-
-			if (str_len <= DECODER_MAX_DATA_BLOCK_LEN){
-				resItem->str_number_hex = (char*)malloc(str_len + 1);
-			
-				if (resItem->str_number_hex != NULL){
-					strcpy(resItem->str_number_hex, pda->str_number_hex);
-					resItem->is_numeric = true;
-				}
-			}			
-		}
-
 		_status->m_bNumeric |= resItem->is_numeric;
 	}
 }
 
+Annotation::Annotation(uint64_t start_sample, uint64_t end_sample, int format,
+				int type, int resIndex, DecoderStatus *status)
+{
+	_start_sample = start_sample;
+	_end_sample = end_sample;
+	_format = format;
+	_type = type;
+	_resIndex = resIndex;
+	_status = status;
+}
+
 Annotation::Annotation()
 {
     _start_sample = 0;
@@ -42,6 +42,8 @@ class Annotation
 {
 public:
 	Annotation(const srd_proto_data *const pdata, DecoderStatus *status);
+	Annotation(uint64_t start_sample, uint64_t end_sample, int format,
+				int type, int resIndex, DecoderStatus *status);
     Annotation();
 	~Annotation();
 
@@ -62,6 +64,14 @@ public:
 		return _type;
 	}  
 
+	inline int res_index() const{
+		return _resIndex;
+	}
+
+	inline DecoderStatus* status() const{
+		return _status;
+	}
+
 	bool is_numberic();
 
 	const std::vector<QString>& annotations() const;
@@ -23,10 +23,35 @@
 #include <assert.h>
 #include <stdlib.h> 
 #include <math.h>
+#include <string.h>
 #include "../../log.h"
 #include "../../dsvdef.h"
  
 const char g_bin_cvt_table[] = "0000000100100011010001010110011110001001101010111100110111101111";
+
+//FNV-1a
+#define RES_HASH_OFFSET 14695981039346656037ULL
+#define RES_HASH_PRIME  1099511628211ULL
+#define RES_KEY_NUMBER_MARK '\x1f'
+#define RES_MIN_SLOT_COUNT 1024
+
+static inline uint64_t hash_char(uint64_t hash, unsigned char c)
+{
+	return (hash ^ c) * RES_HASH_PRIME;
+}
+
+//hash the text with the end flag, and count the key bytes
+static inline uint64_t hash_text(uint64_t hash, const char *text, uint32_t &key_len)
+{
+	const unsigned char *rd = (const unsigned char*)text;
+
+	while (*rd){
+		hash = hash_char(hash, *rd);
+		rd++;
+	}
+	key_len += (uint32_t)(rd - (const unsigned char*)text) + 1;
+	return hash_char(hash, 0);
+}
  
  char* bin2oct_string(char *buf, int size, const char *bin, int len){
 	char *wr = buf + size - 1;
@@ -99,38 +124,178 @@ long long bin2long_string(const char *bin, int len)
 //-----------------------------------
 
 AnnotationResTable::AnnotationResTable(){
-
-  }
+	m_keyArenaPos = NULL;
+	m_keyArenaLeft = 0;
+	m_itemCount = 0;
+	memset(m_itemSegments, 0, sizeof(m_itemSegments));
+}
 
 AnnotationResTable::~AnnotationResTable(){
 	reset();
 }
  
-int AnnotationResTable::MakeIndex(const std::string &key, AnnotationSourceItem* &newItem)
-{   
-    auto fd = m_indexs.find(key);
-    if (fd != m_indexs.end()){
-        return (*fd).second;
-    } 
-  
-    AnnotationSourceItem *item = new AnnotationSourceItem();
-    m_resourceTable.push_back(item);
-
-    item->cur_display_format = -1;
-    item->is_numeric = false;
+int AnnotationResTable::MakeIndex(char **ann_text, const char *number_hex, AnnotationSourceItem* &newItem)
+{
+	if (number_hex == NULL)
+		number_hex = "";
+
+	//the key is: line1\0 line2\0 ... mark number_hex\0
+	uint64_t hash = RES_HASH_OFFSET;
+	uint32_t key_len = 0;
+
+	for (char **rd = ann_text; rd && *rd; rd++){
+		if ((*rd)[0] != '\n')
+			hash = hash_text(hash, *rd, key_len);
+	}
+	hash = hash_char(hash, RES_KEY_NUMBER_MARK);
+	key_len++;
+	hash = hash_text(hash, number_hex, key_len);
+
+	if (m_slots.empty())
+		grow_slots();
+
+	uint64_t mask = m_slots.size() - 1;
+	uint64_t pos = hash & mask;
+
+	while (m_slots[pos].index != -1)
+	{
+		const AnnotationResSlot &slot = m_slots[pos];
+		if (slot.hash == hash && match_key(m_keys[slot.index], ann_text, number_hex)){
+			return slot.index;
+		}
+		pos = (pos + 1) & mask;
+	}
+
+	int dex = m_itemCount.load(std::memory_order_relaxed);
+	int seg = dex >> ItemSegmentPower;
+
+	if (seg >= MaxItemSegments){
+		dsv_err("The annotation resource table is full.");
+		assert(false);
+		return -1;
+	}
+
+	//copy the key
+	char *key = alloc_key(key_len);
+	char *wr = key;
+
+	for (char **rd = ann_text; rd && *rd; rd++){
+		if ((*rd)[0] != '\n'){
+			int len = strlen(*rd) + 1;
+			memcpy(wr, *rd, len);
+			wr += len;
+		}
+	}
+	*wr++ = RES_KEY_NUMBER_MARK;
+	char *key_number = wr;
+	memcpy(wr, number_hex, strlen(number_hex) + 1);
+
+	AnnotationResKey res_key;
+	res_key.data = key;
+	res_key.len = key_len;
+	res_key.hash = hash;
+	m_keys.push_back(res_key);
+
+	m_slots[pos].hash = hash;
+	m_slots[pos].index = dex;
+
+	//fill the item before it is published
+	AnnotationSourceItem *item = new AnnotationSourceItem();
+	item->cur_display_format = -1;
+	item->is_numeric = false;
 	item->str_number_hex = NULL;
-    newItem = item;
-   
-    int dex = m_indexs.size();
-    m_indexs[key] = dex;
-    return dex;
+
+	for (char **rd = ann_text; rd && *rd; rd++){
+		if ((*rd)[0] != '\n'){
+			item->src_lines.push_back(QString::fromUtf8(*rd));
+		}
+	}
+
+	if (key_number[0] && strlen(key_number) <= DECODER_MAX_DATA_BLOCK_LEN){
+		item->str_number_hex = key_number;
+		item->is_numeric = true;
+	}
+
+	if (m_itemSegments[seg] == NULL){
+		m_itemSegments[seg] = new AnnotationSourceItem*[ItemSegmentSize];
+	}
+	m_itemSegments[seg][dex & (ItemSegmentSize - 1)] = item;
+	m_itemCount.store(dex + 1, std::memory_order_release);
+
+	if (m_keys.size() * 2 > m_slots.size())
+		grow_slots();
+
+	newItem = item;
+	return dex;
 }
 
 AnnotationSourceItem* AnnotationResTable::GetItem(int index){
-    if (index < 0 || index >= (int)m_resourceTable.size()){
+    if (index < 0 || index >= m_itemCount.load(std::memory_order_acquire)){
         assert(false);
+        return NULL;
     }
-    return m_resourceTable[index];
+    return m_itemSegments[index >> ItemSegmentPower][index & (ItemSegmentSize - 1)];
+}
+
+bool AnnotationResTable::match_key(const AnnotationResKey &key, char **ann_text, const char *number_hex)
+{
+	const char *rd = key.data;
+	const char *end = key.data + key.len;
+
+	for (char **line = ann_text; line && *line; line++){
+		if ((*line)[0] == '\n')
+			continue;
+
+		size_t len = strlen(*line) + 1;
+		if ((size_t)(end - rd) < len || memcmp(rd, *line, len) != 0)
+			return false;
+		rd += len;
+	}
+
+	if (rd == end || *rd != RES_KEY_NUMBER_MARK)
+		return false;
+	rd++;
+
+	size_t len = strlen(number_hex) + 1;
+	return (size_t)(end - rd) == len && memcmp(rd, number_hex, len) == 0;
+}
+
+char* AnnotationResTable::alloc_key(uint32_t len)
+{
+	if (len > m_keyArenaLeft)
+	{
+		uint32_t block_size = len > KeyArenaBlockSize ? len : KeyArenaBlockSize;
+		char *block = new char[block_size];
+		m_keyArena.push_back(block);
+		m_keyArenaPos = block;
+		m_keyArenaLeft = block_size;
+	}
+
+	char *key = m_keyArenaPos;
+	m_keyArenaPos += len;
+	m_keyArenaLeft -= len;
+	return key;
+}
+
+void AnnotationResTable::grow_slots()
+{
+	uint64_t count = m_slots.empty() ? RES_MIN_SLOT_COUNT : m_slots.size() * 2;
+	AnnotationResSlot empty_slot;
+	empty_slot.hash = 0;
+	empty_slot.index = -1;
+
+	m_slots.assign(count, empty_slot);
+	uint64_t mask = count - 1;
+
+	for (int i = 0; i < (int)m_keys.size(); i++)
+	{
+		uint64_t pos = m_keys[i].hash & mask;
+		while (m_slots[pos].index != -1)
+			pos = (pos + 1) & mask;
+
+		m_slots[pos].hash = m_keys[i].hash;
+		m_slots[pos].index = i;
+	}
 }
 
 const char* AnnotationResTable::format_to_string(const char *hex_str, int fmt)
@@ -332,13 +497,25 @@ const char* AnnotationResTable::format_numberic(const char *hex_str, int fmt)
 void AnnotationResTable::reset()
 {
 	//release all resource
-	for (auto p : m_resourceTable){
-		if (p->str_number_hex)
-			free(p->str_number_hex);
-		delete p;
+	int count = m_itemCount.load(std::memory_order_relaxed);
+	m_itemCount.store(0, std::memory_order_release);
+
+	for (int i = 0; i < count; i++){
+		delete m_itemSegments[i >> ItemSegmentPower][i & (ItemSegmentSize - 1)];
+	}
+	for (int i = 0; i < MaxItemSegments; i++){
+		delete[] m_itemSegments[i];
+		m_itemSegments[i] = NULL;
 	}
-	m_resourceTable.clear();
-	m_indexs.clear();
+	for (char *block : m_keyArena){
+		delete[] block;
+	}
+
+	m_keyArena.clear();
+	m_keyArenaPos = NULL;
+	m_keyArenaLeft = 0;
+	m_keys.clear();
+	m_slots.clear();
 }
 
 int AnnotationResTable::hexToDecimal(char * hex)
@@ -21,9 +21,9 @@
 
 #pragma once
 
-#include <map>
-#include <string>
+#include <atomic>
 #include <vector>
+#include <stdint.h>
 #include <QString>
 
 #define DECODER_MAX_DATA_BLOCK_LEN 256
@@ -38,7 +38,27 @@ struct AnnotationSourceItem
     std::vector<QString> cvt_lines; //the converted to bin/hex/oct format string lines
     int     cur_display_format; //current format  as bin/ex/oct..., init with -1
 };
+
+struct AnnotationResKey
+{
+    const char  *data; //the key bytes in the arena
+    uint32_t    len;
+    uint64_t    hash;
+};
+
+struct AnnotationResSlot
+{
+    uint64_t    hash;
+    int         index; //-1 is an empty slot
+};
  
+/*
+    The annotation texts are interned by the decode thread, it hashes the
+    text lines and the numeric string in place and probes an open addressing
+    table. The keys live in an append-only arena.
+    The items are published by a counter, so GetItem() is lock free for
+    the UI thread while decoding continues.
+*/
 class AnnotationResTable
 { 
     public:
@@ -46,11 +66,12 @@ class AnnotationResTable
     ~AnnotationResTable();
 
     public:
-       int MakeIndex(const std::string &key, AnnotationSourceItem* &newItem);
+       //the lines start with '\n' are ignored, newItem is set when the text is new
+       int MakeIndex(char **ann_text, const char *number_hex, AnnotationSourceItem* &newItem);
        AnnotationSourceItem* GetItem(int index);
 
        inline int GetCount(){
-           return m_resourceTable.size();} 
+           return m_itemCount.load(std::memory_order_acquire);} 
 
        const char* format_numberic(const char *hex_str, int fmt);
 
@@ -61,10 +82,23 @@ class AnnotationResTable
 
     private:
         const char* format_to_string(const char *hex_str, int fmt);
+        bool match_key(const AnnotationResKey &key, char **ann_text, const char *number_hex);
+        char* alloc_key(uint32_t len);
+        void grow_slots();
 
     private:
-        std::map<std::string, int>          m_indexs;
-        std::vector<AnnotationSourceItem*>  m_resourceTable;
+        static const int ItemSegmentPower = 16;
+        static const int ItemSegmentSize = 1 << ItemSegmentPower;
+        static const int MaxItemSegments = 4096;
+        static const uint32_t KeyArenaBlockSize = 64 * 1024;
+
+        std::vector<AnnotationResSlot>      m_slots;
+        std::vector<AnnotationResKey>       m_keys;
+        std::vector<char*>                  m_keyArena;
+        char                                *m_keyArenaPos;
+        uint32_t                            m_keyArenaLeft;
+        AnnotationSourceItem                **m_itemSegments[MaxItemSegments];
+        std::atomic<int>                    m_itemCount;
         char g_bin_format_tmp_buffer[DECODER_MAX_DATA_BLOCK_LEN * 4 + 2];
         char g_oct_format_tmp_buffer[DECODER_MAX_DATA_BLOCK_LEN * 3 + 2];
         char g_number_tmp_64[30];
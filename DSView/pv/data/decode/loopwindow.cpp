@@ -0,0 +1,64 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "loopwindow.h"
+
+namespace pv {
+namespace data {
+namespace decode {
+
+LoopWindow::LoopWindow()
+{
+    start(0);
+}
+
+void LoopWindow::start(uint64_t discard_count)
+{
+    _discard_base = discard_count;
+    _shift = 0;
+    _overrun = false;
+}
+
+bool LoopWindow::update(uint64_t discard_count, uint64_t sample)
+{
+    _shift = discard_count - _discard_base;
+
+    if (sample < _shift)
+        _overrun = true;
+
+    return !_overrun;
+}
+
+int LoopWindow::progress(uint64_t sample, uint64_t ring_sample_count)
+{
+    if (ring_sample_count == 0 || sample < _shift)
+        return 0;
+
+    uint64_t index = sample - _shift;
+    if (index > ring_sample_count)
+        index = ring_sample_count;
+
+    return (int)(index * 100 / ring_sample_count);
+}
+
+} // decode
+} // data
+} // pv
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_PV_DATA_DECODE_LOOPWINDOW_H
+#define DSVIEW_PV_DATA_DECODE_LOOPWINDOW_H
+
+#include <stdint.h>
+
+namespace pv {
+namespace data {
+namespace decode {
+
+// A live loop capture keeps dropping the ring head. The decoder goes on with
+// its own sample numbers, the ring index of sample i is i - shift().
+class LoopWindow
+{
+public:
+    LoopWindow();
+
+    /**
+	 * The decode starts at the ring head, discard_count is the
+	 * LogicSnapshot::get_loop_discard_count() at that time.
+	 */
+    void start(uint64_t discard_count);
+
+    /**
+	 * Moves the window to the current ring head. Returns false once the
+	 * head passed sample, the decoder can't read it any more.
+	 */
+    bool update(uint64_t discard_count, uint64_t sample);
+
+    // How far sample is into the ring window, in percent.
+    int progress(uint64_t sample, uint64_t ring_sample_count);
+
+    inline uint64_t shift(){
+        return _shift;
+    }
+
+    inline bool overrun(){
+        return _overrun;
+    }
+
+private:
+    uint64_t    _discard_base;
+    uint64_t    _shift;
+    bool        _overrun;
+};
+
+} // decode
+} // data
+} // pv
+
+#endif // DSVIEW_PV_DATA_DECODE_LOOPWINDOW_H
@@ -22,6 +22,8 @@
 
 #include <math.h>
 #include <assert.h>
+#include <algorithm>
+#include <stdlib.h>
 
 #include "rowdata.h"
 
@@ -33,13 +35,14 @@ namespace pv {
 namespace data {
 namespace decode {
 
-std::mutex RowData::_global_visitor_mutex;
-
 RowData::RowData() :
     _max_annotation(0),
     _min_annotation(0)
 {
     _item_count = 0;
+    _first_item = 0;
+    _sample_base = 0;
+    _status = NULL;
 }
 
 RowData::~RowData()
@@ -49,24 +52,52 @@ RowData::~RowData()
 
 void RowData::clear()
 {
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+    QWriteLocker lock(&_lock);
 
-    //destroy objercts
-    for (Annotation *p : _annotations){
-        delete p;
+    //release all chunks
+    for (AnnotationChunk *p : _chunks){
+        free(p);
     }
-    _annotations.clear();
+    _chunks.clear();
+    _block_max_end.clear();
+    _block_prefix_end.clear();
     _item_count = 0;
+    _first_item = 0;
+    _sample_base = 0;
     _min_annotation = 0;
 }
 
+void RowData::set_sample_base(uint64_t base)
+{
+    QWriteLocker lock(&_lock);
+
+    _sample_base = base;
+
+    while (_first_item < _item_count && end_at(_first_item) <= base){
+        _first_item++;
+    }
+
+    // Drop the whole chunks, together with their index blocks.
+    const uint64_t blocks_per_chunk = ChunkSize >> IndexBlockPower;
+
+    while (_first_item >= ChunkSize)
+    {
+        free(_chunks.front());
+        _chunks.erase(_chunks.begin());
+        _block_max_end.erase(_block_max_end.begin(), _block_max_end.begin() + blocks_per_chunk);
+        _block_prefix_end.erase(_block_prefix_end.begin(), _block_prefix_end.begin() + blocks_per_chunk);
+        _item_count -= ChunkSize;
+        _first_item -= ChunkSize;
+    }
+}
+
 uint64_t RowData::get_max_sample()
 {
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex); 
+    QReadLocker lock(&_lock);
 
-	if (_annotations.empty())
+	if (_block_prefix_end.empty() || _block_prefix_end.back() < _sample_base)
 		return 0;
-	return _annotations.back()->end_sample();
+	return _block_prefix_end.back() - _sample_base;
 }
 
 uint64_t RowData::get_max_annotation()
@@ -82,51 +113,199 @@ uint64_t RowData::get_min_annotation()
         return _min_annotation;
 }
 
-void RowData::get_annotation_subset(std::vector<pv::data::decode::Annotation*> &dest,
+uint64_t RowData::get_bytes_used()
+{
+    QReadLocker lock(&_lock);
+
+    return _chunks.size() * sizeof(AnnotationChunk)
+            + _chunks.capacity() * sizeof(AnnotationChunk*)
+            + (_block_max_end.capacity() + _block_prefix_end.capacity()) * sizeof(uint64_t);
+}
+
+Annotation RowData::make_annotation(uint64_t index)
+{
+    AnnotationChunk *chunk = _chunks[index >> ChunkPower];
+    uint64_t i = index & ChunkMask;
+    uint64_t start = chunk->start_sample[i];
+    uint64_t end = chunk->end_sample[i];
+
+    start = start > _sample_base ? start - _sample_base : 0;
+    end = end > _sample_base ? end - _sample_base : 0;
+
+    return Annotation(start, end, chunk->format[i],
+                        chunk->type[i], chunk->res_index[i], _status);
+}
+
+void RowData::set_item(uint64_t index, const Annotation &a)
+{
+    AnnotationChunk *chunk = _chunks[index >> ChunkPower];
+    uint64_t i = index & ChunkMask;
+
+    chunk->start_sample[i] = a.start_sample();
+    chunk->end_sample[i] = a.end_sample();
+    chunk->format[i] = a.format();
+    chunk->type[i] = a.type();
+    chunk->res_index[i] = a.res_index();
+}
+
+void RowData::move_item(uint64_t dest, uint64_t src)
+{
+    AnnotationChunk *dc = _chunks[dest >> ChunkPower];
+    AnnotationChunk *sc = _chunks[src >> ChunkPower];
+    uint64_t di = dest & ChunkMask;
+    uint64_t si = src & ChunkMask;
+
+    dc->start_sample[di] = sc->start_sample[si];
+    dc->end_sample[di] = sc->end_sample[si];
+    dc->format[di] = sc->format[si];
+    dc->type[di] = sc->type[si];
+    dc->res_index[di] = sc->res_index[si];
+}
+
+// The count of annotations which start at or before start_sample.
+uint64_t RowData::upper_index(uint64_t start_sample)
+{
+    uint64_t lo = _first_item;
+    uint64_t hi = _item_count;
+
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+
+        if (start_at(mid) <= start_sample)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+void RowData::rebuild_index(uint64_t block)
+{
+    uint64_t block_count = (_item_count + IndexBlockSize - 1) >> IndexBlockPower;
+    _block_max_end.resize(block_count);
+    _block_prefix_end.resize(block_count);
+
+    for (uint64_t b = block; b < block_count; b++)
+    {
+        uint64_t i = b << IndexBlockPower;
+        uint64_t last = min(i + IndexBlockSize, _item_count);
+        uint64_t max_end = 0;
+
+        for (; i < last; i++){
+            max_end = max(max_end, end_at(i));
+        }
+
+        _block_max_end[b] = max_end;
+        _block_prefix_end[b] = (b > 0) ? max(_block_prefix_end[b - 1], max_end) : max_end;
+    }
+}
+
+void RowData::get_annotation_subset(std::vector<pv::data::decode::Annotation> &dest,
 		                        uint64_t start_sample, uint64_t end_sample)
 {  
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+    QReadLocker lock(&_lock);
+
+    start_sample += _sample_base;
+    end_sample += _sample_base;
+
+    // The annotations after hi start behind the period.
+    uint64_t hi = upper_index(end_sample);
+
+    // All the blocks before this one end at or before the period.
+    auto it = std::upper_bound(_block_prefix_end.begin(), _block_prefix_end.end(), start_sample);
+    uint64_t block = (uint64_t)(it - _block_prefix_end.begin());
 
-    for (Annotation *p : _annotations)
+    for (; (block << IndexBlockPower) < hi; block++)
     {
-        if (p->end_sample() > start_sample && p->start_sample() <= end_sample)
+        if (_block_max_end[block] <= start_sample)
+            continue;
+
+        uint64_t last = min((block + 1) << IndexBlockPower, hi);
+
+        for (uint64_t i = block << IndexBlockPower; i < last; i++)
         {
-            dest.push_back(p);
-        }			               
+            if (end_at(i) > start_sample)
+                dest.push_back(make_annotation(i));
+        }
     }
 }
 
 uint64_t RowData::get_annotation_index(uint64_t start_sample)
 {
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
-    uint64_t index = 0;
-
-     for (Annotation *p : _annotations){
-         if (p->start_sample() > start_sample)
-             break;
-         index++;
-     }
-
-    return index;
+    QReadLocker lock(&_lock);
+    return upper_index(start_sample + _sample_base) - _first_item;
 }
 
-bool RowData::push_annotation(Annotation *a)
+bool RowData::push_annotation(const Annotation &a)
 { 
-    assert(a);
+    QWriteLocker lock(&_lock);
+    return append_annotation(a);
+}
 
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+bool RowData::push_annotations(const std::vector<Annotation> &items)
+{
+    QWriteLocker lock(&_lock);
 
+    for (const Annotation &a : items){
+        if (!append_annotation(a))
+            return false;
+    }
+    return true;
+}
+
+bool RowData::append_annotation(const Annotation &a)
+{
     try {
-      _annotations.push_back(a);
-      _item_count = _annotations.size();
-      _max_annotation = max(_max_annotation, a->end_sample() - a->start_sample());
+      uint64_t end = a.end_sample();
+
+      if (_item_count == (uint64_t)_chunks.size() * ChunkSize){
+          AnnotationChunk *chunk = (AnnotationChunk*)malloc(sizeof(AnnotationChunk));
+          if (chunk == NULL)
+              return false;
+          _chunks.push_back(chunk);
+      }
 
-      if (a->end_sample() != a->start_sample()){
+      _status = a.status();
+
+      if (_item_count == 0 || start_at(_item_count - 1) <= a.start_sample())
+      {
+          // The common case, decoders put annotations in order.
+          uint64_t block = _item_count >> IndexBlockPower;
+          set_item(_item_count, a);
+          _item_count++;
+
+          if (block == _block_max_end.size()){
+              uint64_t prefix = _block_prefix_end.empty() ? 0 : _block_prefix_end.back();
+              _block_max_end.push_back(end);
+              _block_prefix_end.push_back(max(prefix, end));
+          }
+          else{
+              _block_max_end[block] = max(_block_max_end[block], end);
+              _block_prefix_end[block] = max(_block_prefix_end[block], end);
+          }
+      }
+      else {
+          // Keep the start samples sorted, it is close to the tail.
+          uint64_t index = upper_index(a.start_sample());
+
+          for (uint64_t i = _item_count; i > index; i--){
+              move_item(i, i - 1);
+          }
+          set_item(index, a);
+          _item_count++;
+          rebuild_index(index >> IndexBlockPower);
+      }
+
+      _max_annotation = max(_max_annotation, a.end_sample() - a.start_sample());
+
+      if (a.end_sample() != a.start_sample()){
         if (_min_annotation == 0){
-            _min_annotation = a->end_sample() - a->start_sample();
+            _min_annotation = a.end_sample() - a.start_sample();
         }
         else{
-            _min_annotation = min(_min_annotation, a->end_sample() - a->start_sample());
+            _min_annotation = min(_min_annotation, a.end_sample() - a.start_sample());
         }
       }
           
@@ -142,10 +321,12 @@ bool RowData::get_annotation(Annotation *ann, uint64_t index)
 {
     assert(ann);
 
-    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+    QReadLocker lock(&_lock);
+
+    index += _first_item;
 
-    if (index < _annotations.size()) {
-        *ann = *_annotations[index]; //clone
+    if (index < _item_count) {
+        *ann = make_annotation(index);
         return true;
     } else {
         return false;
@@ -24,7 +24,7 @@
 #define DSVIEW_PV_DATA_DECODE_ROWDATA_H
 
 #include <vector> 
-#include <mutex>
+#include <QReadWriteLock>
 
 #include "annotation.h"
 
@@ -46,10 +46,15 @@ public:
 
     uint64_t get_annotation_index(uint64_t start_sample);
 
-    bool push_annotation(Annotation *a);
+    bool push_annotation(const Annotation &a);
+
+    /**
+	 * Appends a batch of annotations under one lock.
+	 */
+    bool push_annotations(const std::vector<Annotation> &items);
 
     inline uint64_t get_annotation_size(){
-        return _item_count;
+        return _item_count - _first_item;
     }
 
     bool get_annotation(pv::data::decode::Annotation *ann, uint64_t index);
@@ -57,17 +62,77 @@ public:
      /**
 	 * Extracts sorted annotations between two period into a vector.
 	 */
-	void get_annotation_subset(std::vector<pv::data::decode::Annotation*> &dest,
+	void get_annotation_subset(std::vector<pv::data::decode::Annotation> &dest,
 		                        uint64_t start_sample, uint64_t end_sample);
 
+    /**
+	 * The memory size of the annotation columns and the index.
+	 */
+    uint64_t get_bytes_used();
+
     void clear();
 
+    /**
+	 * The stored samples minus base are the sample indexes of the view.
+	 * Annotations ending at or before base are dropped.
+	 */
+    void set_sample_base(uint64_t base);
+
+private:
+    inline uint64_t start_at(uint64_t index){
+        return _chunks[index >> ChunkPower]->start_sample[index & ChunkMask];
+    }
+
+    inline uint64_t end_at(uint64_t index){
+        return _chunks[index >> ChunkPower]->end_sample[index & ChunkMask];
+    }
+
+    Annotation make_annotation(uint64_t index);
+
+    bool append_annotation(const Annotation &a);
+
+    void set_item(uint64_t index, const Annotation &a);
+
+    void move_item(uint64_t dest, uint64_t src);
+
+    uint64_t upper_index(uint64_t start_sample);
+
+    void rebuild_index(uint64_t block);
+
 private:
+    static const uint64_t ChunkPower = 12;
+    static const uint64_t ChunkSize = 1ULL << ChunkPower;
+    static const uint64_t ChunkMask = ChunkSize - 1;
+
+    // Annotations per index block, the block keeps the max end sample of its items.
+    static const uint64_t IndexBlockSize = 64;
+    static const uint64_t IndexBlockPower = 6;
+
+    // The columns of a chunk, annotations are kept as plain values.
+    struct AnnotationChunk
+    {
+        uint64_t    start_sample[ChunkSize];
+        uint64_t    end_sample[ChunkSize];
+        int         res_index[ChunkSize];
+        short       format[ChunkSize];
+        short       type[ChunkSize];
+    };
+
     uint64_t        _max_annotation;
     uint64_t        _min_annotation;
     uint64_t        _item_count;
-	std::vector<Annotation*> _annotations;
-    static std::mutex _global_visitor_mutex;
+    // Items before this one were dropped, the chunk is released when all its items are.
+    uint64_t        _first_item;
+    uint64_t        _sample_base;
+    // Sorted by start sample.
+    std::vector<AnnotationChunk*> _chunks;
+    std::vector<uint64_t> _block_max_end;
+    // Max end sample of block [0, i], it is not decreasing.
+    std::vector<uint64_t> _block_prefix_end;
+    // All the annotations of a row come from one decoder stack.
+    DecoderStatus   *_status;
+    // The decoder thread appends while the ui reads.
+    QReadWriteLock  _lock;
 };
 
 }
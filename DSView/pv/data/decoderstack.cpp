@@ -217,7 +217,7 @@ int64_t DecoderStack::samples_decoded()
 }
 
 void DecoderStack::get_annotation_subset(
-	std::vector<pv::data::decode::Annotation*> &dest,
+	std::vector<pv::data::decode::Annotation> &dest,
 	const Row &row, uint64_t start_sample,
 	uint64_t end_sample)
 {  
@@ -306,6 +306,17 @@ bool DecoderStack::has_annotations(const Row &row)
         return false;
 }
 
+uint64_t DecoderStack::get_annotation_bytes()
+{
+    uint64_t bytes = 0;
+
+    for (auto it = _rows.begin(); it != _rows.end(); it++) {
+        bytes += (*it).second->get_bytes_used();
+    }
+
+    return bytes;
+}
+
 uint64_t DecoderStack::list_annotation_size()
 {
     std::lock_guard<std::mutex> lock(_output_mutex);
@@ -377,6 +388,7 @@ void DecoderStack::init()
     _no_memory = false;
     _snapshot = NULL;
     _result_count = 0;
+    _loop_window.start(0);
 
     for (auto i = _rows.begin();i != _rows.end(); i++) { 
         (*i).second->clear();
@@ -384,6 +396,19 @@ void DecoderStack::init()
 
     set_mark_index(-1);
 }
+
+bool DecoderStack::update_loop_window(uint64_t sample)
+{
+    const uint64_t shift = _loop_window.shift();
+    const bool ret = _loop_window.update(_snapshot->get_loop_discard_count(), sample);
+
+    if (_loop_window.shift() != shift){
+        for (auto i = _rows.begin();i != _rows.end(); i++) { 
+            (*i).second->set_sample_base(_loop_window.shift());
+        }
+    }
+    return ret;
+}
  
 void DecoderStack::stop_decode_work()
 {  
@@ -485,7 +510,22 @@ void DecoderStack::do_decode_work()
         return;
     }
      
-    execute_decode_stack();   
+    execute_decode_stack();
+
+    // The ring head passed the decoder, the dropped samples can't be decoded any more.
+    while (_loop_window.overrun() && !_stask_stauts->_bStop)
+    {
+        dsv_info("The decoder fell behind the loop buffer, decode again from the ring head.");
+
+        _samples_decoded = 0;
+        _result_count = 0;
+
+        for (auto i = _rows.begin();i != _rows.end(); i++) { 
+            (*i).second->clear();
+        }
+
+        execute_decode_stack();
+    }
 }
 
 uint64_t DecoderStack::get_max_sample_count()
@@ -541,6 +581,14 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
 
     void* lbp_array[35];
 
+    // A live loop capture keeps dropping the ring head, see LoopWindow.
+    bool loop_decode = _session->is_loop_mode() && !_is_capture_end;
+    _loop_window.start(loop_decode ? _snapshot->get_loop_discard_count() : 0);
+
+    if (loop_decode){
+        end_index = UINT64_MAX - 1;
+    }
+
     for (int j =0 ; j < logic_di->dec_num_channels; j++){
         lbp_array[j] = NULL;
     }
@@ -550,6 +598,9 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
         chunk.clear();
         chunk_const.clear();
 
+        if (loop_decode && !update_loop_window(i))
+            break;
+
         if (_is_capture_end)
         {
             if (!bCheckEnd){
@@ -562,30 +613,36 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
                     return;
                 }
 
-                if (end_index >= align_sample_count){
+                if (loop_decode){
+                    // The ring is still now, read the final head position.
+                    if (!update_loop_window(i))
+                        break;
+                    end_index = _loop_window.shift() + align_sample_count - 1;
+                }
+                else if (end_index >= align_sample_count){
                     end_index = align_sample_count - 1;
                     dsv_info("Reset the decode end sample index, new:%llu, old:%llu", 
                         (u64_t)end_index, (u64_t)decode_end);
                 }
 
-                if (i >= align_sample_count){
+                if (i - _loop_window.shift() >= align_sample_count){
                     dsv_info("ERROR: the decoding sample index is out of range.");
                     break;
                 }
             }
         }
-        else if (i >= _snapshot->get_ring_sample_count())
+        else if (i - _loop_window.shift() >= _snapshot->get_ring_sample_count())
         {   
-            // Wait the data is ready.
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            // Wait the data is ready, the timeout keeps the stop flag and the end flag checked.
+            _snapshot->wait_samples(i - _loop_window.shift(), 100);
             continue;
         }
  
-        uint64_t chunk_end = end_index;
+        uint64_t chunk_end = end_index - _loop_window.shift();
+        bool all_const = true;
 
         for (int j =0 ; j < logic_di->dec_num_channels; j++) {
             int sig_index = logic_di->dec_channelmap[j];
-            void *lbp = NULL;
 
             if (sig_index == -1) {
                 chunk.push_back(NULL);
@@ -593,19 +650,14 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
             }
             else {
                 if (_snapshot->has_data(sig_index)) {
-                    const uint8_t *data_ptr = _snapshot->get_samples(i, chunk_end, sig_index, &lbp);
-                    bool flag = _snapshot->get_sample(i, sig_index);
+                    // The block is held until the next one of the channel is taken.
+                    const uint8_t *data_ptr = _snapshot->get_samples(i - _loop_window.shift(), chunk_end, sig_index, &lbp_array[j]);
+                    bool flag = _snapshot->get_sample(i - _loop_window.shift(), sig_index);
                     chunk.push_back(data_ptr);
                     chunk_const.push_back(flag);
 
-                    if (_snapshot->is_able_free() == false)
-                    {
-                        if (lbp_array[j] != lbp){
-                            if (lbp_array[j] != NULL)
-                                _snapshot->free_decode_lpb(lbp_array[j]);
-                            lbp_array[j] = lbp;
-                        }
-                    }
+                    if (data_ptr != NULL)
+                        all_const = false;
                 }
                 else {
                     _error_message = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_DECODERSTACK_DECODE_DATA_ERROR),
@@ -615,6 +667,16 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
             }
         }
 
+        if (loop_decode){
+            // The ring may have moved on while the blocks were looked up, read them again.
+            const uint64_t shift = _loop_window.shift();
+            if (!update_loop_window(i))
+                break;
+            if (_loop_window.shift() != shift)
+                continue;
+            chunk_end += shift;
+        }
+
         if (i > end_index){
             bEndTime = true;
             dsv_info("Decoding data to end.");
@@ -623,7 +685,8 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
 
         if (chunk_end >= end_index)
             chunk_end = end_index + 1;
-        if (chunk_end - i > MaxChunkSize)
+        // Idle leaf blocks are handed over as a whole, the matcher skips them at once.
+        if (!all_const && chunk_end - i > MaxChunkSize)
             chunk_end = i + MaxChunkSize;
 
         bEndTime = (chunk_end > end_index);
@@ -649,13 +712,18 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
         }
 
         decoded_sample_count += chunk_end - i; 
-        _progress = (int)(decoded_sample_count * 100 / end_index);
-        i = chunk_end;   
+        i = chunk_end;
+
+        // The end of a live loop capture is not known, the ring window is.
+        if (loop_decode)
+            _progress = _loop_window.progress(i, _snapshot->get_ring_sample_count());
+        else
+            _progress = (int)(decoded_sample_count * 100 / end_index);
  
         //use mutex
         {
             std::lock_guard<std::mutex> lock(_output_mutex);
-            _samples_decoded = i - decode_start + 1;
+            _samples_decoded = i - _loop_window.shift() - decode_start + 1;
         }
 
         if ((i - last_cnt) > notify_cnt) {
@@ -664,6 +732,11 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
         }
     }
 
+    for (int j = 0; j < logic_di->dec_num_channels; j++){
+        if (lbp_array[j] != NULL)
+            _snapshot->free_decode_lpb(lbp_array[j]);
+    }
+
     _progress = 100;
     _is_decoding = false;
     
@@ -688,6 +761,8 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
     }
 
     dsv_info("Decoded sample count:%llu", decoded_sample_count);
+    dsv_info("Annotation count:%llu, memory used:%llu bytes",
+        (u64_t)_result_count, (u64_t)get_annotation_bytes());
 }
 
 void DecoderStack::execute_decode_stack()
@@ -744,7 +819,7 @@ void DecoderStack::execute_decode_stack()
 	srd_session_metadata_set(session, SRD_CONF_SAMPLERATE,
 		g_variant_new_uint64((uint64_t)_samplerate));
 
-	srd_pd_output_callback_add(
+	srd_pd_output_batch_callback_add(
                     session, 
                     SRD_OUTPUT_ANN,
 		            DecoderStack::annotation_callback,
@@ -753,7 +828,9 @@ void DecoderStack::execute_decode_stack()
     char *error = NULL;
     if (srd_session_start(session, &error) == SRD_OK){
        //need a lot time
+        _snapshot->decode_begin();
         decode_data(decode_start, decode_end, session);
+        _snapshot->decode_end();
     }
     else if (error != NULL){
         _error_message = QString::fromLocal8Bit(error);
@@ -780,10 +857,10 @@ uint64_t DecoderStack::sample_rate()
     return _samplerate;
 }
 
-//the decode callback, annotation object will be create
-void DecoderStack::annotation_callback(srd_proto_data *pdata, void *self)
+//the decode callback, a batch of annotation objects will be create
+void DecoderStack::annotation_callback(srd_proto_data *pdata_list, int count, void *self)
 {
-	assert(pdata);
+	assert(pdata_list);
 	assert(self);
 
     struct decode_task_status *st = (decode_task_status*)self;
@@ -803,42 +880,83 @@ void DecoderStack::annotation_callback(srd_proto_data *pdata, void *self)
         return;
     }
 
-    Annotation *a = new Annotation(pdata, d->_decoder_status);
-    if (a == NULL){
-        d->_no_memory = true;
-        return;     
+    // Group the batch by row, so every row is locked once.
+    vector<pair<RowData*, vector<Annotation>>> row_batches;
+    const srd_decoder *last_decc = NULL;
+    int last_format = -1;
+    vector<Annotation> *dest = NULL;
+
+    for (int i = 0; i < count; i++)
+    {
+        srd_proto_data *const pdata = &pdata_list[i];
+        Annotation a(pdata, d->_decoder_status);
+
+        assert(pdata->pdo);
+        assert(pdata->pdo->di);
+        const srd_decoder *const decc = pdata->pdo->di->decoder;
+        assert(decc);
+
+        if (dest == NULL || decc != last_decc || a.format() != last_format)
+        {
+            RowData *row_data = d->find_row_data(decc, a.format());
+            if (row_data == NULL){
+                // Drop this one, the next annotation looks its row up again.
+                dest = NULL;
+                continue;
+            }
+
+            dest = NULL;
+            for (auto &b : row_batches){
+                if (b.first == row_data){
+                    dest = &b.second;
+                    break;
+                }
+            }
+            if (dest == NULL){
+                row_batches.push_back(make_pair(row_data, vector<Annotation>()));
+                dest = &row_batches.back().second;
+            }
+            last_decc = decc;
+            last_format = a.format();
+        }
+
+        dest->push_back(a);
     }
-    d->_result_count++;
 
-	// Find the row
-	assert(pdata->pdo);
-	assert(pdata->pdo->di);
-	const srd_decoder *const decc = pdata->pdo->di->decoder;
-	assert(decc);
+	// Add the annotations
+    for (auto &b : row_batches)
+    {
+        if (!b.first->push_annotations(b.second)){
+            d->_no_memory = true;
+            break;
+        }
+        d->_result_count += b.second.size();
+    }
+}
 
-    auto row_iter = d->_rows.end();
+RowData* DecoderStack::find_row_data(const srd_decoder *decc, int format)
+{
+    auto row_iter = _rows.end();
 	
 	// Try looking up the sub-row of this class
 	const map<pair<const srd_decoder*, int>, Row>::const_iterator r =
-        d->_class_rows.find(make_pair(decc, a->format()));
-	if (r != d->_class_rows.end())
-        row_iter = d->_rows.find((*r).second);
+        _class_rows.find(make_pair(decc, format));
+	if (r != _class_rows.end())
+        row_iter = _rows.find((*r).second);
 	else
 	{
 		// Failing that, use the decoder as a key
-        row_iter = d->_rows.find(Row(decc));
+        row_iter = _rows.find(Row(decc));
 	}
 
-    assert(row_iter != d->_rows.end());
-    if (row_iter == d->_rows.end()) {
-        dsv_err("Unexpected annotation: decoder = 0x%x, format = %d", (void*)decc, a->format());
+    assert(row_iter != _rows.end());
+    if (row_iter == _rows.end()) {
+        dsv_err("Unexpected annotation: decoder = 0x%x, format = %d", (void*)decc, format);
         assert(0);
-        return;
+        return NULL;
     }
 
-	// Add the annotation 
-    if (!(*row_iter).second->push_annotation(a))
-        d->_no_memory = true; 
+    return (*row_iter).second;
 }
  
 void DecoderStack::frame_ended()
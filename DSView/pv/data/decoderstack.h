@@ -33,6 +33,7 @@
 #include "decode/row.h" 
 #include "../data/signaldata.h"
 #include "decode/decoderstatus.h"
+#include "decode/loopwindow.h"
  
 
 namespace DecoderStackTest {
@@ -109,7 +110,7 @@ public:
 	 * Extracts sorted annotations between two period into a vector.
 	 */
 	void get_annotation_subset(
-		std::vector<pv::data::decode::Annotation*> &dest,
+		std::vector<pv::data::decode::Annotation> &dest,
 		const decode::Row &row, uint64_t start_sample,
 		uint64_t end_sample);
 
@@ -125,6 +126,7 @@ public:
     bool has_annotations(const decode::Row &row);
     uint64_t list_annotation_size();
     uint64_t list_annotation_size(uint16_t row_index);
+    uint64_t get_annotation_bytes();
 
 
     bool list_annotation(decode::Annotation *ann,
@@ -190,7 +192,9 @@ public:
 private:
     void decode_data(const uint64_t decode_start, const uint64_t decode_end, srd_session *const session);
 	void execute_decode_stack();
-	static void annotation_callback(srd_proto_data *pdata, void *self);
+	static void annotation_callback(srd_proto_data *pdata_list, int count, void *self);
+    decode::RowData* find_row_data(const srd_decoder *decc, int format);
+    bool update_loop_window(uint64_t sample);
     void do_decode_work();
   
 signals:
@@ -223,6 +227,7 @@ private:
     int             _progress;
     bool            _is_decoding;
     uint64_t        _result_count;
+    decode::LoopWindow _loop_window;
 
 	friend class DecoderStackTest::TwoDecoderStack;
 };
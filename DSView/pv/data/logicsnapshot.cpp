@@ -24,12 +24,20 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
  
 #include "logicsnapshot.h"
 #include "../dsvdef.h"
 #include "../log.h"
 #include "../utility/array.h"
+#include "../utility/bittranspose.h"
 #include "../log.h"
+#include <ds_types.h>
 
 using namespace std;
 
@@ -58,12 +66,37 @@ LogicSnapshot::LogicSnapshot() :
     _total_sample_count = 0;
     _is_loop = false;
     _loop_offset = 0;
-    _able_free = true;
+    _loop_discarded = 0;
     _is_search_stop = false;
+    _decode_readers = 0;
+    _block_loaded = false;
+    _data_seq = 0;
+    _pool_limit = 0;
+    _pool_blocks = 0;
+    _pool_hits = 0;
+    _pool_misses = 0;
+    _pool_huge_page = false;
+    _fill_sample_count = 0;
+    _fill_index = 0;
+    _mipmap_index = 0;
+    _mipmap_lbp = NULL;
+    _mipmap_dropped = false;
+    _mipmap_exit = false;
 }
 
 LogicSnapshot::~LogicSnapshot()
 {
+    if (_mipmap_thread.joinable()){
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _mipmap_exit = true;
+        }
+        _mipmap_cond.notify_one();
+        _mipmap_thread.join();
+    }
+
+    release_mapped_files();
+    release_leaf_pool();
 }
 
 void LogicSnapshot::free_data()
@@ -73,8 +106,8 @@ void LogicSnapshot::free_data()
     for(auto& iter : _ch_data) {
         for(auto& iter_rn : iter) {
             for (unsigned int k = 0; k < Scale; k++){
-                if (iter_rn.lbp[k] != NULL)
-                    free(iter_rn.lbp[k]);
+                if (iter_rn.lbp[k] != NULL && !is_mapped_block(iter_rn.lbp[k]))
+                    free_leaf_block(iter_rn.lbp[k]);
             }
         }
         std::vector<struct RootNode> void_vector;
@@ -84,50 +117,141 @@ void LogicSnapshot::free_data()
     _sample_count = 0;
 
     for(void *p : _free_block_list){
-        free(p);
+        free_leaf_block(p);
     }
     _free_block_list.clear();
+
+    release_mapped_files();
+    release_leaf_pool();
+}
+
+bool LogicSnapshot::is_mapped_block(void *lbp)
+{
+    for (GMappedFile *file : _mapped_files){
+        const char *begin = g_mapped_file_get_contents(file);
+        const char *end = begin + g_mapped_file_get_length(file);
+
+        if ((const char*)lbp >= begin && (const char*)lbp < end)
+            return true;
+    }
+    return false;
+}
+
+void LogicSnapshot::release_mapped_files()
+{
+    for (GMappedFile *file : _mapped_files){
+        g_mapped_file_unref(file);
+    }
+    _mapped_files.clear();
+}
+
+bool LogicSnapshot::copy_mapped_blocks()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_mapped_files.empty())
+        return true;
+
+    // A decoder holds the block address until it lets the block go.
+    for (auto &ref : _decode_lbp_refs){
+        if (is_mapped_block(ref.first)){
+            dsv_err("LogicSnapshot::copy_mapped_blocks, the block is being decoded.");
+            return false;
+        }
+    }
+
+    for(auto& iter : _ch_data) {
+        for(auto& iter_rn : iter) {
+            for (unsigned int k = 0; k < Scale; k++){
+                if (iter_rn.lbp[k] == NULL || !is_mapped_block(iter_rn.lbp[k]))
+                    continue;
+
+                void *lbp = take_leaf_block();
+                if (lbp == NULL){
+                    _memory_failed = true;
+                    dsv_err("LogicSnapshot::copy_mapped_blocks, Malloc memory failed!");
+                    return false;
+                }
+                memcpy(lbp, iter_rn.lbp[k], LeafBlockSpace);
+                iter_rn.lbp[k] = lbp;
+            }
+        }
+    }
+
+    release_mapped_files();
+    return true;
+}
+
+bool LogicSnapshot::has_mapped_blocks()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_mapped_files.empty();
 }
 
 void LogicSnapshot::init()
 {
+    std::lock_guard<std::mutex> pass_lock(_mipmap_mutex);
     std::lock_guard<std::mutex> lock(_mutex);
     init_all(); 
+    notify_data_changed();
 }
 
 void LogicSnapshot::init_all()
 {
     _sample_count = 0;
     _ring_sample_count = 0;
+    _fill_sample_count = 0;
+    _fill_index = 0;
+    _mipmap_index = 0;
     _byte_fraction = 0;
     _ch_fraction = 0;
     _dest_ptr = NULL;
     _memory_failed = false;
     _last_ended = true;
     _loop_offset = 0;
-    _able_free = true;
+    _loop_discarded = 0;
 }
 
 void LogicSnapshot::clear()
 {
+    std::lock_guard<std::mutex> pass_lock(_mipmap_mutex);
     std::lock_guard<std::mutex> lock(_mutex);
     free_data();
     init_all();
+    notify_data_changed();
 
     _free_count = 0;
 }
 
-void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total_sample_count, GSList *channels, bool able_free)
+void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total_sample_count, GSList *channels)
 {
-    bool channel_changed = false;
-    uint16_t channel_num = 0;
-    _able_free = able_free;
-    _lst_free_block_index = 0;
+    start_mipmap_worker();
 
-    for(void *p : _free_block_list){
-        free(p);
+    {
+        // Wait for the pass on the old data to end.
+        std::lock_guard<std::mutex> pass_lock(_mipmap_mutex);
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _lst_free_block_index = 0;
+        _pool_hits = 0;
+        _pool_misses = 0;
+
+        for(void *p : _free_block_list){
+            release_leaf_block(p);
+        }
+        _free_block_list.clear();
+
+        init_channels(total_sample_count, channels);
     }
-    _free_block_list.clear();
+
+    append_payload(logic);
+    _last_ended = false;
+}
+
+void LogicSnapshot::init_channels(uint64_t total_sample_count, GSList *channels)
+{
+    bool channel_changed = false;
+    uint16_t channel_num = 0;
 
     for (const GSList *l = channels; l; l = l->next) {
         sr_channel *const probe = (sr_channel*)l->data;
@@ -142,7 +266,8 @@ void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total
     if (total_sample_count != _total_sample_count
         || channel_num != _channel_num
         || channel_changed
-        || _is_loop) {
+        || _is_loop
+        || _block_loaded) {
 
         free_data();
         _ch_index.clear();
@@ -166,6 +291,7 @@ void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total
                     rn.tog = 0;
                     rn.first = 0;
                     rn.last = 0;
+                    rn.stat = 0;
                     memset(rn.lbp, 0, sizeof(rn.lbp));
                     root_vector.push_back(rn);
                 }
@@ -179,6 +305,13 @@ void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total
             dsv_info("ERROR: all channels disalbed");
             assert(0);
         }
+
+        // Fault the first blocks in before the data arrives.
+        uint64_t leaf_count = (_total_sample_count + LeafBlockSamples - 1) / LeafBlockSamples;
+        if (_is_loop)
+            leaf_count += 2 * RootScale;
+        _pool_limit = min(leaf_count, PoolBlocksPerChannel) * _channel_num;
+        reserve_leaf_blocks(_pool_limit);
     }
     else {
         for(auto& iter : _ch_data) {
@@ -186,10 +319,13 @@ void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total
                 iter_rn.tog = 0;
                 iter_rn.first = 0;
                 iter_rn.last = 0;
+                iter_rn.stat = 0;
 
+                // The samples are written again, as in alloc_leaf_block().
                 for (int j=0; j<64; j++){
                     if (iter_rn.lbp[j] != NULL)
-                        memset(iter_rn.lbp[j], 0, LeafBlockSpace);
+                        memset((uint8_t*)iter_rn.lbp[j] + LeafBlockSamples / 8, 0,
+                               LeafBlockSpace - LeafBlockSamples / 8);
                 }
             }
         }
@@ -199,16 +335,118 @@ void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total
 
     _sample_count = 0;
     _ring_sample_count = 0;
+    _fill_sample_count = 0;
+    _fill_index = 0;
+    _mipmap_index = 0;
 
     for (unsigned int i = 0; i < _channel_num; i++) {
         _last_sample[i] = 0;
         _last_calc_count[i] = 0;
-        _cur_ref_block_indexs[i].root_index = 0;
-        _cur_ref_block_indexs[i].lbp_index = 0;
     }
 
-    append_payload(logic);
-    _last_ended = false;
+    _block_loaded = false;
+}
+
+bool LogicSnapshot::first_block(const sr_datafeed_logic_block &block, uint64_t total_sample_count, GSList *channels)
+{
+    {
+        std::lock_guard<std::mutex> pass_lock(_mipmap_mutex);
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _lst_free_block_index = 0;
+
+        for(void *p : _free_block_list){
+            release_leaf_block(p);
+        }
+        _free_block_list.clear();
+
+        init_channels(total_sample_count, channels);
+        _block_loaded = true;
+        _last_ended = false;
+    }
+
+    return append_block(block);
+}
+
+bool LogicSnapshot::append_block(const sr_datafeed_logic_block &block)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uint64_t index0 = block.index / RootScale;
+    const uint64_t index1 = block.index % RootScale;
+
+    if (block.order >= _channel_num || index0 >= _ch_data[block.order].size()){
+        dsv_err("LogicSnapshot::append_block, block is out of range.");
+        return false;
+    }
+    if (block.data_len > LeafBlockSamples / 8){
+        dsv_err("LogicSnapshot::append_block, invalid block length.");
+        return false;
+    }
+
+    struct RootNode &rn = _ch_data[block.order][index0];
+    const uint64_t pos_mask = 1ULL << index1;
+
+    if (block.data == NULL){
+        if (block.level){
+            rn.first |= pos_mask;
+            rn.last |= pos_mask;
+        }
+    }
+    else {
+        if (block.size != LeafBlockSpace
+            || block.scale_power != ScalePower
+            || block.scale_level != ScaleLevel){
+            dsv_err("LogicSnapshot::append_block, the mipmap layout is different.");
+            return false;
+        }
+
+        void *lbp = NULL;
+
+        if (((uintptr_t)block.data & 7) == 0){
+            // Use the mapped block directly, keep the file until the data is freed.
+            if (std::find(_mapped_files.begin(), _mapped_files.end(), block.file) == _mapped_files.end()){
+                _mapped_files.push_back(g_mapped_file_ref(block.file));
+            }
+            lbp = (void*)block.data;
+        }
+        else {
+            lbp = take_leaf_block();
+            if (lbp == NULL){
+                _memory_failed = true;
+                dsv_err("LogicSnapshot::append_block, Malloc memory failed!");
+                return false;
+            }
+            memcpy(lbp, block.data, LeafBlockSpace);
+        }
+
+        if (rn.lbp[index1] != NULL && !is_mapped_block(rn.lbp[index1]))
+            release_leaf_block(rn.lbp[index1]);
+        rn.lbp[index1] = lbp;
+
+        const uint64_t *data = (const uint64_t*)lbp;
+        const uint64_t *level3 = data + LevelOffset[ScaleLevel - 1];
+
+        if (data[0] & LSB)
+            rn.first |= pos_mask;
+        if (data[LeafBlockSamples / Scale - 1] & MSB)
+            rn.last |= pos_mask;
+        if (*level3 != 0){
+            rn.tog |= pos_mask;
+            calc_leaf_stats(data, rn.stats[index1]);
+            rn.stat |= pos_mask;
+        }
+    }
+
+    uint64_t end_sample = block.index * LeafBlockSamples + block.data_len * 8;
+    end_sample = min(end_sample, (uint64_t)_total_sample_count);
+
+    if (end_sample > _ring_sample_count){
+        _ring_sample_count = end_sample;
+        _sample_count = end_sample;
+    }
+
+    return true;
 }
 
 void LogicSnapshot::append_payload(const sr_datafeed_logic &logic)
@@ -263,7 +501,7 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
         }
     }
  
-    _ring_sample_count += _loop_offset;
+    _fill_sample_count += _loop_offset;
  
     // bit align
     while ((_ch_fraction != 0 || _byte_fraction != 0) && len > 0) 
@@ -278,33 +516,29 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
         while (_byte_fraction != 0 && len > 0);
 
         if (_byte_fraction == 0) {
-            index0 = _ring_sample_count / LeafBlockSamples / RootScale;
-            index1 = (_ring_sample_count / LeafBlockSamples) % RootScale;
-            offset = (_ring_sample_count % LeafBlockSamples) / 8;
+            index0 = _fill_sample_count / LeafBlockSamples / RootScale;
+            index1 = (_fill_sample_count / LeafBlockSamples) % RootScale;
+            offset = (_fill_sample_count % LeafBlockSamples) / 8;
 
             //switch to the next channel.
             _ch_fraction = (_ch_fraction + 1) % _channel_num;
 
             lbp = _ch_data[_ch_fraction][index0].lbp[index1];
             if (lbp == NULL){
-                lbp = malloc(LeafBlockSpace);
+                lbp = alloc_leaf_block();
                 if (lbp == NULL){
                     dsv_err("LogicSnapshot::append_cross_payload, Malloc memory failed!");
                     return;
                 }
                 _ch_data[_ch_fraction][index0].lbp[index1] = lbp;
-                memset(lbp, 0, LeafBlockSpace);
             }
 
             _dest_ptr = (uint8_t*)lbp + offset;
 
             // The last channel is read end, so the channel index switch to first.
             if (_ch_fraction == 0){
-                _ring_sample_count += Scale;
+                _fill_sample_count += Scale;
 
-                if (_ring_sample_count % LeafBlockSamples == 0){
-                    calc_mipmap(_channel_num - 1, index0, index1, LeafBlockSamples, true);
-                }                                
                 break;
             }
         }
@@ -313,169 +547,125 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
     // append data 
     assert(_ch_fraction == 0);
     assert(_byte_fraction == 0);
-    assert(_ring_sample_count % Scale == 0);
-
-    uint64_t align_sample_count = _ring_sample_count;
-    uint64_t *read_ptr = (uint64_t*)data_src_ptr;
-    void *end_read_ptr = (uint8_t*)data_src_ptr + len;
-  
-    uint64_t filled_sample = align_sample_count % LeafBlockSamples;
-    uint64_t old_filled_sample = filled_sample;     
-    uint64_t* chans_read_addr[CHANNEL_MAX_COUNT];
- 
-    for (unsigned int i = 0; i < _channel_num; i++){
-        chans_read_addr[i] = (uint64_t*)data_src_ptr + i; 
-    }
-    
-    uint16_t fill_chan_index = 0;
-    uint16_t last_chan_index = 0;
-    index0 =  align_sample_count / LeafBlockSamples / RootScale;
-    index1 = (align_sample_count / LeafBlockSamples) % RootScale;
-    offset =  align_sample_count % LeafBlockSamples;
+    assert(_fill_sample_count % Scale == 0);
 
-    if (index0 >= _ch_data[0].size()){
-        assert(false);
-    }
-    
-    lbp = _ch_data[fill_chan_index][index0].lbp[index1];
-    if (lbp == NULL){
-        lbp = malloc(LeafBlockSpace);
-        if (lbp == NULL){
-            dsv_err("LogicSnapshot::append_cross_payload, Malloc memory failed!");
-            return;
-        }
-        _ch_data[fill_chan_index][index0].lbp[index1] = lbp;
-        memset(lbp, 0, LeafBlockSpace);
-    }
+    uint64_t align_sample_count = _fill_sample_count;
+    const uint64_t *read_ptr = (const uint64_t*)data_src_ptr;
+    const uint64_t row_bytes = 8 * _channel_num;
+    uint64_t rows = len / row_bytes;
+    const uint64_t split_bytes = rows * row_bytes;
+    uint64_t* chans_write_addr[CHANNEL_MAX_COUNT];
 
-    uint64_t *write_ptr = (uint64_t*)lbp + offset / Scale;
+    len -= split_bytes;
 
-    while (len >= 8)
-    {     
-        *write_ptr++ = *read_ptr;
-        read_ptr += _channel_num;
-        len -= 8;
-        filled_sample += Scale;
+    // Split the whole rows, one leaf block per channel at a time.
+    while (rows > 0)
+    {
+        index0 =  align_sample_count / LeafBlockSamples / RootScale;
+        index1 = (align_sample_count / LeafBlockSamples) % RootScale;
+        offset =  align_sample_count % LeafBlockSamples;
 
-        last_chan_index++;
-        if (last_chan_index == _channel_num){
-            last_chan_index = 0;
+        if (index0 >= _ch_data[0].size()){
+            assert(false);
         }
-  
-        if (filled_sample == LeafBlockSamples)
-        {
-            calc_mipmap(fill_chan_index, index0, index1, LeafBlockSamples, true);
-
-            chans_read_addr[fill_chan_index] = read_ptr; //Save the current read position.
-            fill_chan_index = (fill_chan_index + 1) % _channel_num; //Switch to the next channel index.
-            
-            //The last channel's data read ends, update the align sample count.
-            if (fill_chan_index == 0){
-                align_sample_count += (filled_sample - old_filled_sample);
-            }
-
-            index0 =  align_sample_count / LeafBlockSamples / RootScale;
-            index1 = (align_sample_count / LeafBlockSamples) % RootScale;
-            offset =  align_sample_count % LeafBlockSamples;
-            filled_sample = align_sample_count % LeafBlockSamples;
-            old_filled_sample = filled_sample;
 
-            lbp = _ch_data[fill_chan_index][index0].lbp[index1];
+        for (unsigned int i = 0; i < _channel_num; i++)
+        {
+            lbp = _ch_data[i][index0].lbp[index1];
             if (lbp == NULL){
-                lbp = malloc(LeafBlockSpace);
+                lbp = alloc_leaf_block();
                 if (lbp == NULL){
                     dsv_err("LogicSnapshot::append_cross_payload, Malloc memory failed!");
                     return;
                 }
-                _ch_data[fill_chan_index][index0].lbp[index1] = lbp;
-                memset(lbp, 0, LeafBlockSpace);
-            }
-
-            write_ptr = (uint64_t*)lbp + offset / Scale;
-            read_ptr = chans_read_addr[fill_chan_index];
-        } 
-        else if (read_ptr >= end_read_ptr) 
-        {  
-            calc_mipmap(fill_chan_index, index0, index1, filled_sample, false);
-
-            fill_chan_index = (fill_chan_index + 1) % _channel_num;    
-
-            if (fill_chan_index == 0){
-                align_sample_count += (filled_sample - old_filled_sample);
+                _ch_data[i][index0].lbp[index1] = lbp;
             }
+            chans_write_addr[i] = (uint64_t*)lbp + offset / Scale;
+        }
 
-            index0 =  align_sample_count / LeafBlockSamples / RootScale;
-            index1 = (align_sample_count / LeafBlockSamples) % RootScale;
-            offset =  align_sample_count % LeafBlockSamples;
-            filled_sample = align_sample_count % LeafBlockSamples;
-            old_filled_sample = filled_sample;
-
-            lbp = _ch_data[fill_chan_index][index0].lbp[index1];
-            if (lbp == NULL){
-                lbp = malloc(LeafBlockSpace);
-                if (lbp == NULL){
-                    dsv_err("LogicSnapshot::append_cross_payload, Malloc memory failed!");
-                    return;
-                }
-                _ch_data[fill_chan_index][index0].lbp[index1] = lbp;
-                memset(lbp, 0, LeafBlockSpace);
-            }
+        uint64_t block_rows = min(rows, (LeafBlockSamples - offset) / Scale);
+        bits::split_words(read_ptr, block_rows, _channel_num, chans_write_addr);
 
-            write_ptr = (uint64_t*)lbp + offset / Scale;   
-            read_ptr = chans_read_addr[fill_chan_index];
-        }
+        read_ptr += block_rows * _channel_num;
+        rows -= block_rows;
+        align_sample_count += block_rows * Scale;
     }
 
-    _ring_sample_count = align_sample_count;
-    _ring_sample_count -= _loop_offset;
+    index0 =  align_sample_count / LeafBlockSamples / RootScale;
+    index1 = (align_sample_count / LeafBlockSamples) % RootScale;
+    offset =  align_sample_count % LeafBlockSamples;
+
+    _fill_sample_count = align_sample_count;
+    _fill_sample_count -= _loop_offset;
 
     if (align_sample_count > _total_sample_count){        
         _loop_offset = align_sample_count - _total_sample_count; 
-        _ring_sample_count = _total_sample_count; 
+        _fill_sample_count = _total_sample_count; 
     }
 
-    _ch_fraction = last_chan_index;
+    // The worker builds the mipmap up to here.
+    _fill_index = align_sample_count + _loop_discarded;
+    update_ring_sample_count();
+    _mipmap_cond.notify_one();
 
-    lbp = _ch_data[_ch_fraction][index0].lbp[index1];
-    if (lbp == NULL){
-        lbp = malloc(LeafBlockSpace);
+    // The last row is partial, its whole words go to the first channels.
+    _ch_fraction = len / 8;
+
+    for (unsigned int i = 0; i <= _ch_fraction; i++)
+    {
+        lbp = _ch_data[i][index0].lbp[index1];
         if (lbp == NULL){
-            dsv_err("LogicSnapshot::append_cross_payload, Malloc memory failed!");
-            return;
+            lbp = alloc_leaf_block();
+            if (lbp == NULL){
+                dsv_err("LogicSnapshot::append_cross_payload, Malloc memory failed!");
+                return;
+            }
+            _ch_data[i][index0].lbp[index1] = lbp;
         }
-        _ch_data[_ch_fraction][index0].lbp[index1] = lbp;
-        memset(lbp, 0, LeafBlockSpace);
+
+        if (i < _ch_fraction)
+            *((uint64_t*)lbp + offset / Scale) = read_ptr[i];
     }
 
+    len -= _ch_fraction * 8;
     _dest_ptr = (uint8_t*)lbp + offset / 8;  
  
     if (len > 0){
-        uint8_t *src_ptr = (uint8_t*)end_read_ptr - len;
+        const uint8_t *src_ptr = (const uint8_t*)(read_ptr + _ch_fraction);
         _byte_fraction += len;
 
         while (len > 0){
             *_dest_ptr++ = *src_ptr++;
             len--;
         }
-    }   
+    }
 }
 
 void LogicSnapshot::capture_ended()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::lock_guard<std::mutex> pass_lock(_mipmap_mutex);
+    std::unique_lock<std::mutex> lock(_mutex);
 
     Snapshot::capture_ended();  
 
-    _sample_count = _ring_sample_count;
-    _ring_sample_count += _loop_offset;
+    dsv_info("Leaf block pool, hits:%llu, misses:%llu, resident:%llu bytes",
+        (u64_t)_pool_hits, (u64_t)_pool_misses, (u64_t)(_pool_blocks * LeafBlockSpace));
+
+    // Finish what the worker has not done yet.
+    if (!_block_loaded)
+        calc_mipmap_pass(lock, false);
+
+    _sample_count = _fill_sample_count;
+    _fill_sample_count += _loop_offset;
     
-    uint64_t index0 = _ring_sample_count / LeafBlockSamples / RootScale;
-    uint64_t index1 = (_ring_sample_count / LeafBlockSamples) % RootScale;
-    uint64_t offset = (_ring_sample_count % LeafBlockSamples) / 8;
+    uint64_t index0 = _fill_sample_count / LeafBlockSamples / RootScale;
+    uint64_t index1 = (_fill_sample_count / LeafBlockSamples) % RootScale;
+    uint64_t offset = (_fill_sample_count % LeafBlockSamples) / 8;
 
-    _ring_sample_count -= _loop_offset;
+    _fill_sample_count -= _loop_offset;
 
-    if (offset > 0)
+    // Loaded blocks were saved with the tail cleared and the mipmap done.
+    if (offset > 0 && !_block_loaded)
     {
         for (unsigned int chan=0; chan<_channel_num; chan++)
         { 
@@ -490,14 +680,19 @@ void LogicSnapshot::capture_ended()
                 *ptr++ = 0;
             }
 
-            calc_mipmap(chan, index0, index1, offset * 8, true);
+            LeafStats stats;
+            bool toggled = calc_mipmap(chan, _ch_data[chan][index0].lbp[index1], offset * 8, true, stats);
+            publish_mipmap(chan, index0, index1, toggled, true, stats);
         }  
     }
+
+    notify_data_changed();
 }
 
-void LogicSnapshot::calc_mipmap(unsigned int order, uint8_t index0, uint8_t index1, uint64_t samples, bool isEnd)
+// Build the toggle levels of the samples before the count, the feed only writes
+// behind them, so it runs without the lock. Returns true if the block has a toggle.
+bool LogicSnapshot::calc_mipmap(unsigned int order, void *lbp, uint64_t samples, bool isEnd, struct LeafStats &stats)
 {
-    void *lbp = _ch_data[order][index0].lbp[index1];
     void *level1_ptr = (uint8_t*)lbp + LeafBlockSamples / 8;
     void *level2_ptr = (uint8_t*)level1_ptr + LeafBlockSamples / Scale / 8;
     void *level3_ptr = (uint8_t*)level2_ptr + LeafBlockSamples / Scale / Scale / 8;
@@ -573,32 +768,102 @@ void LogicSnapshot::calc_mipmap(unsigned int order, uint8_t index0, uint8_t inde
         src_ptr++;
     }  
 
+    const bool toggled = *((uint64_t*)level3_ptr) != 0;
+
+    if (toggled && isEnd)
+        calc_leaf_stats((uint64_t*)lbp, stats);
+
+    if (isEnd)
+        _last_calc_count[order] = 0;
+    else
+        _last_calc_count[order] = samples;
+
+    return toggled;
+} 
+
+// Make the levels built by calc_mipmap() visible to the readers, call it with the mutex held.
+void LogicSnapshot::publish_mipmap(unsigned int order, uint64_t index0, uint64_t index1,
+                        bool toggled, bool isEnd, const struct LeafStats &stats)
+{
+    struct RootNode &rn = _ch_data[order][index0];
+    void *lbp = rn.lbp[index1];
+    const uint64_t pos_mask = 1ULL << index1;
+
     if ((*((uint64_t*)lbp) & LSB) != 0)
-        _ch_data[order][index0].first |= 1ULL << index1;
+        rn.first |= pos_mask;
 
     if ((*((uint64_t*)lbp + LeafBlockSamples / Scale - 1) & MSB) != 0)
-        _ch_data[order][index0].last |= 1ULL << index1;
+        rn.last |= pos_mask;
+
+    if (toggled){
+        rn.tog |= pos_mask;
 
-    if (*((uint64_t*)level3_ptr) != 0){
-        _ch_data[order][index0].tog |= 1ULL << index1;
+        if (isEnd){
+            rn.stats[index1] = stats;
+            rn.stat |= pos_mask;
+        }
     }
     else if (isEnd){
-        uint64_t ref_root = _cur_ref_block_indexs[order].root_index;
-        uint64_t ref_lbp  = _cur_ref_block_indexs[order].lbp_index;
-
-        if (_able_free || index0 > ref_root || (index0 == ref_root && index1 > ref_lbp))
-            free(_ch_data[order][index0].lbp[index1]);
-        else
-            _free_block_list.push_back(_ch_data[order][index0].lbp[index1]);
+        free_leaf_block_later(lbp);
 
-        _ch_data[order][index0].lbp[index1] = NULL;
+        rn.lbp[index1] = NULL;
     }
+}
 
-    if (isEnd)
-        _last_calc_count[order] = 0;
-    else
-        _last_calc_count[order] = samples;
-} 
+void LogicSnapshot::calc_leaf_stats(const uint64_t *src_ptr, struct LeafStats &st)
+{
+    const uint64_t *level1_ptr = src_ptr + LeafBlockSamples / Scale;
+    uint64_t last = *src_ptr & LSB;
+    uint64_t run_start = 0;
+    bool run_whole = false;
+
+    memset(&st, 0, sizeof(st));
+
+    for (uint64_t w = 0; w < LeafBlockSamples / Scale; w++)
+    {
+        const uint64_t word = src_ptr[w];
+        st.ones += popcount64(word);
+
+        // The level 1 bit of the word is clear when it equals the last sample before it.
+        if ((level1_ptr[w >> ScalePower] & (1ULL << (w & LevelMask[0]))) == 0){
+            last = word & MSB ? 1 : 0;
+            continue;
+        }
+
+        uint64_t edges = word ^ ((word << 1) | last);
+        st.edges += popcount64(edges);
+
+        while (edges) {
+            const uint8_t pos = bsf_folded(edges);
+            const uint64_t index = (w << ScalePower) + pos;
+            edges &= edges - 1;
+
+            if (run_whole) {
+                const uint32_t width = index - run_start;
+
+                if (((word >> pos) & 1) == 0) {
+                    if (st.min_high == 0 || width < st.min_high)
+                        st.min_high = width;
+                    st.max_high = max(st.max_high, width);
+                }
+                else {
+                    if (st.min_low == 0 || width < st.min_low)
+                        st.min_low = width;
+                    st.max_low = max(st.max_low, width);
+                }
+            }
+            else {
+                st.first_edge = index;
+            }
+
+            run_start = index;
+            run_whole = true;
+        }
+
+        st.last_edge = run_start;
+        last = word & MSB ? 1 : 0;
+    }
+}
 
 const uint8_t *LogicSnapshot::get_samples(uint64_t start_sample, uint64_t &end_sample, int sig_index, void **lbp)
 {  
@@ -658,11 +923,17 @@ const uint8_t *LogicSnapshot::get_samples(uint64_t start_sample, uint64_t &end_s
     }
     else{
         if (lbp != NULL){
-            *lbp = _ch_data[order][index0].lbp[index1];
+            void *cur_lbp = _ch_data[order][index0].lbp[index1];
+
+            // Take the new block before the old one is let go, under the same lock.
+            if (*lbp != cur_lbp){
+                if (cur_lbp != NULL)
+                    _decode_lbp_refs[cur_lbp]++;
+                if (*lbp != NULL)
+                    unref_decode_lpb(*lbp);
+                *lbp = cur_lbp;
+            }
         }
-
-        _cur_ref_block_indexs[order].root_index = index0;
-        _cur_ref_block_indexs[order].lbp_index  = index1;
         
         return block_buffer + offset;
     }
@@ -721,10 +992,58 @@ bool LogicSnapshot::get_display_edges(std::vector<std::pair<bool, bool> > &edges
 
     std::lock_guard<std::mutex> lock(_mutex);
 
-    if (_ring_sample_count == 0)
+    _ring_sample_count += _loop_offset;
+
+    bool flag = get_display_edges_self(edges, togs, start, end, width, max_togs,
+                                       pixels_offset, min_length, sig_index);
+
+    _ring_sample_count -= _loop_offset;
+    return flag;
+}
+
+void LogicSnapshot::begin_display_edges()
+{
+    // The walks only read the snapshot, so they share this lock. The loop
+    // offset is applied once here rather than by each walk, which would
+    // race on _ring_sample_count.
+    // The lock is held across all the channels, so the capture thread
+    // waits up to one repaint before it appends. Releasing it between
+    // channels would let a payload land mid frame, and the channels of one
+    // frame would end at different samples.
+    _mutex.lock();
+    _ring_sample_count += _loop_offset;
+}
+
+void LogicSnapshot::end_display_edges()
+{
+    _ring_sample_count -= _loop_offset;
+    _mutex.unlock();
+}
+
+bool LogicSnapshot::get_display_edges_batch(std::vector<std::pair<bool, bool> > &edges,
+    std::vector<std::pair<uint16_t, bool> > &togs,
+    uint64_t start, uint64_t end, uint16_t width, uint16_t max_togs,
+    double pixels_offset, double min_length, uint16_t sig_index)
+{
+    if (!edges.empty())
+        edges.clear();
+    if (!togs.empty())
+        togs.clear();
+
+    return get_display_edges_self(edges, togs, start, end, width, max_togs,
+                                  pixels_offset, min_length, sig_index);
+}
+
+bool LogicSnapshot::get_display_edges_self(std::vector<std::pair<bool, bool> > &edges,
+    std::vector<std::pair<uint16_t, bool> > &togs,
+    uint64_t start, uint64_t end, uint16_t width, uint16_t max_togs,
+    double pixels_offset, double min_length, uint16_t sig_index)
+{
+    // The indexes are ring relative, _ring_sample_count has the loop offset.
+    if (_ring_sample_count <= _loop_offset)
         return false;
 
-    assert(end < _ring_sample_count);
+    assert(end + _loop_offset < _ring_sample_count);
     assert(start <= end);
     assert(min_length > 0);
 
@@ -733,12 +1052,14 @@ bool LogicSnapshot::get_display_edges(std::vector<std::pair<bool, bool> > &edges
     bool start_sample;
 
     // Get the initial state
-    start_sample = last_sample = get_sample_unlock(index++, sig_index);
+    start_sample = last_sample = get_sample_self(_loop_offset + index++, sig_index);
     togs.push_back(pair<uint16_t, bool>(0, last_sample));
 
     while(edges.size() < width) {
         // search next edge
-        bool has_edge = get_nxt_edge_unlock(index, last_sample, end, 0, sig_index);
+        index += _loop_offset;
+        bool has_edge = get_nxt_edge_self(index, last_sample, end + _loop_offset, 0, sig_index);
+        index -= _loop_offset;
 
         // calc the edge position
         int64_t gap = (index / min_length) - pixels_offset;
@@ -749,9 +1070,9 @@ bool LogicSnapshot::get_display_edges(std::vector<std::pair<bool, bool> > &edges
         }
 
         if (index > end)
-            last_sample = get_sample_unlock(end, sig_index);
+            last_sample = get_sample_self(_loop_offset + end, sig_index);
         else
-            last_sample = get_sample_unlock(index - 1, sig_index);
+            last_sample = get_sample_self(_loop_offset + index - 1, sig_index);
 
         if (has_edge) {
             edges.push_back(pair<bool, bool>(true, last_sample));
@@ -764,7 +1085,7 @@ bool LogicSnapshot::get_display_edges(std::vector<std::pair<bool, bool> > &edges
     }
 
     if (togs.size() < max_togs) {
-        last_sample = get_sample_unlock(end, sig_index);
+        last_sample = get_sample_self(_loop_offset + end, sig_index);
         togs.push_back(pair<uint16_t, bool>(edges.size() - 1, last_sample));
     }
 
@@ -1282,6 +1603,7 @@ bool LogicSnapshot::pattern_search_self(int64_t start, int64_t end, int64_t &ind
     char flagList[CHANNEL_MAX_COUNT];
     char lstValues[CHANNEL_MAX_COUNT];
     int  chanIndexs[CHANNEL_MAX_COUNT];
+    int  orders[CHANNEL_MAX_COUNT];
     int  count = 0;  
     bool bEdgeFlag = false;
 
@@ -1295,6 +1617,7 @@ bool LogicSnapshot::pattern_search_self(int64_t start, int64_t end, int64_t &ind
          if (flag != 'X' && has_data(channel)){
              flagList[count]  = flag;
              chanIndexs[count] = channel;
+             orders[count] = get_ch_order(channel);
              count++;
 
              if (flag == 'R' || flag == 'F' || flag == 'C'){
@@ -1307,7 +1630,6 @@ bool LogicSnapshot::pattern_search_self(int64_t start, int64_t end, int64_t &ind
     }  
 
     //find
-    bool ret = false;
     char val = 0;
     int macthed = 0;  
 
@@ -1326,66 +1648,446 @@ bool LogicSnapshot::pattern_search_self(int64_t start, int64_t end, int64_t &ind
         index = end;
     }
 
-    while (index != to && !_is_search_stop)
+    // The first position compares with the sample where the search begins,
+    // the others compare with their neighbour samples.
+    macthed = 0;
+
+    for (int i = 0; i < count; i++)
     {
-        macthed = 0;
+        val = (char)get_sample_self(index, chanIndexs[i]);
+
+        if (flagList[i] == '0')
+            macthed += !val;
+        else if (flagList[i] == '1')
+            macthed += val;
+        else if (flagList[i] == 'R')
+            macthed += isNext ? (lstValues[i] == 0 && val == 1) : (lstValues[i] == 1 && val == 0);
+        else if (flagList[i] == 'F')
+            macthed += isNext ? (lstValues[i] == 1 && val == 0) : (lstValues[i] == 0 && val == 1);
+        else if (flagList[i] == 'C')
+            macthed += (lstValues[i] != val);
+    }
+
+    if (macthed == count){
+        if (!isNext){
+            index++; //move to prev position
+        }
+        return true;
+    }
 
-        for (int i = 0; i < count; i++)
-        {
-            if (_is_search_stop){
-                break;
-            }
+    // The previous search returns the position after the matched sample,
+    // as the sample by sample search did.
+    const uint64_t qlo = isNext ? (uint64_t)index + 1 : (uint64_t)start + 1;
+    const uint64_t qhi = isNext ? (uint64_t)end : (uint64_t)index;
+    uint64_t q = isNext ? qlo : qhi;
 
-            val = (char)get_sample_self(index, chanIndexs[i]);
+    if (qlo <= qhi && pattern_match_words(q, qlo, qhi, flagList, orders, count, isNext)){
+        index = (int64_t)q;
+        return true;
+    }
 
-            if (flagList[i] == '0')
-            {
-                macthed += !val;
-            }
-            else if (flagList[i] == '1')
-            {
-                macthed += val;
-            } 
-            else if (flagList[i] == 'R')
-            {
-                if (isNext)
-                    macthed += (lstValues[i] == 0 && val == 1);
-                else
-                    macthed += (lstValues[i] == 1 && val == 0);
-            }
-            else if (flagList[i] == 'F')
-            {
-                if (isNext)
-                    macthed += (lstValues[i] == 1 && val == 0);
-                else
-                    macthed += (lstValues[i] == 0 && val == 1);
-            }
-            else if (flagList[i] == 'C')
-            {   
-                if (isNext)
-                    macthed += (lstValues[i] == 0 && val == 1) || (lstValues[i] == 1 && val == 0);
-                else
-                    macthed += (lstValues[i] == 1 && val == 0) || (lstValues[i] == 0 && val == 1);
-            }
-            lstValues[i] = val;
-        }
+    index = to;
+    return false;
+}
+
+bool LogicSnapshot::pattern_search_all(int64_t start, int64_t end, std::vector<uint64_t> &hits,
+                        std::map<uint16_t, QString> &pattern, uint64_t max_hits,
+                        SearchHitsCallback on_hits)
+{
+    char flagList[CHANNEL_MAX_COUNT];
+    int  chanIndexs[CHANNEL_MAX_COUNT];
+    int  count = 0;
+    bool bEdgeFlag = false;
+
+    _is_search_stop = false;
+    hits.clear();
+
+    for (auto it = pattern.begin(); it != pattern.end(); it++){
+         char flag = *(it->second.toStdString().c_str());
+
+         if (flag != 'X'){
+             flagList[count] = flag;
+             chanIndexs[count] = it->first;
+             count++;
+
+             if (flag == 'R' || flag == 'F' || flag == 'C'){
+                 bEdgeFlag = true;
+             }
+         }
+    }
+    if (start > end){
+        return false;
+    }
+
+    // An edge needs the sample before it.
+    uint64_t q = bEdgeFlag ? (uint64_t)start + 1 : (uint64_t)start;
+    bool has_channel = false;
+
+    while (q <= (uint64_t)end && hits.size() < max_hits && !_is_search_stop)
+    {
+        const uint64_t chunk_hi = min((uint64_t)end, (q | (SearchChunkSamples - 1)));
+        const size_t first_hit = hits.size();
 
-        // matched all
-        if (macthed == count)
         {
-            ret = true;
-            if (!isNext){
-                index++; //move to prev position
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            // The channels are looked up again, the data may be reset between the chunks.
+            int  orders[CHANNEL_MAX_COUNT];
+            char flags[CHANNEL_MAX_COUNT];
+            int  used = 0;
+
+            for (int i = 0; i < count; i++){
+                if (has_data(chanIndexs[i])){
+                    flags[used] = flagList[i];
+                    orders[used] = get_ch_order(chanIndexs[i]);
+                    used++;
+                }
             }
-            break;
+            if (used == 0)
+                break;
+            has_channel = true;
+
+            uint64_t lq = q + _loop_offset;
+            const uint64_t lhi = chunk_hi + _loop_offset;
+            _ring_sample_count += _loop_offset;
+
+            while (lq <= lhi && hits.size() < max_hits
+                   && pattern_match_words(lq, lq, lhi, flags, orders, used, true))
+            {
+                hits.push_back(lq - _loop_offset);
+                lq++;
+            }
+
+            _ring_sample_count -= _loop_offset;
         }
 
-        index += step;
+        if (on_hits && hits.size() > first_hit){
+            on_hits(std::vector<uint64_t>(hits.begin() + first_hit, hits.end()));
+        }
+
+        q = chunk_hi + 1;
     }
 
+    if (hits.size() == max_hits){
+        dsv_info("Search all: the hit count reached the limit %llu.", (u64_t)max_hits);
+    }
+
+    return has_channel && !_is_search_stop;
+}
+
+// Search 64 samples at a time from q. A position q matches when the level channels
+// match at q (next) or at q - 1 (previous), and the edge channels toggle between
+// q - 1 and q.
+bool LogicSnapshot::pattern_match_words(uint64_t &q, uint64_t qlo, uint64_t qhi,
+                        const char *flagList, const int *orders, int count, bool isNext)
+{
+    while (!_is_search_stop)
+    {
+        const uint64_t w = q >> ScalePower;
+
+        // The edge channels have no toggle in these words.
+        uint64_t skip = 0;
+        for (int i = 0; i < count; i++){
+            if (flagList[i] == 'R' || flagList[i] == 'F' || flagList[i] == 'C')
+                skip = max(skip, get_edge_free_words(w, orders[i], isNext));
+        }
+
+        if (skip == 0)
+        {
+            uint64_t hit = ~0ULL;
+
+            for (int i = 0; i < count && hit; i++)
+            {
+                const uint64_t x = get_word_self(w, orders[i]);
+                const uint64_t pre = (x << 1) | (w > 0 ? get_word_self(w - 1, orders[i]) >> (Scale - 1) : 0);
+                const uint64_t lv = isNext ? x : pre;
+
+                if (flagList[i] == '0')
+                    hit &= ~lv;
+                else if (flagList[i] == '1')
+                    hit &= lv;
+                else if (flagList[i] == 'R')
+                    hit &= ~pre & x;
+                else if (flagList[i] == 'F')
+                    hit &= pre & ~x;
+                else if (flagList[i] == 'C')
+                    hit &= pre ^ x;
+            }
+
+            if (isNext){
+                hit &= ~0ULL << (q & LevelMask[0]);
+                if ((qhi >> ScalePower) == w)
+                    hit &= ~0ULL >> (Scale - 1 - (qhi & LevelMask[0]));
+
+                if (hit){
+                    q = (w << ScalePower) + bsf_folded(hit);
+                    return true;
+                }
+            }
+            else{
+                hit &= ~0ULL >> (Scale - 1 - (q & LevelMask[0]));
+                if ((qlo >> ScalePower) == w)
+                    hit &= ~0ULL << (qlo & LevelMask[0]);
+
+                if (hit){
+                    q = (w << ScalePower) + bsr64(hit);
+                    return true;
+                }
+            }
+            skip = 1;
+        }
+
+        if (isNext){
+            q = (w + skip) << ScalePower;
+            if (q > qhi)
+                break;
+        }
+        else{
+            if (w < skip || ((w - skip + 1) << ScalePower) <= qlo)
+                break;
+            q = ((w - skip + 1) << ScalePower) - 1;
+        }
+    }
+
+    return false;
+}
+
+uint64_t LogicSnapshot::get_word_self(uint64_t word_index, int order)
+{
+    uint64_t index = word_index << ScalePower;
+
+    if (index >= _ring_sample_count)
+        return 0;
+
+    uint64_t index0 = index >> (LeafBlockPower + RootScalePower);
+    uint64_t index1 = (index & RootMask) >> LeafBlockPower;
+    uint64_t root_pos_mask = 1ULL << index1;
+    uint64_t word;
+
+    if ((_ch_data[order][index0].tog & root_pos_mask) == 0) {
+        word = (_ch_data[order][index0].first & root_pos_mask) ? ~0ULL : 0ULL;
+    }
+    else {
+        uint64_t *lbp = (uint64_t*)_ch_data[order][index0].lbp[index1];
+        word = *(lbp + ((index & LeafMask) >> ScalePower));
+    }
+
+    // The samples out of range are low, as get_sample_self() reads them.
+    if (_ring_sample_count - index < Scale)
+        word &= ~(~0ULL << (_ring_sample_count - index));
+
+    return word;
+}
+
+uint64_t LogicSnapshot::get_edge_free_words(uint64_t word_index, int order, bool isNext)
+{
+    const uint64_t leaf_words = LeafBlockSamples >> ScalePower;
+    const uint64_t block_word = word_index & (leaf_words - 1);
+    const uint64_t index = word_index << ScalePower;
+
+    // The first word also holds the edge from the previous block.
+    if (block_word == 0 || index >= _ring_sample_count)
+        return 0;
+
+    uint64_t index0 = index >> (LeafBlockPower + RootScalePower);
+    uint64_t index1 = (index & RootMask) >> LeafBlockPower;
+
+    // No toggle in the whole block
+    if ((_ch_data[order][index0].tog & (1ULL << index1)) == 0)
+        return isNext ? leaf_words - block_word : block_word;
+
+    // The mipmap of the block which is being filled is not complete.
+    uint64_t *lbp = (uint64_t*)_ch_data[order][index0].lbp[index1];
+    if (lbp == NULL || (index | LeafMask) >= _ring_sample_count)
+        return 0;
+
+    // A level 1 bit is set when a word has any edge, a bit of the
+    // higher level is set when any of its 64 low level bits is set.
+    for (int level = ScaleLevel - 1; level > 0; level--)
+    {
+        const uint64_t span_power = (level - 1) * ScalePower;
+        const uint64_t bit_index = block_word >> span_power;
+        const uint64_t bits = *(lbp + LevelOffset[level] + (bit_index >> ScalePower));
+
+        if ((bits & (1ULL << (bit_index & LevelMask[0]))) == 0) {
+            const uint64_t group_start = bit_index << span_power;
+
+            if (isNext)
+                return group_start + (1ULL << span_power) - block_word;
+            else
+                return block_word - max(group_start, (uint64_t)1) + 1;
+        }
+    }
+
+    return 0;
+}
+
+bool LogicSnapshot::get_range_stats(uint64_t start, uint64_t end, int sig_index,
+                        struct RangeStats &stats, bool with_pulses)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (start > end || end >= _ring_sample_count)
+        return false;
+
+    int order = get_ch_order(sig_index);
+    if (order == -1)
+        return false;
+
+    start += _loop_offset;
+    end += _loop_offset;
+    _ring_sample_count += _loop_offset;
+
+    get_range_stats_self(start, end, order, stats, with_pulses);
+
+    _ring_sample_count -= _loop_offset;
+    return true;
+}
+
+void LogicSnapshot::get_range_stats_self(uint64_t start, uint64_t end, int order,
+                        struct RangeStats &stats, bool with_pulses)
+{
+    const uint64_t leaf_words = LeafBlockSamples >> ScalePower;
+    const uint64_t first_word = start >> ScalePower;
+    const uint64_t end_word = end >> ScalePower;
+
+    bool level = (get_word_self(first_word, order) >> (start & LevelMask[0])) & 1;
+    uint64_t run_start = start;
+    bool run_whole = false; // The run began with an edge inside the range.
+
+    memset(&stats, 0, sizeof(stats));
+
+    auto merge_pulse = [](uint64_t &min_width, uint64_t &max_width, uint32_t block_min, uint32_t block_max) {
+        if (block_min != 0 && (min_width == 0 || block_min < min_width))
+            min_width = block_min;
+        if (block_max > max_width)
+            max_width = block_max;
+    };
+
+    auto add_pulse = [&](uint64_t edge_index, bool run_high) {
+        if (run_whole) {
+            const uint64_t width = edge_index - run_start;
+            uint64_t &min_width = run_high ? stats.min_high : stats.min_low;
+            uint64_t &max_width = run_high ? stats.max_high : stats.max_low;
+
+            if (min_width == 0 || width < min_width)
+                min_width = width;
+            if (width > max_width)
+                max_width = width;
+        }
+        run_start = edge_index;
+        run_whole = true;
+    };
+
+    for (uint64_t w = first_word; w <= end_word;)
+    {
+        const uint64_t index = w << ScalePower;
+
+        // A whole leaf block is counted at once from its summary.
+        LeafStats ls;
+        if (index > start && (index & LeafMask) == 0 && (index | LeafMask) <= end
+            && get_leaf_stats_self(index, order, ls)) {
+            const uint64_t index0 = index >> (LeafBlockPower + RootScalePower);
+            const uint64_t root_pos_mask = 1ULL << ((index & RootMask) >> LeafBlockPower);
+            const bool block_level = (_ch_data[order][index0].first & root_pos_mask) != 0;
+
+            if (block_level != level) {
+                stats.rising += block_level;
+                stats.falling += !block_level;
+                if (with_pulses)
+                    add_pulse(index, level);
+            }
+
+            // The edges in the block alternate from the first level.
+            stats.rising += block_level ? ls.edges / 2 : (ls.edges + 1) / 2;
+            stats.falling += block_level ? (ls.edges + 1) / 2 : ls.edges / 2;
+            stats.high_samples += ls.ones;
+
+            if (with_pulses && ls.edges > 0) {
+                add_pulse(index + ls.first_edge, block_level);
+                merge_pulse(stats.min_high, stats.max_high, ls.min_high, ls.max_high);
+                merge_pulse(stats.min_low, stats.max_low, ls.min_low, ls.max_low);
+                run_start = index + ls.last_edge;
+            }
+
+            level = (_ch_data[order][index0].last & root_pos_mask) != 0;
+            w += leaf_words;
+            continue;
+        }
+
+        const uint64_t word = get_word_self(w, order);
+        uint64_t mask = ~0ULL;
+
+        if (w == first_word)
+            mask <<= (start & LevelMask[0]);
+        if (w == end_word)
+            mask &= ~0ULL >> (Scale - 1 - (end & LevelMask[0]));
+
+        stats.high_samples += popcount64(word & mask);
+
+        // Bit n is set when the sample n differs from the one before it.
+        uint64_t edges = (word ^ ((word << 1) | (uint64_t)level)) & mask;
+        if (w == first_word)
+            edges &= ~(1ULL << (start & LevelMask[0]));
+
+        stats.rising += popcount64(edges & word);
+        stats.falling += popcount64(edges & ~word);
+
+        if (with_pulses) {
+            while (edges) {
+                const uint8_t pos = bsf_folded(edges);
+                edges &= edges - 1;
+                add_pulse(index + pos, ((word >> pos) & 1) == 0);
+            }
+        }
+
+        level = (word & MSB) != 0;
+        w++;
+    }
+}
+
+bool LogicSnapshot::get_leaf_stats(uint64_t index, int sig_index, struct LeafStats &stats)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    int order = get_ch_order(sig_index);
+    if (order == -1 || index >= _ring_sample_count)
+        return false;
+
+    index += _loop_offset;
+    _ring_sample_count += _loop_offset;
+
+    bool ret = get_leaf_stats_self(index, order, stats);
+
+    _ring_sample_count -= _loop_offset;
     return ret;
 }
 
+bool LogicSnapshot::get_leaf_stats_self(uint64_t index, int order, struct LeafStats &stats)
+{
+    // The block which is being filled has no summary yet.
+    if ((index | LeafMask) >= _ring_sample_count)
+        return false;
+
+    const uint64_t index0 = index >> (LeafBlockPower + RootScalePower);
+    const uint64_t index1 = (index & RootMask) >> LeafBlockPower;
+    const uint64_t root_pos_mask = 1ULL << index1;
+    const struct RootNode &rn = _ch_data[order][index0];
+
+    if ((rn.tog & root_pos_mask) == 0) {
+        memset(&stats, 0, sizeof(stats));
+        if (rn.first & root_pos_mask)
+            stats.ones = LeafBlockSamples;
+        return true;
+    }
+
+    if ((rn.stat & root_pos_mask) == 0)
+        return false;
+
+    stats = rn.stats[index1];
+    return true;
+}
+
 bool LogicSnapshot::has_data(int sig_index)
 {
     return get_ch_order(sig_index) != -1;
@@ -1527,7 +2229,7 @@ void LogicSnapshot::move_first_node_to_last()
         for (int x=0; x<(int)Scale; x++)
         {
             if (rn.lbp[x] != NULL){
-                free(rn.lbp[x]);
+                free_head_block(rn.lbp[x]);
                 rn.lbp[x] = NULL;
             }
         }
@@ -1535,17 +2237,272 @@ void LogicSnapshot::move_first_node_to_last()
         rn.tog = 0;
         rn.first = 0;
         rn.last = 0;
+        rn.stat = 0;
 
-        _ch_data[i].push_back(rn);                        
+        _ch_data[i].push_back(rn);
     }
+
+    _loop_discarded += RootNodeSamples;
+}
+
+// The samples are written before they are read, only the mipmap levels are
+// zeroed, calc_mipmap() builds them by setting bits.
+void *LogicSnapshot::alloc_leaf_block()
+{
+    void *lbp = take_leaf_block();
+
+    if (lbp != NULL)
+        memset((uint8_t*)lbp + LeafBlockSamples / 8, 0, LeafBlockSpace - LeafBlockSamples / 8);
+
+    return lbp;
+}
+
+// A block for a full copy, left as it is.
+void *LogicSnapshot::take_leaf_block()
+{
+    void *lbp = NULL;
+
+    if (!_leaf_pool.empty()){
+        lbp = _leaf_pool.back();
+        _leaf_pool.pop_back();
+        _pool_hits++;
+    }
+    else {
+        lbp = new_leaf_block();
+        if (lbp == NULL)
+            return NULL;
+        _pool_misses++;
+    }
+
+    return lbp;
+}
+
+// The samples fill exactly one 2MB huge page, the levels after them stay on
+// normal pages rather than taking a second huge page for 33KB.
+void *LogicSnapshot::new_leaf_block()
+{
+    void *lbp = NULL;
+
+#ifdef __linux__
+    if (_pool_huge_page){
+        const size_t huge_size = LeafBlockSamples / 8;
+        if (posix_memalign(&lbp, huge_size, LeafBlockSpace) != 0)
+            return NULL;
+        madvise(lbp, huge_size, MADV_HUGEPAGE);
+    }
+    else
+#endif
+    lbp = malloc(LeafBlockSpace);
+
+    if (lbp != NULL)
+        _pool_blocks++;
+
+    return lbp;
+}
+
+void LogicSnapshot::release_leaf_block(void *lbp)
+{
+    if (_leaf_pool.size() < _pool_limit)
+        _leaf_pool.push_back(lbp);
+    else
+        free_leaf_block(lbp);
+}
+
+void LogicSnapshot::free_leaf_block(void *lbp)
+{
+    free(lbp);
+
+    if (_pool_blocks > 0)
+        _pool_blocks--;
+}
+
+void LogicSnapshot::reserve_leaf_blocks(uint64_t count)
+{
+    while (_leaf_pool.size() < count)
+    {
+        void *lbp = new_leaf_block();
+        if (lbp == NULL){
+            dsv_err("LogicSnapshot::reserve_leaf_blocks, Malloc memory failed!");
+            break;
+        }
+        // Touch the pages now rather than in the data path.
+        memset(lbp, 0, LeafBlockSpace);
+        _leaf_pool.push_back(lbp);
+    }
+}
+
+void LogicSnapshot::release_leaf_pool()
+{
+    for (void *p : _leaf_pool){
+        free_leaf_block(p);
+    }
+    _leaf_pool.clear();
+}
+
+void LogicSnapshot::free_head_block(void *lbp)
+{
+    if (lbp == _mipmap_lbp)
+        _mipmap_dropped = true; // The mipmap worker releases it.
+    else
+        free_leaf_block_later(lbp);
+}
+
+// A block held by a decoder waits in the free list until the last one lets it go,
+// call it with the mutex held.
+void LogicSnapshot::free_leaf_block_later(void *lbp)
+{
+    if (_decode_lbp_refs.find(lbp) != _decode_lbp_refs.end())
+        _free_block_list.push_back(lbp);
+    else
+        release_leaf_block(lbp);
+}
+
+void LogicSnapshot::start_mipmap_worker()
+{
+    if (!_mipmap_thread.joinable())
+        _mipmap_thread = std::thread(&LogicSnapshot::mipmap_proc, this);
+}
+
+void LogicSnapshot::mipmap_proc()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _mipmap_cond.wait(lock, [this]{
+                return _mipmap_exit || _mipmap_index < _fill_index;
+            });
+
+            if (_mipmap_exit)
+                break;
+        }
+
+        // The reset of the data waits for the pass on this lock.
+        std::lock_guard<std::mutex> pass_lock(_mipmap_mutex);
+        std::unique_lock<std::mutex> lock(_mutex);
+        calc_mipmap_pass(lock, true);
+    }
+}
+
+// Build the mipmap of all channels up to the fill index. The feed may append
+// and move the ring head while the lock is released.
+void LogicSnapshot::calc_mipmap_pass(std::unique_lock<std::mutex> &lock, bool unlock_compute)
+{
+    while (_mipmap_index < _fill_index && !_mipmap_exit)
+    {
+        const uint64_t block_start = _mipmap_index & ~LeafMask;
+        const uint64_t block_end = block_start + LeafBlockSamples;
+        const uint64_t upto = min((uint64_t)_fill_index, block_end);
+        const bool isEnd = (upto == block_end);
+
+        for (unsigned int order = 0; order < _channel_num; order++)
+        {
+            // The head of the ring has passed the block.
+            if (block_start < _loop_discarded){
+                _last_calc_count[order] = 0;
+                continue;
+            }
+
+            uint64_t logic_index = block_start - _loop_discarded;
+            void *lbp = _ch_data[order][logic_index / RootNodeSamples].lbp[(logic_index & RootMask) >> LeafBlockPower];
+
+            if (lbp == NULL){
+                _last_calc_count[order] = 0;
+                continue;
+            }
+
+            LeafStats stats;
+            _mipmap_lbp = lbp;
+            _mipmap_dropped = false;
+
+            if (unlock_compute)
+                lock.unlock();
+
+            bool toggled = calc_mipmap(order, lbp, upto - block_start, isEnd, stats);
+
+            if (unlock_compute)
+                lock.lock();
+
+            _mipmap_lbp = NULL;
+
+            if (_mipmap_dropped){
+                free_leaf_block_later(lbp);
+                _last_calc_count[order] = 0;
+                continue;
+            }
+
+            // The ring may have moved, find the block again.
+            logic_index = block_start - _loop_discarded;
+            publish_mipmap(order, logic_index / RootNodeSamples,
+                    (logic_index & RootMask) >> LeafBlockPower, toggled, isEnd, stats);
+        }
+
+        _mipmap_index = upto;
+        update_ring_sample_count();
+        notify_data_changed();
+    }
+}
+
+// The readers see the samples which have the mipmap done, call it with the mutex held.
+void LogicSnapshot::update_ring_sample_count()
+{
+    if (_block_loaded)
+        return;
+
+    uint64_t logic_index = 0;
+    if (_mipmap_index > _loop_discarded)
+        logic_index = _mipmap_index - _loop_discarded;
+
+    if (logic_index > _loop_offset)
+        _ring_sample_count = min(logic_index - _loop_offset, (uint64_t)_total_sample_count);
+    else
+        _ring_sample_count = 0;
+}
+
+uint64_t LogicSnapshot::get_loop_discard_count()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _loop_discarded + _loop_offset;
+}
+
+bool LogicSnapshot::wait_samples(uint64_t index, int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    const uint64_t seq = _data_seq;
+
+    return _data_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&]{
+        return _ring_sample_count > index || _data_seq != seq;
+    });
+}
+
+void LogicSnapshot::notify_data_changed()
+{
+    _data_seq++;
+    _data_cond.notify_all();
+}
+
+void LogicSnapshot::decode_begin()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _decode_readers++;
 }
 
 void LogicSnapshot::decode_end()
 {
    std::lock_guard<std::mutex> lock(_mutex);
 
+   if (_decode_readers > 0)
+        _decode_readers--;
+
+   // Other decoders may still read the released blocks.
+   if (_decode_readers > 0)
+        return;
+
+   // A decoder which stopped early may not have let its blocks go.
+   _decode_lbp_refs.clear();
+
    for(void *p : _free_block_list){
-        free(p);
+        release_leaf_block(p);
     }
     _free_block_list.clear();
 }
@@ -1555,12 +2512,24 @@ void LogicSnapshot::free_decode_lpb(void *lbp)
     assert(lbp);
 
     std::lock_guard<std::mutex> lock(_mutex);
+    unref_decode_lpb(lbp);
+}
+
+// Call it with the mutex held.
+void LogicSnapshot::unref_decode_lpb(void *lbp)
+{
+    auto ref = _decode_lbp_refs.find(lbp);
+
+    if (ref == _decode_lbp_refs.end() || --ref->second > 0)
+        return;
+
+    _decode_lbp_refs.erase(ref);
 
     for (auto it = _free_block_list.begin(); it != _free_block_list.end(); it++)
     {
         if ((*it) == lbp){
             _free_block_list.erase(it);
-            free(lbp);
+            release_leaf_block(lbp);
             break;
         }
     }
@@ -1575,7 +2544,7 @@ void LogicSnapshot::free_head_blocks(int count)
     {
         for (int j=_lst_free_block_index; j<count; j++){
             if (_ch_data[i][0].lbp[j] != NULL){
-                free(_ch_data[i][0].lbp[j]);
+                free_head_block(_ch_data[i][0].lbp[j]);
                 _ch_data[i][0].lbp[j] = NULL;
             }
 
@@ -30,6 +30,9 @@
 #include <utility>
 #include <vector>
 #include <map>
+#include <condition_variable>
+#include <thread>
+#include <functional>
 
 #define CHANNEL_MAX_COUNT 64
 
@@ -68,26 +71,71 @@ private:
     static const uint64_t MSB =  (1ULL << (Scale - 1));
     static const uint64_t LSB =  (1ULL);
 
+    // The idle leaf blocks kept for reuse, per channel.
+    static const uint64_t PoolBlocksPerChannel = 4;
+
+    // Find all releases the lock after each range of this many samples.
+    static const uint64_t SearchChunkSamples = LeafBlockSamples;
+
+public:
+    // The summary of a leaf block, the offsets are from the block start and
+    // the edges are those after the first sample.
+    struct LeafStats
+    {
+        uint32_t edges;
+        uint32_t ones;
+        uint32_t first_edge;
+        uint32_t last_edge;
+        // The pulses between the first and the last edge, zero when there's none.
+        uint32_t min_high;
+        uint32_t max_high;
+        uint32_t min_low;
+        uint32_t max_low;
+    };
+
 private:
     struct RootNode
     {
         uint64_t tog;
         uint64_t first;
         uint64_t last;
+        uint64_t stat; // the leaf blocks whose stats are ready
         void *lbp[Scale];
-    };
-
-    struct BlockIndex
-    {
-        uint64_t    root_index;
-        uint64_t    lbp_index;
+        struct LeafStats stats[Scale];
     };
 
 public:
     typedef std::pair<uint64_t, bool> EdgePair;
 
+    // Receives the hits of each searched range, called without the lock held.
+    typedef std::function<void(const std::vector<uint64_t> &hits)> SearchHitsCallback;
+
+    // The statistics of a sample range, the edges are those after the first sample.
+    struct RangeStats
+    {
+        uint64_t rising;
+        uint64_t falling;
+        uint64_t high_samples;
+        // The pulses with both edges in the range, zero when there's none.
+        uint64_t min_high;
+        uint64_t max_high;
+        uint64_t min_low;
+        uint64_t max_low;
+    };
+
 private:
     void init_all();
+    void init_channels(uint64_t total_sample_count, GSList *channels);
+    bool is_mapped_block(void *lbp);
+    void release_mapped_files();
+
+    void *alloc_leaf_block();
+    void *take_leaf_block();
+    void *new_leaf_block();
+    void release_leaf_block(void *lbp);
+    void free_leaf_block(void *lbp);
+    void reserve_leaf_blocks(uint64_t count);
+    void release_leaf_pool();
 
 public:
     LogicSnapshot();
@@ -100,10 +148,42 @@ public:
 
     void init();   
 
-    void first_payload(const sr_datafeed_logic &logic, uint64_t total_sample_count, GSList *channels, bool able_free);
+    void first_payload(const sr_datafeed_logic &logic, uint64_t total_sample_count, GSList *channels);
 
 	void append_payload(const sr_datafeed_logic &logic);
 
+    // Load the saved leaf blocks of a session file, the mipmap is not rebuilt.
+    bool first_block(const sr_datafeed_logic_block &block, uint64_t total_sample_count, GSList *channels);
+
+    bool append_block(const sr_datafeed_logic_block &block);
+
+    // Copy the blocks mapped from a session file into own memory and let the
+    // file go, so that it can be written again. Fails while a decoder reads one.
+    bool copy_mapped_blocks();
+
+    bool has_mapped_blocks();
+
+    // The whole leaf block size, the samples followed by the mipmap levels.
+    static inline uint64_t get_leaf_block_space(){
+        return LeafBlockSpace;
+    }
+
+    static inline uint64_t get_leaf_block_samples(){
+        return LeafBlockSamples;
+    }
+
+    static inline uint64_t get_scale_power(){
+        return ScalePower;
+    }
+
+    static inline uint64_t get_scale_level(){
+        return ScaleLevel;
+    }
+
+    /**
+     * A decoder passes the block it holds in lbp, it is replaced by the block
+     * of start_sample. The held blocks are not freed until free_decode_lpb().
+     */
     const uint8_t * get_samples(uint64_t start_sample, uint64_t& end_sample, int sig_index, void **lbp=NULL);
 
     bool get_sample(uint64_t index, int sig_index);
@@ -116,6 +196,18 @@ public:
                            uint16_t max_togs, double pixels_offset,
                            double min_length, uint16_t sig_index);
 
+    // Hold the snapshot for a repaint that walks several channels at once.
+    // Between the two calls get_display_edges_batch() may run on any number
+    // of threads, no other snapshot call may be made.
+    void begin_display_edges();
+    void end_display_edges();
+
+    bool get_display_edges_batch(std::vector<std::pair<bool, bool>> &edges,
+                           std::vector<std::pair<uint16_t, bool>> &togs,
+                           uint64_t start, uint64_t end, uint16_t width,
+                           uint16_t max_togs, double pixels_offset,
+                           double min_length, uint16_t sig_index);
+
     bool get_nxt_edge(uint64_t &index, bool last_sample, uint64_t end,
                       double min_length, int sig_index);
 
@@ -123,6 +215,15 @@ public:
                       double min_length, int sig_index);
 
     bool has_data(int sig_index);
+
+    // Count the edges and the high samples in [start, end], the pulse widths
+    // need every edge position, skip them when only the counts are needed.
+    bool get_range_stats(uint64_t start, uint64_t end, int sig_index,
+                        struct RangeStats &stats, bool with_pulses = true);
+
+    // The summary of the leaf block which holds the sample, false when the
+    // block is not complete yet.
+    bool get_leaf_stats(uint64_t index, int sig_index, struct LeafStats &stats);
     int get_block_num();
     uint8_t *get_block_buf(int block_index, int sig_index, bool &sample);   
     uint64_t get_block_size(int block_index);
@@ -130,6 +231,12 @@ public:
     bool pattern_search(int64_t start, int64_t end, int64_t& index,
                         std::map<uint16_t, QString> &pattern, bool isNext);
 
+    // Collect all the matched positions in order, as the next search returns them.
+    // The range is searched in chunks, other calls may run between them.
+    bool pattern_search_all(int64_t start, int64_t end, std::vector<uint64_t> &hits,
+                        std::map<uint16_t, QString> &pattern, uint64_t max_hits,
+                        SearchHitsCallback on_hits = NULL);
+
     inline void set_loop(bool bLoop){
         _is_loop = bLoop;
     }
@@ -138,18 +245,29 @@ public:
         return _is_loop;
     }
 
+    void decode_begin();
+
     void decode_end();
 
     void free_decode_lpb(void *lbp);
 
-    inline bool is_able_free(){
-        return _able_free;
-    } 
-
     inline uint64_t get_loop_offset(){
         return _loop_offset;
     }
 
+    // Back the samples of the new leaf blocks with transparent huge pages,
+    // Linux only. Call it before the first payload.
+    inline void set_huge_page(bool enable){
+        _pool_huge_page = enable;
+    }
+
+    // The samples dropped from the ring head since the capture began.
+    uint64_t get_loop_discard_count();
+
+    // Block until the ring holds the sample of index, or the data changed in any
+    // other way, returns false when the time is out.
+    bool wait_samples(uint64_t index, int timeout_ms);
+
     inline void cancel_search(){
         _is_search_stop = true;
     }
@@ -171,12 +289,43 @@ private:
     bool get_pre_edge_self(uint64_t &index, bool last_sample,
                       double min_length, int sig_index);
 
+    bool get_display_edges_self(std::vector<std::pair<bool, bool>> &edges,
+                           std::vector<std::pair<uint16_t, bool>> &togs,
+                           uint64_t start, uint64_t end, uint16_t width,
+                           uint16_t max_togs, double pixels_offset,
+                           double min_length, uint16_t sig_index);
+
     bool pattern_search_self(int64_t start, int64_t end, int64_t& index,
                         std::map<uint16_t, QString> &pattern, bool isNext);
 
+    bool pattern_match_words(uint64_t &q, uint64_t qlo, uint64_t qhi,
+                        const char *flagList, const int *orders, int count, bool isNext);
+
+    uint64_t get_word_self(uint64_t word_index, int order);
+
+    uint64_t get_edge_free_words(uint64_t word_index, int order, bool isNext);
+
+    void get_range_stats_self(uint64_t start, uint64_t end, int order,
+                        struct RangeStats &stats, bool with_pulses);
+
     int get_ch_order(int sig_index);
 
-    void calc_mipmap(unsigned int order, uint8_t index0, uint8_t index1, uint64_t samples, bool isEnd);
+    bool calc_mipmap(unsigned int order, void *lbp, uint64_t samples, bool isEnd, struct LeafStats &stats);
+
+    void publish_mipmap(unsigned int order, uint64_t index0, uint64_t index1,
+                        bool toggled, bool isEnd, const struct LeafStats &stats);
+
+    void calc_leaf_stats(const uint64_t *src_ptr, struct LeafStats &st);
+
+    void calc_mipmap_pass(std::unique_lock<std::mutex> &lock, bool unlock_compute);
+
+    void update_ring_sample_count();
+
+    void start_mipmap_worker();
+
+    void mipmap_proc();
+
+    bool get_leaf_stats_self(uint64_t index, int order, struct LeafStats &stats);
 
     void append_cross_payload(const sr_datafeed_logic &logic);
 
@@ -243,10 +392,26 @@ private:
         return hb ? 32 + bsr32((uint32_t)hb) : bsr32((uint32_t)bb);
     }
 
+    inline uint8_t popcount64(uint64_t bb)
+    {
+        bb = bb - ((bb >> 1) & 0x5555555555555555ULL);
+        bb = (bb & 0x3333333333333333ULL) + ((bb >> 2) & 0x3333333333333333ULL);
+        bb = (bb + (bb >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (uint8_t)((bb * 0x0101010101010101ULL) >> 56);
+    }
+
     void move_first_node_to_last();
 
     void free_head_blocks(int count);
 
+    void free_head_block(void *lbp);
+
+    void free_leaf_block_later(void *lbp);
+
+    void unref_decode_lpb(void *lbp);
+    // Call it with the mutex held.
+    void notify_data_changed();
+
 private:
     std::vector<std::vector<struct RootNode>> _ch_data;
     uint8_t     _byte_fraction;
@@ -257,11 +422,34 @@ private:
     uint64_t    _last_calc_count[CHANNEL_MAX_COUNT];
     bool        _is_loop;
     volatile uint64_t   _loop_offset;
-    bool        _able_free;
+    uint64_t    _loop_discarded; // samples of the root nodes moved to the ring end
     std::vector<void*> _free_block_list;
-    struct BlockIndex _cur_ref_block_indexs[CHANNEL_MAX_COUNT];
+    std::map<void*, int> _decode_lbp_refs; // the blocks held by the decoders, and their reader count
     int         _lst_free_block_index;
     bool        _is_search_stop;
+    int         _decode_readers;
+    std::condition_variable _data_cond;
+    uint64_t    _data_seq;
+    std::vector<void*> _leaf_pool;
+    uint64_t    _pool_limit;
+    uint64_t    _pool_blocks; // the blocks allocated by the pool and not freed
+    uint64_t    _pool_hits;
+    uint64_t    _pool_misses;
+    bool        _pool_huge_page;
+
+    // The feed writes the samples up to the fill index, the worker builds their
+    // mipmap and publishes _ring_sample_count, the indexes count the dropped samples.
+    uint64_t    _fill_sample_count;
+    uint64_t    _fill_index;
+    uint64_t    _mipmap_index;
+    std::thread _mipmap_thread;
+    std::mutex  _mipmap_mutex; // held by a whole mipmap pass
+    std::condition_variable _mipmap_cond;
+    bool        _mipmap_exit;
+    void       *_mipmap_lbp; // the block the worker reads without the lock
+    bool        _mipmap_dropped;
+    std::vector<GMappedFile*> _mapped_files; // blocks point into these files
+    bool        _block_loaded;
  
 	friend class LogicSnapshotTest::Pow2;
 	friend class LogicSnapshotTest::Basic;
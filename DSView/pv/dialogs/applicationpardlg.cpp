@@ -31,6 +31,7 @@
 #include <QLabel>
 #include <vector>
 #include <QGridLayout>
+#include <thread>
 
 #include "../config/appconfig.h"
 #include "../ui/langresource.h"
@@ -132,6 +133,24 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
     QCheckBox *ck_autoScrollLatestData = new QCheckBox();
     ck_autoScrollLatestData->setChecked(app.appOptions.autoScrollLatestData);
 
+    QComboBox *cbDecodeThreads = new DsComboBox();
+    cbDecodeThreads->setFixedWidth(50);
+    cbDecodeThreads->addItem(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_AUTO), "Auto"));
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    for (int i = 1; i <= maxThreads || i <= app.appOptions.decodeThreadCount; i++){
+        cbDecodeThreads->addItem(QString::number(i));
+    }
+    cbDecodeThreads->setCurrentIndex(app.appOptions.decodeThreadCount > 0 ? app.appOptions.decodeThreadCount : 0);
+
+    QCheckBox *ck_saveMipmap = new QCheckBox();
+    ck_saveMipmap->setChecked(app.appOptions.saveMipmap);
+
+    QCheckBox *ck_hugePage = new QCheckBox();
+    ck_hugePage->setChecked(app.appOptions.hugePageBlocks);
+
+    QCheckBox *ck_paintTime = new QCheckBox();
+    ck_paintTime->setChecked(app.appOptions.paintTimeOverlay);
+
     QComboBox *ftCbSize = new DsComboBox();
     ftCbSize->setFixedWidth(50);
     bind_font_size_list(ftCbSize, app.appOptions.fontSize);
@@ -148,6 +167,12 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
     logicLay->addWidget(ck_abortData, 1, 1, Qt::AlignRight);
     logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_AUTO_SCROLL_LATEAST_DATA), "Auto scoll latest")), 2, 0, Qt::AlignLeft); 
     logicLay->addWidget(ck_autoScrollLatestData, 2, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_DECODE_THREADS), "Decode threads")), 3, 0, Qt::AlignLeft); 
+    logicLay->addWidget(cbDecodeThreads, 3, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_SAVE_MIPMAP), "Save files for fast loading")), 4, 0, Qt::AlignLeft); 
+    logicLay->addWidget(ck_saveMipmap, 4, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HUGE_PAGE_BLOCKS), "Use huge pages for captures")), 5, 0, Qt::AlignLeft); 
+    logicLay->addWidget(ck_hugePage, 5, 1, Qt::AlignRight);
     lay->addWidget(logicGroup);
 
     //Scope group
@@ -170,6 +195,8 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
     uiLay->addWidget(ck_profileBar, 0, 1, Qt::AlignRight);
     uiLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_FONT_SIZE), "Font size")), 1, 0, Qt::AlignLeft);
     uiLay->addWidget(ftCbSize, 1, 1, Qt::AlignRight);
+    uiLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_PAINT_TIME_OVERLAY), "Paint time overlay")), 2, 0, Qt::AlignLeft);
+    uiLay->addWidget(ck_paintTime, 2, 1, Qt::AlignRight);
     lay->addWidget(uiGroup);
 
     dlg.layout()->addLayout(lay);      
@@ -207,6 +234,22 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
             app.appOptions.autoScrollLatestData = ck_autoScrollLatestData->isChecked();
             bAppChanged = true;
         }
+        if (app.appOptions.decodeThreadCount != cbDecodeThreads->currentIndex()){
+            app.appOptions.decodeThreadCount = cbDecodeThreads->currentIndex();
+            bAppChanged = true;
+        }
+        if (app.appOptions.saveMipmap != ck_saveMipmap->isChecked()){
+            app.appOptions.saveMipmap = ck_saveMipmap->isChecked();
+            bAppChanged = true;
+        }
+        if (app.appOptions.hugePageBlocks != ck_hugePage->isChecked()){
+            app.appOptions.hugePageBlocks = ck_hugePage->isChecked();
+            bAppChanged = true;
+        }
+        if (app.appOptions.paintTimeOverlay != ck_paintTime->isChecked()){
+            app.appOptions.paintTimeOverlay = ck_paintTime->isChecked();
+            bAppChanged = true;
+        }
  
         if (bAppChanged){
             app.SaveApp();
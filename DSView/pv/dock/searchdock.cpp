@@ -45,6 +45,8 @@
 #include "../appcontrol.h"
 #include "../ui/fn.h"
 #include "../log.h"
+#include <algorithm>
+#include <ds_types.h>
 
 
 class EdgeSearchProgressDialog : public QProgressDialog
@@ -110,12 +112,19 @@ SearchDock::SearchDock(QWidget *parent, View &view, SigSession *session) :
     layout->addWidget(&_pre_button);
     layout->addWidget(_search_value);
     layout->addWidget(&_nxt_button);
+    layout->addWidget(&_all_button);
+    layout->addWidget(&_hit_box);
     layout->addStretch(1);
 
+    _hit_box.setVisible(false);
+
     setLayout(layout);
 
     connect(&_pre_button, SIGNAL(clicked()), this, SLOT(on_previous()));
     connect(&_nxt_button, SIGNAL(clicked()),this, SLOT(on_next()));
+    connect(&_all_button, SIGNAL(clicked()),this, SLOT(on_find_all()));
+    connect(this, SIGNAL(sig_hits_found()), this, SLOT(on_hits_found()), Qt::QueuedConnection);
+    connect(&_hit_box, SIGNAL(valueChanged(int)),this, SLOT(on_hit_changed(int)));
 
     ADD_UI(this);
 }
@@ -128,6 +137,7 @@ SearchDock::~SearchDock()
 void SearchDock::retranslateUi()
 {
     _search_value->setPlaceholderText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_SEARCH), "search"));
+    _all_button.setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_FIND_ALL), "All"));
 }
 
 void SearchDock::reStyle()
@@ -172,6 +182,20 @@ void SearchDock::on_previous()
         MsgBox::Show(strMsg);
         return;
     }
+
+    // Step in the result of find all.
+    const std::vector<uint64_t> &hits = _view.get_search_hits();
+    if (!hits.empty()) {
+        auto it = std::lower_bound(hits.begin(), hits.end(), (uint64_t)last_pos);
+        if (it == hits.begin()) {
+            QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_PATTERN_NOT_FOUND), "Pattern not found!"));
+            MsgBox::Show(strMsg);
+        }
+        else {
+            set_hit_index((int)(it - hits.begin()));
+        }
+        return;
+    }
     else {
         QFuture<void> future;
 
@@ -236,6 +260,20 @@ void SearchDock::on_next()
         MsgBox::Show(strMsg);
         return;
     }
+
+    // Step in the result of find all.
+    const std::vector<uint64_t> &hits = _view.get_search_hits();
+    if (!hits.empty()) {
+        auto it = std::upper_bound(hits.begin(), hits.end(), _view.get_search_pos());
+        if (it == hits.end()) {
+            QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_PATTERN_NOT_FOUND), "Pattern not found!"));
+            MsgBox::Show(strMsg);
+        }
+        else {
+            set_hit_index((int)(it - hits.begin()) + 1);
+        }
+        return;
+    }
     else {
         QFuture<void> future;
 
@@ -271,6 +309,113 @@ void SearchDock::on_next()
     }
 }
 
+void SearchDock::on_find_all()
+{
+    if (_is_busy){
+        dsv_info("The searching task is busy,please wait.");
+        return;
+    }
+
+    _is_cancel = false;
+
+    bool ret;
+    std::vector<uint64_t> hits;
+    const auto snapshot = _session->get_snapshot(SR_CHANNEL_LOGIC);
+    assert(snapshot);
+    const auto logic_snapshot = dynamic_cast<data::LogicSnapshot*>(snapshot);
+
+    if (logic_snapshot == NULL || logic_snapshot->empty()) {
+        QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_NO_SAMPLE_DATA), "No Sample data!"));
+        MsgBox::Show(strMsg);
+        return;
+    }
+
+    const int64_t end = logic_snapshot->get_sample_count() - 1;
+
+    // The hits are shown on the ruler as they are found.
+    std::vector<uint64_t> no_hits;
+    _view.set_search_hits(no_hits);
+    update_hit_box();
+
+    QFuture<void> future;
+
+    future = QtConcurrent::run([&]{
+        _is_busy = true;
+        ret = logic_snapshot->pattern_search_all(0, end, hits, _pattern, MaxSearchHits,
+            [this](const std::vector<uint64_t> &found){
+                {
+                    std::lock_guard<std::mutex> lock(_found_mutex);
+                    _found_hits.insert(_found_hits.end(), found.begin(), found.end());
+                }
+                sig_hits_found();
+            });
+        _is_busy = false;
+    });
+
+    QString title = L_S(STR_PAGE_DLG, S_ID(IDS_DLG_SEARCH_ALL), "Search All...");
+    QString cancelText = L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CANCEL), "Cancel");
+    EdgeSearchProgressDialog dlg(this, title, cancelText);
+    dlg.setWindowModality(Qt::WindowModal);
+    dlg.setWindowFlags(Qt::Dialog | Qt::FramelessWindowHint | Qt::WindowSystemMenuHint |
+                        Qt::WindowMinimizeButtonHint | Qt::WindowMaximizeButtonHint);
+
+    QFutureWatcher<void> watcher;
+    connect(&watcher, SIGNAL(finished()), &dlg, SLOT(cancel()));
+    connect(&dlg, SIGNAL(canceled()), SLOT(on_progress_cancel()));
+    watcher.setFuture(future);
+    dlg.exec();
+
+    // The whole result replaces the hits shown so far.
+    {
+        std::lock_guard<std::mutex> lock(_found_mutex);
+        _found_hits.clear();
+    }
+
+    if (!ret || hits.empty()) {
+        hits.clear();
+        QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_PATTERN_NOT_FOUND), "Pattern not found!"));
+        if (!_is_cancel){
+            MsgBox::Show(strMsg);
+        }
+    }
+
+    dsv_info("Search all, hit count:%llu", (u64_t)hits.size());
+
+    _view.set_search_hits(hits);
+    update_hit_box();
+}
+
+void SearchDock::update_hit_box()
+{
+    const std::vector<uint64_t> &hits = _view.get_search_hits();
+
+    _hit_box.blockSignals(true);
+    _hit_box.setRange(hits.empty() ? 0 : 1, (int)hits.size());
+    _hit_box.setSuffix(QString(" / %1").arg(hits.size()));
+    _hit_box.blockSignals(false);
+    _hit_box.setVisible(!hits.empty());
+
+    if (!hits.empty())
+        set_hit_index(1);
+}
+
+void SearchDock::set_hit_index(int value)
+{
+    _hit_box.blockSignals(true);
+    _hit_box.setValue(value);
+    _hit_box.blockSignals(false);
+    on_hit_changed(value);
+}
+
+// Jump to a hit of find all, the hit number starts from 1.
+void SearchDock::on_hit_changed(int value)
+{
+    const std::vector<uint64_t> &hits = _view.get_search_hits();
+
+    if (value > 0 && value <= (int)hits.size())
+        _view.set_search_pos(hits[value - 1], true);
+}
+
 void SearchDock::on_progress_cancel()
 {
     const auto snapshot = _session->get_snapshot(SR_CHANNEL_LOGIC);
@@ -283,6 +428,19 @@ void SearchDock::on_progress_cancel()
     }
 }
 
+void SearchDock::on_hits_found()
+{
+    std::vector<uint64_t> found;
+
+    {
+        std::lock_guard<std::mutex> lock(_found_mutex);
+        found.swap(_found_hits);
+    }
+
+    if (!found.empty())
+        _view.append_search_hits(found);
+}
+
 void SearchDock::on_set()
 {
     dialogs::Search dlg(this, _session, _pattern);
@@ -307,6 +465,10 @@ void SearchDock::on_set()
         if (new_pattern != _pattern) {
             _view.set_search_pos(_view.get_search_pos(), false);
             _pattern = new_pattern;
+
+            std::vector<uint64_t> hits;
+            _view.set_search_hits(hits);
+            update_hit_box();
         }
     }
 }
@@ -31,6 +31,7 @@
 #include <QLineEdit>
 #include <QTableWidget>
 #include <QCheckBox>
+#include <QSpinBox>
 
 #include <QVector>
 #include <QGridLayout>
@@ -38,6 +39,7 @@
 #include <QHBoxLayout>
 
 #include <vector>
+#include <mutex>
 
 #include "../widgets/fakelineedit.h"
 #include "../ui/dscombobox.h"
@@ -62,6 +64,10 @@ class SearchDock : public QWidget, public IUiWindow
 {
     Q_OBJECT
 
+private:
+    // The memory of the find all result is limited.
+    static const uint64_t MaxSearchHits = 1ULL << 24;
+
 public:
     SearchDock(QWidget *parent, pv::view::View &view, SigSession *session);
     ~SearchDock();
@@ -77,11 +83,20 @@ private:
     void UpdateTheme() override;
     void UpdateFont() override;
 
+    void update_hit_box();
+    void set_hit_index(int value);
+
+signals:
+    void sig_hits_found();
+
 public slots:
     void on_previous();
     void on_next();
+    void on_find_all();
+    void on_hit_changed(int value);
     void on_set();
     void on_progress_cancel();
+    void on_hits_found();
 
 private:
     SigSession *_session;
@@ -90,10 +105,15 @@ private:
 
     QPushButton _pre_button;
     QPushButton _nxt_button;
+    QPushButton _all_button;
+    QSpinBox    _hit_box;
     widgets::FakeLineEdit* _search_value;
     QPushButton *_search_button;
     bool         _is_busy;
     bool         _is_cancel;
+    // The hits of find all not shown yet, filled by the search thread.
+    std::vector<uint64_t> _found_hits;
+    std::mutex   _found_mutex;
 };
 
 } // namespace dock
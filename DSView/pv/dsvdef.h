@@ -56,7 +56,8 @@ enum View_type {
 #define ds_min(a,b) ((a) < (b) ? (a) : (b))
 
 #define SESSION_FORMAT_VERSION      3
-#define HEADER_FORMAT_VERSION       3
+// 4: a constant logic block is an empty entry, libsigrok rejects newer versions
+#define HEADER_FORMAT_VERSION       4
 
 namespace DecoderDataFormat
 {
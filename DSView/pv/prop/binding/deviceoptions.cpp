@@ -110,11 +110,21 @@ DeviceOptions::DeviceOptions()
             bind_double(name, label, key, "V", pair<double, double>(0.0, 5.0), 1, 0.1);
             break;
 
+        case SR_CONF_DEMO_EDGE_DENSITY:
+            bind_double(name, label, key, "", pair<double, double>(0.0, 1.0), 3, 0.001);
+            break;
+
+        case SR_CONF_DEMO_PACKET_SIZE:
+            bind_int(name, label, key, "B", pair<int64_t, int64_t>(0, SR_MB(16)));
+            break;
+
 		case SR_CONF_RLE:
         case SR_CONF_RLE_SUPPORT:
         case SR_CONF_CLOCK_TYPE:
         case SR_CONF_CLOCK_EDGE:
         case SR_CONF_INSTANT:
+        case SR_CONF_DEMO_THROUGHPUT:
+        case SR_CONF_ADAPTIVE_TRANSFER:
             bind_bool(name, label, key);
             break;
 
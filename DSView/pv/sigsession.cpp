@@ -47,6 +47,7 @@
 #include <stdexcept>
 #include <sys/stat.h>
 #include <map>
+#include <algorithm>
 #include <QString>
 
 #include "data/decode/decoderstatus.h"
@@ -118,6 +119,7 @@ namespace pv
         _lissajous_trace = NULL;
         _math_trace = NULL;
         _is_decoding = false;
+        _decode_worker_count = 0;
         _bClose = false;
         _callback = NULL;
         _work_time_id = 0;
@@ -686,7 +688,8 @@ namespace pv
             }
             else if (is_loop_mode())
             {
-                 
+                // The decoder follows the ring while it is being filled.
+                bAddDecoder = true;
             }
         }
 
@@ -1224,13 +1227,11 @@ namespace pv
         if (_capture_data->get_logic()->last_ended())
         {
             _capture_data->get_logic()->set_loop(is_loop_mode());
-
-            bool bNotFree = _is_decoding && _view_data == _capture_data;
+            _capture_data->get_logic()->set_huge_page(AppConfig::Instance().appOptions.hugePageBlocks);
 
             _capture_data->get_logic()->first_payload(o, 
                             _device_agent.get_sample_limit(),
-                            _device_agent.get_channels(),
-                            !bNotFree);
+                            _device_agent.get_channels());
 
             // @todo Putting this here means that only listeners querying
             // for logic will be notified. Currently the only user of
@@ -1256,6 +1257,44 @@ namespace pv
         _data_updated = true;
     }
 
+    void SigSession::feed_in_logic_block(const sr_datafeed_logic_block &o)
+    {
+        auto logic_data = _capture_data->get_logic();
+        bool ret;
+
+        if (!_is_triged)
+        {
+            _is_triged = true;
+            _trig_time = QDateTime::currentDateTime();
+        }
+
+        if (logic_data->last_ended())
+        {
+            logic_data->set_loop(false);
+            ret = logic_data->first_block(o,
+                            _device_agent.get_sample_limit(),
+                            _device_agent.get_channels());
+            _callback->frame_began();
+        }
+        else
+        {
+            ret = logic_data->append_block(o);
+        }
+
+        if (!ret)
+        {
+            _error = logic_data->memory_failed() ? Malloc_err : Pkt_data_err;
+            _callback->session_error();
+            return;
+        }
+
+        if (o.order == 0){
+            set_receive_data_len(o.data_len * 8);
+        }
+
+        _data_updated = true;
+    }
+
     void SigSession::feed_in_dso(const sr_datafeed_dso &o)
     {
         if (_capture_data->get_dso()->memory_failed())
@@ -1434,6 +1473,12 @@ namespace pv
             feed_in_logic(*(const sr_datafeed_logic *)packet->payload);
             break;
 
+        case SR_DF_LOGIC_BLOCK:
+            assert(packet->payload);
+            assert(!_is_task_end);
+            feed_in_logic_block(*(const sr_datafeed_logic_block *)packet->payload);
+            break;
+
         case SR_DF_DSO:
             assert(packet->payload);
             assert(!_is_task_end);
@@ -1890,17 +1935,30 @@ namespace pv
         _session = NULL;
     }
 
-    // append a decode task, and try create a thread
+    // append a decode task, and start a new worker if the pool is not full
     void SigSession::add_decode_task(view::DecodeTrace *trace)
     {
         std::lock_guard<std::mutex> lock(_decode_task_mutex);
         _decode_tasks.push_back(trace);
 
-        if (!_is_decoding){
-            if (_decode_thread.joinable())
-                _decode_thread.join();
+        // Join the workers which have run out of tasks.
+        for (auto it = _decode_threads.begin(); it != _decode_threads.end();)
+        {
+            auto fd = std::find(_decode_exited_threads.begin(), _decode_exited_threads.end(), it->get_id());
 
-            _decode_thread = std::thread(&SigSession::decode_task_proc, this);
+            if (fd != _decode_exited_threads.end()){
+                it->join();
+                _decode_exited_threads.erase(fd);
+                it = _decode_threads.erase(it);
+            }
+            else{
+                it++;
+            }
+        }
+
+        if (_decode_worker_count < get_decode_thread_limit()){
+            _decode_threads.push_back(std::thread(&SigSession::decode_task_proc, this));
+            _decode_worker_count++;
             _is_decoding = true;
         }
     }
@@ -1978,9 +2036,20 @@ namespace pv
             dex++;
         }
 
-        // Wait the thread end.
-        if (_decode_thread.joinable())
-            _decode_thread.join();
+        // Wait all the threads end.
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(_decode_task_mutex);
+            threads.swap(_decode_threads);
+        }
+
+        for (auto &t : threads){
+            if (t.joinable())
+                t.join();
+        }
+
+        std::lock_guard<std::mutex> lock(_decode_task_mutex);
+        _decode_exited_threads.clear();
     }
 
     view::DecodeTrace *SigSession::get_decoder_trace(int index)
@@ -2004,10 +2073,27 @@ namespace pv
             return p;
         }
 
+        // No more task, the calling worker will exit.
+        _decode_exited_threads.push_back(std::this_thread::get_id());
+        _decode_worker_count--;
+        _is_decoding = _decode_worker_count > 0;
+
         return NULL;
     }
 
-    // the decode task thread proc
+    int SigSession::get_decode_thread_limit()
+    {
+        int num = AppConfig::Instance().appOptions.decodeThreadCount;
+
+        if (num <= 0){
+            // Keep one core for the ui and the data feed.
+            num = (int)std::thread::hardware_concurrency() - 1;
+        }
+
+        return num > 0 ? num : 1;
+    }
+
+    // the decode worker thread proc, stacks run at the same time on the read-only snapshot
     void SigSession::decode_task_proc()
     {
         dsv_info("------->decode thread start");
@@ -2035,10 +2121,7 @@ namespace pv
             task = get_top_decode_task();
         }
 
-        _view_data->get_logic()->decode_end();
-
         dsv_info("------->decode thread end");
-        _is_decoding = false;        
     }
 
     Snapshot *SigSession::get_signal_snapshot()
@@ -2266,10 +2349,6 @@ namespace pv
                             bSwapBuffer = true;
                         }
                     }
-                    else if (is_loop_mode())
-                    {
-                        bAddDecoder = true;
-                    }
 
                     if (is_repeat_mode())
                     {
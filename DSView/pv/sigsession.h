@@ -490,6 +490,7 @@ private:
    
     void decode_task_proc();
     view::DecodeTrace* get_top_decode_task();    
+    int get_decode_thread_limit();
 
     void capture_init(); 
     void nodata_timeout();
@@ -525,6 +526,7 @@ private:
 	void feed_in_meta(const sr_dev_inst *sdi, const sr_datafeed_meta &meta);
     void feed_in_trigger(const ds_trigger_pos &trigger_pos);
 	void feed_in_logic(const sr_datafeed_logic &o);
+    void feed_in_logic_block(const sr_datafeed_logic_block &o);
 
     void feed_in_dso(const sr_datafeed_dso &o);
 	void feed_in_analog(const sr_datafeed_analog &o);    
@@ -560,7 +562,9 @@ private:
     mutable std::mutex      _sampling_mutex;
     mutable std::mutex      _data_mutex;
     mutable std::mutex      _decode_task_mutex;  
-    std::thread             _decode_thread;
+    std::vector<std::thread> _decode_threads;
+    std::vector<std::thread::id> _decode_exited_threads;
+    int                     _decode_worker_count;
     volatile bool           _is_decoding;
  
 	std::vector<view::Signal*>      _signals; 
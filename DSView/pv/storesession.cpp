@@ -38,6 +38,7 @@
 #include "view/dsosignal.h"
 #include "view/decodetrace.h"
 #include "dock/protocoldock.h" 
+#include "utility/bittranspose.h"
  
 #include <QFileDialog>
 #include <QDir>
@@ -45,10 +46,17 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QStandardPaths>
+#include <QFileInfo>
 #include <math.h>
 #include <QTextStream>
 #include <list>
 #include <string.h>
+#include <chrono>
+#include <queue>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <QTextCodec>
@@ -60,6 +68,7 @@
 #include "utility/encoding.h"
 #include "utility/path.h"
 #include "log.h" 
+#include <ds_types.h>
 #include "ui/langresource.h"
  #include "utility/formatting.h"
 
@@ -191,6 +200,28 @@ bool StoreSession::save_start()
         return false;
     }
    
+    // The blocks of a file opened with its mipmap point into the file mapping,
+    // they must not be cut off by writing the same file.
+    data::LogicSnapshot *logic_snapshot = dynamic_cast<data::LogicSnapshot*>(snapshot);
+    QString open_file = _session->get_device()->path();
+
+    if (logic_snapshot != NULL
+        && logic_snapshot->has_mapped_blocks()
+        && _session->get_device()->is_file()
+        && QFileInfo(_file_name).canonicalFilePath() == QFileInfo(open_file).canonicalFilePath()
+        && !logic_snapshot->copy_mapped_blocks())
+    {
+        if (logic_snapshot->memory_failed()){
+            _error = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_STORESESS_SAVEPROC_ERROR1),
+                        "Failed to create zip file,malloc error.");
+        }
+        else{
+            _error = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_STORESESS_SAVESTART_ERROR8),
+                        "The file is being decoded, please save it again when decoding ends.");
+        }
+        return false;
+    }
+
     auto _filename = path::ConvertPath(_file_name);
     
     if (m_zipDoc.CreateNew(_filename.c_str(), false))
@@ -275,10 +306,31 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
         _unit_count = end_index / 8 * to_save_probes;
     }
 
+    // Blocks are deflated on worker threads and written to the zip in order.
+    struct SaveBlock
+    {
+        int ch_index;
+        int chunk_num;
+        const uint8_t *buf; // NULL if the block has one level
+        uint64_t size;
+        bool level;
+        bool leaf; // stored with the mipmap, not compressed
+        bool ready;
+        bool ok;
+        ZipDeflateData zdata;
+    };
+
+    std::vector<SaveBlock> blocks;
+
+    // Whole leaf blocks can be saved with the mipmap, for mapping them on load.
+    const bool save_leaf = AppConfig::Instance().appOptions.saveMipmap
+                            && start_index == 0
+                            && end_index == 0
+                            && logic_snapshot->get_loop_offset() == 0;
+
     for(auto s : _session->get_signals()) 
     { 
-        int ch_type = s->get_type();
-        if (ch_type != SR_CHANNEL_LOGIC){
+        if (s->get_type() != SR_CHANNEL_LOGIC){
             continue;
         }
 
@@ -287,7 +339,7 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
             continue;
         }
 
-        for (int i = 0; !_canceled && i < block_count; i++) 
+        for (int i = 0; i < block_count; i++) 
         {
             if (i < start_block){
                 continue;
@@ -299,7 +351,6 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
             bool flag = false;
             uint8_t *block_buf = logic_snapshot->get_block_buf(i, ch_index, flag);
             uint64_t block_size = logic_snapshot->get_block_size(i);
-            bool need_malloc = (block_buf == NULL);
 
             if (i == end_block && end_offset / 8 < block_size && end_offset > 0){
                 block_size = end_offset / 8;
@@ -311,53 +362,164 @@ void StoreSession::save_logic(pv::data::LogicSnapshot *logic_snapshot)
                 }
                 block_size -= start_offset / 8;
             }
-                
-            if (need_malloc) {
-                block_buf = (uint8_t *)malloc(block_size);
-                if (block_buf == NULL) {
-                    _has_error = true;
-                    _error = L_S(STR_PAGE_DLG, S_ID(IDS_MSG_STORESESS_SAVEPROC_ERROR1), 
-                                "Failed to create zip file. Malloc error.");
-                }
-                else {
-                    memset(block_buf, flag ? 0xff : 0x0, block_size);
-                }
-            }
-            
-            MakeChunkName(chunk_name, i - start_block, ch_index, ch_type, HEADER_FORMAT_VERSION);
-            int ret = m_zipDoc.AddFromBuffer(chunk_name, (const char*)block_buf, block_size) ? SR_OK : -1;
 
-            if (ret != SR_OK) {
-                if (!_has_error) {
-                    _has_error = true;
-                    _error = L_S(STR_PAGE_DLG, S_ID(IDS_MSG_STORESESS_SAVEPROC_ERROR2), 
-                                "Failed to create zip file. Please check write permission of this path.");
-                }
-                progress_updated();
+            SaveBlock blk;
+            blk.ch_index = ch_index;
+            blk.chunk_num = i - start_block;
+            blk.buf = block_buf;
+            blk.size = block_size;
+            blk.level = flag;
+            blk.leaf = save_leaf && block_buf != NULL;
+            blk.ready = false;
+            blk.ok = false;
+            blocks.push_back(blk);
+        }
+    }
 
-                if (_has_error){
-                    QFile::remove(_file_name);
-                }
-                if (need_malloc){
-                    free(block_buf);
-                }
+    const int compress_level = m_zipDoc.m_opt_compress_level;
+    const int worker_count = std::max(1, (int)std::thread::hardware_concurrency());
+    const size_t window = worker_count * 2;
+    std::mutex mtx;
+    std::condition_variable cond;
+    size_t next_job = 0;
+    size_t next_write = 0;
+    bool stop = false;
 
-                return;
+    auto deflate_proc = [&]() {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        while (true)
+        {
+            // Keep only a few compressed blocks waiting for the writer.
+            cond.wait(lock, [&]{
+                return stop || next_job >= blocks.size() || next_job < next_write + window;
+            });
+
+            if (stop || _canceled || next_job >= blocks.size()){
+                break;
             }
-            _units_stored += block_size;
 
-            if (_units_stored > _unit_count 
-                    && start_index == 0
-                    && end_index == 0){
-                dsv_err("Read block data error!");
-                assert(false);
+            SaveBlock &blk = blocks[next_job++];
+            lock.unlock();
+
+            if (blk.buf != NULL && !blk.leaf){
+                blk.ok = ZipMaker::Deflate((const char*)blk.buf, blk.size, compress_level, blk.zdata);
             }
+            else{
+                blk.ok = true;
+            }
+
+            lock.lock();
+            blk.ready = true;
+            cond.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < worker_count; i++){
+        workers.push_back(std::thread(deflate_proc));
+    }
+
+    bool failed = false;
+
+    for (; !_canceled && next_write < blocks.size();)
+    {
+        SaveBlock &blk = blocks[next_write];
 
-            if (need_malloc){
-                free(block_buf);
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (!blk.ready && !_canceled){
+                cond.wait_for(lock, std::chrono::milliseconds(100));
             }
-            progress_updated();
-        }        
+        }
+        if (_canceled){
+            break;
+        }
+
+        MakeChunkName(chunk_name, blk.chunk_num, blk.ch_index, SR_CHANNEL_LOGIC, HEADER_FORMAT_VERSION);
+        bool ret = blk.ok;
+
+        if (ret && blk.buf == NULL){
+            unsigned char extra[4 + SR_SESSION_CONST_BLOCK_LEN];
+            extra[0] = SR_SESSION_CONST_BLOCK_ID & 0xff;
+            extra[1] = SR_SESSION_CONST_BLOCK_ID >> 8;
+            extra[2] = SR_SESSION_CONST_BLOCK_LEN;
+            extra[3] = 0;
+            for (int k = 0; k < 8; k++){
+                extra[4 + k] = (blk.size >> (k * 8)) & 0xff;
+            }
+            extra[12] = blk.level ? 0xff : 0x0;
+            ret = m_zipDoc.AddFromBuffer(chunk_name, NULL, 0, extra, sizeof(extra));
+        }
+        else if (ret && blk.leaf){
+            unsigned char extra[4 + SR_SESSION_LEAF_BLOCK_LEN];
+            extra[0] = SR_SESSION_LEAF_BLOCK_ID & 0xff;
+            extra[1] = SR_SESSION_LEAF_BLOCK_ID >> 8;
+            extra[2] = SR_SESSION_LEAF_BLOCK_LEN;
+            extra[3] = 0;
+            for (int k = 0; k < 8; k++){
+                extra[4 + k] = (blk.size >> (k * 8)) & 0xff;
+            }
+            extra[12] = data::LogicSnapshot::get_scale_power();
+            extra[13] = data::LogicSnapshot::get_scale_level();
+            // Aligned for the loader to use the mapped block in place.
+            ret = m_zipDoc.AddStored(chunk_name, (const char*)blk.buf,
+                        data::LogicSnapshot::get_leaf_block_space(), extra, sizeof(extra),
+                        sizeof(uint64_t));
+        }
+        else if (ret){
+            ret = m_zipDoc.AddDeflated(chunk_name, blk.zdata);
+        }
+
+        std::vector<unsigned char>().swap(blk.zdata.data);
+
+        if (!blk.ok) {
+            _has_error = true;
+            _error = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_STORESESS_SAVEPROC_ERROR3), 
+                        "Failed to create zip file, data compression error.");
+            failed = true;
+            break;
+        }
+
+        if (!ret) {
+            _has_error = true;
+            _error = L_S(STR_PAGE_DLG, S_ID(IDS_MSG_STORESESS_SAVEPROC_ERROR2), 
+                        "Failed to create zip file. Please check write permission of this path.");
+            failed = true;
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            next_write++;
+        }
+        cond.notify_all();
+
+        _units_stored += blk.size;
+
+        if (_units_stored > _unit_count 
+                && start_index == 0
+                && end_index == 0){
+            dsv_err("Read block data error!");
+            assert(false);
+        }
+        progress_updated();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cond.notify_all();
+
+    for (auto &t : workers){
+        t.join();
+    }
+
+    if (failed){
+        progress_updated();
+        QFile::remove(_file_name);
+        return;
     }
 
     progress_updated();
@@ -989,11 +1151,15 @@ void StoreSession::export_exec(data::Snapshot *snapshot)
     }
     g_slist_free(meta.config);
 
-    if (channel_type == SR_CHANNEL_LOGIC) {
+    if (channel_type == SR_CHANNEL_LOGIC && !strcmp(_outModule->id, "vcd")) {
+        export_logic_edges(logic_snapshot, &output, out);
+    }
+    else if (channel_type == SR_CHANNEL_LOGIC) {
         _unit_count = logic_snapshot->get_ring_sample_count();
         int blk_num = logic_snapshot->get_block_num();       
         std::vector<uint8_t *> buf_vec;
         std::vector<bool> buf_sample;
+        bool levels[CHANNEL_MAX_COUNT];
 
         uint64_t start_index = _start_index;
         uint64_t end_index = _end_index;
@@ -1069,6 +1235,9 @@ void StoreSession::export_exec(data::Snapshot *snapshot)
             }
 
             const uint16_t unitsize = ceil(buf_vec.size() / 8.0);
+            const int plane_count = buf_vec.size();
+            for (int k = 0; k < plane_count; k++)
+                levels[k] = buf_sample[k];
             unsigned int usize = 8192;
             unsigned int size = usize;
             const uint64_t buf_sample_num = block_size * 8;            
@@ -1086,16 +1255,8 @@ void StoreSession::export_exec(data::Snapshot *snapshot)
                     size = buf_sample_num - i;
                 }
 
-                memset(xbuf, 0, size * unitsize);
-
-                for (uint64_t j = 0; j < size; j++) {
-                    for (unsigned int k = 0; k < buf_vec.size(); k++) {
-                        if (buf_vec[k] == NULL && buf_sample[k])
-                            xbuf[j*unitsize+k/8] +=  1 << k%8;
-                        else if (buf_vec[k] && (buf_vec[k][(i+j)/8] & (1 << j%8)))
-                            xbuf[j*unitsize+k/8] +=  1 << k%8;
-                    }
-                }
+                bits::planes_to_units(buf_vec.data(), levels, plane_count,
+                                      i / 8, size, xbuf, unitsize);
 
                 lp.data = xbuf;
                 lp.length = size * unitsize;
@@ -1256,6 +1417,130 @@ void StoreSession::export_exec(data::Snapshot *snapshot)
 }
 
  
+void StoreSession::export_logic_edges(data::LogicSnapshot *logic_snapshot,
+                                      struct sr_output *output, QTextStream &out)
+{
+    struct EdgeCursor
+    {
+        uint64_t index;
+        int pos;
+
+        bool operator>(const EdgeCursor &other) const{
+            return index > other.index || (index == other.index && pos > other.pos);
+        }
+    };
+
+    const uint64_t ring_count = logic_snapshot->get_ring_sample_count();
+    uint64_t start_index = _start_index;
+    uint64_t end_index = (_end_index > 0 && _end_index <= ring_count) ? _end_index : ring_count;
+
+    if (start_index >= end_index){
+        dsv_err("ERROR:the start curosr is invalid!");
+        _units_stored = -1;
+        progress_updated();
+        return;
+    }
+
+    _unit_count = end_index - start_index;
+    const uint64_t last_index = end_index - 1;
+
+    // Channel position follows the cross format bit order used by the block export.
+    std::vector<int> ch_indexs;
+    for(auto s : _session->get_signals()) {
+        if (s->get_type() == SR_CHANNEL_LOGIC && logic_snapshot->has_data(s->get_index()))
+            ch_indexs.push_back(s->get_index());
+    }
+
+    const int ch_count = ch_indexs.size();
+    if (ch_count == 0)
+        return;
+
+    const uint64_t batch_size = 8192;
+    std::vector<uint64_t> samples;
+    std::vector<uint16_t> channels;
+    std::vector<uint8_t> levels;
+    samples.reserve(batch_size + ch_count);
+    channels.reserve(batch_size + ch_count);
+    levels.reserve(batch_size + ch_count);
+
+    std::vector<bool> cur_levels(ch_count);
+    std::priority_queue<EdgeCursor, std::vector<EdgeCursor>, std::greater<EdgeCursor>> heap;
+
+    // The first sample carries the initial value of every channel.
+    for (int pos = 0; pos < ch_count; pos++) {
+        bool sample = logic_snapshot->get_sample(start_index, ch_indexs[pos]);
+        cur_levels[pos] = sample;
+        samples.push_back(0);
+        channels.push_back(pos);
+        levels.push_back(sample);
+
+        uint64_t index = start_index + 1;
+        if (index <= last_index
+            && logic_snapshot->get_nxt_edge(index, sample, last_index, 1, ch_indexs[pos])) {
+            heap.push({index, pos});
+        }
+    }
+
+    struct sr_datafeed_logic_edge ep;
+    struct sr_datafeed_packet p;
+    GString *data_out;
+    uint64_t edge_count = 0;
+
+    auto flush = [&](uint64_t length) {
+        ep.count = samples.size();
+        ep.samples = samples.data();
+        ep.channels = channels.data();
+        ep.levels = levels.data();
+        ep.length = length;
+        p.type = SR_DF_LOGIC_EDGE;
+        p.status = SR_PKT_OK;
+        p.payload = &ep;
+        p.bExportOriginalData = 0;
+        _outModule->receive(output, &p, &data_out);
+
+        if(data_out){
+            out << QString::fromUtf8((char*) data_out->str);
+            g_string_free(data_out,TRUE);
+        }
+
+        edge_count += samples.size();
+        samples.clear();
+        channels.clear();
+        levels.clear();
+        _units_stored = length;
+        progress_updated();
+    };
+
+    while (!_canceled && !heap.empty()) {
+        const uint64_t index = heap.top().index;
+
+        // Keep all changes of one timestamp inside the same packet.
+        if (samples.size() >= batch_size)
+            flush(index - start_index);
+
+        while (!heap.empty() && heap.top().index == index) {
+            const int pos = heap.top().pos;
+            heap.pop();
+
+            bool sample = !cur_levels[pos];
+            cur_levels[pos] = sample;
+            samples.push_back(index - start_index);
+            channels.push_back(pos);
+            levels.push_back(sample);
+
+            uint64_t nxt = index;
+            if (logic_snapshot->get_nxt_edge(nxt, sample, last_index, 1, ch_indexs[pos]))
+                heap.push({nxt, pos});
+        }
+    }
+
+    if (!_canceled)
+        flush(_unit_count);
+
+    dsv_info("VCD export: %llu changes over %llu samples.",
+            (u64_t)edge_count, (u64_t)_unit_count);
+}
+
 bool StoreSession::decoders_gen(std::string &str)
 {  
     QJsonArray dec_array;
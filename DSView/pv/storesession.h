@@ -33,6 +33,8 @@
 
 #include "ZipMaker.h"
 
+class QTextStream;
+
 namespace pv {
 
 class SigSession;
@@ -72,6 +74,8 @@ private:
     bool meta_gen(data::Snapshot *snapshot, std::string &str);
     void export_proc(pv::data::Snapshot *snapshot);
     void export_exec(pv::data::Snapshot *snapshot);
+    void export_logic_edges(pv::data::LogicSnapshot *logic_snapshot,
+                            struct sr_output *output, QTextStream &out);
     bool decoders_gen(std::string &str);
  
 
@@ -0,0 +1,432 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "bittranspose.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BITS_HAVE_SSE2 1
+#endif
+
+// The AVX2 kernels are built for that target alone and picked at run time,
+// the rest of the build keeps the base instruction set.
+#if defined(BITS_HAVE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BITS_HAVE_AVX2 1
+#define BITS_TARGET_AVX2 __attribute__((target("avx2")))
+#define BITS_INLINE inline __attribute__((always_inline))
+#else
+#define BITS_INLINE inline
+#endif
+
+namespace pv
+{
+    namespace bits
+    {
+        uint64_t transpose8(uint64_t x)
+        {
+            uint64_t t;
+
+            t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+            x = x ^ t ^ (t << 7);
+            t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+            x = x ^ t ^ (t << 14);
+            t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+            x = x ^ t ^ (t << 28);
+
+            return x;
+        }
+
+        // Transpose 8 rows of 8 bytes, byte c of row k moves to byte k of row c.
+        static inline void transpose_bytes(uint64_t *w)
+        {
+            static const uint64_t masks[3] = {
+                0x00000000FFFFFFFFULL, 0x0000FFFF0000FFFFULL, 0x00FF00FF00FF00FFULL
+            };
+
+            for (int i = 0, j = 4; j > 0; i++, j >>= 1)
+            {
+                const int shift = j * 8;
+
+                for (int k = 0; k < 8; k = ((k | j) + 1) & ~j)
+                {
+                    uint64_t t = ((w[k] >> shift) ^ w[k + j]) & masks[i];
+                    w[k] ^= t << shift;
+                    w[k + j] ^= t;
+                }
+            }
+        }
+
+        static inline uint64_t load_plane_word(const uint8_t *p, uint64_t bytes)
+        {
+            uint64_t v = 0;
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86)
+            if (bytes == 8){
+                memcpy(&v, p, 8);
+                return v;
+            }
+#endif
+            for (uint64_t i = 0; i < bytes; i++){
+                v |= (uint64_t)p[i] << (i * 8);
+            }
+            return v;
+        }
+
+        SimdPath simd_path()
+        {
+#if defined(BITS_HAVE_AVX2)
+            static const SimdPath path = __builtin_cpu_supports("avx2") ? SIMD_AVX2 : SIMD_SSE2;
+            return path;
+#elif defined(BITS_HAVE_SSE2)
+            return SIMD_SSE2;
+#else
+            return SIMD_SCALAR;
+#endif
+        }
+
+#ifdef BITS_HAVE_AVX2
+        // transpose8() of 4 unit bytes at once.
+        static BITS_TARGET_AVX2 inline void transpose8_x4(const uint64_t *m, uint64_t b, int g, uint64_t *x)
+        {
+            __m256i v = _mm256_set_epi64x((long long)m[(g + 3) * 8 + b], (long long)m[(g + 2) * 8 + b],
+                                          (long long)m[(g + 1) * 8 + b], (long long)m[g * 8 + b]);
+            __m256i t;
+            t = _mm256_and_si256(_mm256_xor_si256(v, _mm256_srli_epi64(v, 7)), _mm256_set1_epi64x(0x00AA00AA00AA00AALL));
+            v = _mm256_xor_si256(_mm256_xor_si256(v, t), _mm256_slli_epi64(t, 7));
+            t = _mm256_and_si256(_mm256_xor_si256(v, _mm256_srli_epi64(v, 14)), _mm256_set1_epi64x(0x0000CCCC0000CCCCLL));
+            v = _mm256_xor_si256(_mm256_xor_si256(v, t), _mm256_slli_epi64(t, 14));
+            t = _mm256_and_si256(_mm256_xor_si256(v, _mm256_srli_epi64(v, 28)), _mm256_set1_epi64x(0x00000000F0F0F0F0LL));
+            v = _mm256_xor_si256(_mm256_xor_si256(v, t), _mm256_slli_epi64(t, 28));
+            _mm256_storeu_si256((__m256i*)(x + g), v);
+        }
+#endif
+
+        // Path is the best vector path the caller's target allows.
+        template<SimdPath Path>
+        static BITS_INLINE void planes_to_units_p(const uint8_t *const *planes, const bool *levels, int plane_count,
+                            uint64_t byte_offset, uint64_t sample_count, uint8_t *dest, int unitsize)
+        {
+            // Row k holds 64 samples of channel k.
+            uint64_t m[64];
+            const int rows = unitsize * 8;
+
+            for (uint64_t s = 0; s < sample_count; s += 64)
+            {
+                const uint64_t n = (sample_count - s < 64) ? sample_count - s : 64;
+                const uint64_t bytes = (n + 7) / 8;
+
+                for (int k = 0; k < plane_count; k++){
+                    if (planes[k] == NULL)
+                        m[k] = levels[k] ? ~0ULL : 0ULL;
+                    else
+                        m[k] = load_plane_word(planes[k] + byte_offset + s / 8, bytes);
+                }
+                for (int k = plane_count; k < rows; k++){
+                    m[k] = 0;
+                }
+
+                // Now row 8 * g + b holds byte b of the channels in group g,
+                // byte r is channel 8 * g + r.
+                for (int g = 0; g < unitsize; g++){
+                    transpose_bytes(m + g * 8);
+                }
+
+                for (uint64_t b = 0; b < bytes; b++)
+                {
+                    uint8_t *wr = dest + (s + b * 8) * unitsize;
+                    const int cnt = (n - b * 8 < 8) ? (int)(n - b * 8) : 8;
+                    // Byte t of x[g] is the unit byte g of sample 8 * b + t.
+                    uint64_t x[8];
+                    int g = 0;
+
+#ifdef BITS_HAVE_AVX2
+                    if (Path >= SIMD_AVX2){
+                        for (; g + 4 <= unitsize; g += 4){
+                            transpose8_x4(m, b, g, x);
+                        }
+                    }
+#endif
+#ifdef BITS_HAVE_SSE2
+                    for (; Path >= SIMD_SSE2 && g + 2 <= unitsize; g += 2)
+                    {
+                        __m128i v = _mm_set_epi64x((long long)m[(g + 1) * 8 + b], (long long)m[g * 8 + b]);
+                        __m128i t;
+                        t = _mm_and_si128(_mm_xor_si128(v, _mm_srli_epi64(v, 7)), _mm_set1_epi64x(0x00AA00AA00AA00AALL));
+                        v = _mm_xor_si128(_mm_xor_si128(v, t), _mm_slli_epi64(t, 7));
+                        t = _mm_and_si128(_mm_xor_si128(v, _mm_srli_epi64(v, 14)), _mm_set1_epi64x(0x0000CCCC0000CCCCLL));
+                        v = _mm_xor_si128(_mm_xor_si128(v, t), _mm_slli_epi64(t, 14));
+                        t = _mm_and_si128(_mm_xor_si128(v, _mm_srli_epi64(v, 28)), _mm_set1_epi64x(0x00000000F0F0F0F0LL));
+                        v = _mm_xor_si128(_mm_xor_si128(v, t), _mm_slli_epi64(t, 28));
+                        _mm_storeu_si128((__m128i*)(x + g), v);
+                    }
+#endif
+                    for (; g < unitsize; g++){
+                        x[g] = transpose8(m[g * 8 + b]);
+                    }
+
+#ifdef BITS_HAVE_SSE2
+                    // Interleave the unit bytes of 8 samples.
+                    if (Path >= SIMD_SSE2 && cnt == 8 && unitsize == 2){
+                        __m128i v = _mm_loadu_si128((const __m128i*)x);
+                        _mm_storeu_si128((__m128i*)wr, _mm_unpacklo_epi8(v, _mm_unpackhi_epi64(v, v)));
+                        continue;
+                    }
+                    if (Path >= SIMD_SSE2 && cnt == 8 && unitsize == 4){
+                        __m128i v0 = _mm_loadu_si128((const __m128i*)x);
+                        __m128i v1 = _mm_loadu_si128((const __m128i*)(x + 2));
+                        __m128i lo = _mm_unpacklo_epi8(v0, _mm_unpackhi_epi64(v0, v0));
+                        __m128i hi = _mm_unpacklo_epi8(v1, _mm_unpackhi_epi64(v1, v1));
+                        _mm_storeu_si128((__m128i*)wr, _mm_unpacklo_epi16(lo, hi));
+                        _mm_storeu_si128((__m128i*)(wr + 16), _mm_unpackhi_epi16(lo, hi));
+                        continue;
+                    }
+#endif
+                    for (int t = 0; t < cnt; t++){
+                        for (g = 0; g < unitsize; g++){
+                            *wr++ = (uint8_t)(x[g] >> (t * 8));
+                        }
+                    }
+                }
+            }
+        }
+
+#ifdef BITS_HAVE_AVX2
+        static BITS_TARGET_AVX2 void planes_to_units_avx2(const uint8_t *const *planes, const bool *levels, int plane_count,
+                            uint64_t byte_offset, uint64_t sample_count, uint8_t *dest, int unitsize)
+        {
+            planes_to_units_p<SIMD_AVX2>(planes, levels, plane_count, byte_offset, sample_count, dest, unitsize);
+        }
+#endif
+
+        void planes_to_units(const uint8_t *const *planes, const bool *levels, int plane_count,
+                            uint64_t byte_offset, uint64_t sample_count, uint8_t *dest, int unitsize)
+        {
+            planes_to_units(planes, levels, plane_count, byte_offset, sample_count, dest, unitsize, simd_path());
+        }
+
+        void planes_to_units(const uint8_t *const *planes, const bool *levels, int plane_count,
+                            uint64_t byte_offset, uint64_t sample_count, uint8_t *dest, int unitsize,
+                            SimdPath max_path)
+        {
+            assert(planes);
+            assert(levels);
+            assert(dest);
+            assert(plane_count <= 8 * unitsize);
+            assert(unitsize <= 8);
+
+            max_path = std::min(max_path, simd_path());
+
+#ifdef BITS_HAVE_AVX2
+            if (max_path >= SIMD_AVX2){
+                planes_to_units_avx2(planes, levels, plane_count, byte_offset, sample_count, dest, unitsize);
+                return;
+            }
+#endif
+            if (max_path >= SIMD_SSE2)
+                planes_to_units_p<SIMD_SSE2>(planes, levels, plane_count, byte_offset, sample_count, dest, unitsize);
+            else
+                planes_to_units_p<SIMD_SCALAR>(planes, levels, plane_count, byte_offset, sample_count, dest, unitsize);
+        }
+
+        // Rows read ahead of the split.
+        static const int PrefetchRows = 8;
+
+        static inline void prefetch_row(const uint64_t *p, int n)
+        {
+            for (int c = 0; c < n; c += 8){
+#if defined(BITS_HAVE_SSE2)
+                _mm_prefetch((const char*)(p + c), _MM_HINT_NTA);
+#elif defined(__GNUC__)
+                __builtin_prefetch(p + c, 0, 0);
+#endif
+            }
+        }
+
+        static inline void stream_word(uint64_t *p, uint64_t v)
+        {
+#if defined(__x86_64__) || defined(_M_X64)
+            _mm_stream_si64((long long*)p, (long long)v);
+#else
+            *p = v;
+#endif
+        }
+
+        static inline bool same_alignment(uint64_t *const *dest, int n, uint64_t r, uintptr_t mask)
+        {
+            for (int c = 0; c < n; c++){
+                if (((uintptr_t)(dest[c] + r) & mask) != 0)
+                    return false;
+            }
+            return true;
+        }
+
+#ifdef BITS_HAVE_AVX2
+        // Transpose 4x4 tiles, 4 rows of 4 channels. Returns the first row left.
+        template<int N>
+        static BITS_TARGET_AVX2 inline uint64_t split_tiles_x4(const uint64_t *src, uint64_t r, uint64_t rows,
+                                int channels, uint64_t *const *dest)
+        {
+            const int n = (N > 0) ? N : channels;
+
+            for (; r + 4 <= rows; r += 4)
+            {
+                const uint64_t *s = src + r * n;
+                prefetch_row(s + PrefetchRows * n, 4 * n);
+
+                for (int c = 0; c < n; c += 4)
+                {
+                    __m256i a = _mm256_loadu_si256((const __m256i*)(s + c));
+                    __m256i b = _mm256_loadu_si256((const __m256i*)(s + n + c));
+                    __m256i d = _mm256_loadu_si256((const __m256i*)(s + 2 * n + c));
+                    __m256i e = _mm256_loadu_si256((const __m256i*)(s + 3 * n + c));
+                    __m256i t0 = _mm256_unpacklo_epi64(a, b);
+                    __m256i t1 = _mm256_unpackhi_epi64(a, b);
+                    __m256i t2 = _mm256_unpacklo_epi64(d, e);
+                    __m256i t3 = _mm256_unpackhi_epi64(d, e);
+                    _mm256_stream_si256((__m256i*)(dest[c] + r), _mm256_permute2x128_si256(t0, t2, 0x20));
+                    _mm256_stream_si256((__m256i*)(dest[c + 1] + r), _mm256_permute2x128_si256(t1, t3, 0x20));
+                    _mm256_stream_si256((__m256i*)(dest[c + 2] + r), _mm256_permute2x128_si256(t0, t2, 0x31));
+                    _mm256_stream_si256((__m256i*)(dest[c + 3] + r), _mm256_permute2x128_si256(t1, t3, 0x31));
+                }
+            }
+            return r;
+        }
+#endif
+
+        // N is the channel count known at compile time, 0 takes it from channels.
+        // Path is the best vector path the caller's target allows.
+        template<int N, SimdPath Path>
+        static BITS_INLINE void split_words_p(const uint64_t *src, uint64_t rows, int channels, uint64_t *const *dest)
+        {
+            const int n = (N > 0) ? N : channels;
+            uint64_t r = 0;
+
+#ifdef BITS_HAVE_SSE2
+            // All the channels are written at the same word offset,
+            // step single rows until the first one is aligned.
+            const uintptr_t align_mask = (n % 4 == 0 && Path >= SIMD_AVX2) ? 31 : 15;
+
+            for (; Path >= SIMD_SSE2 && r < rows && ((uintptr_t)(dest[0] + r) & align_mask) != 0; r++){
+                for (int c = 0; c < n; c++){
+                    stream_word(dest[c] + r, src[r * n + c]);
+                }
+            }
+#endif
+#ifdef BITS_HAVE_AVX2
+            if (Path >= SIMD_AVX2 && n % 4 == 0 && same_alignment(dest, n, r, 31))
+                r = split_tiles_x4<N>(src, r, rows, channels, dest);
+#endif
+#ifdef BITS_HAVE_SSE2
+            // Transpose 2x2 tiles, 2 rows of 2 channels.
+            if (Path >= SIMD_SSE2 && n % 2 == 0 && same_alignment(dest, n, r, 15))
+            {
+                for (; r + 2 <= rows; r += 2)
+                {
+                    const uint64_t *s = src + r * n;
+                    prefetch_row(s + PrefetchRows * n, 2 * n);
+
+                    for (int c = 0; c < n; c += 2)
+                    {
+                        __m128i a = _mm_loadu_si128((const __m128i*)(s + c));
+                        __m128i b = _mm_loadu_si128((const __m128i*)(s + n + c));
+                        _mm_stream_si128((__m128i*)(dest[c] + r), _mm_unpacklo_epi64(a, b));
+                        _mm_stream_si128((__m128i*)(dest[c + 1] + r), _mm_unpackhi_epi64(a, b));
+                    }
+                }
+            }
+#endif
+            for (; r < rows; r++)
+            {
+                const uint64_t *s = src + r * n;
+                prefetch_row(s + PrefetchRows * n, n);
+
+                for (int c = 0; c < n; c++){
+                    stream_word(dest[c] + r, s[c]);
+                }
+            }
+
+#ifdef BITS_HAVE_SSE2
+            // The streamed stores are weakly ordered, make them visible
+            // before the caller publishes the rows.
+            _mm_sfence();
+#endif
+        }
+
+#ifdef BITS_HAVE_AVX2
+        template<int N>
+        static BITS_TARGET_AVX2 void split_words_avx2(const uint64_t *src, uint64_t rows, int channels, uint64_t *const *dest)
+        {
+            split_words_p<N, SIMD_AVX2>(src, rows, channels, dest);
+        }
+#endif
+
+        template<int N>
+        static void split_words_n(const uint64_t *src, uint64_t rows, int channels, uint64_t *const *dest,
+                                SimdPath max_path)
+        {
+#ifdef BITS_HAVE_AVX2
+            if (max_path >= SIMD_AVX2){
+                split_words_avx2<N>(src, rows, channels, dest);
+                return;
+            }
+#endif
+            if (max_path >= SIMD_SSE2)
+                split_words_p<N, SIMD_SSE2>(src, rows, channels, dest);
+            else
+                split_words_p<N, SIMD_SCALAR>(src, rows, channels, dest);
+        }
+
+        void split_words(const uint64_t *src, uint64_t rows, int channels, uint64_t *const *dest)
+        {
+            split_words(src, rows, channels, dest, simd_path());
+        }
+
+        void split_words(const uint64_t *src, uint64_t rows, int channels, uint64_t *const *dest,
+                        SimdPath max_path)
+        {
+            assert(src);
+            assert(dest);
+            assert(channels > 0);
+
+            max_path = std::min(max_path, simd_path());
+
+            switch (channels)
+            {
+            case 8:
+                split_words_n<8>(src, rows, channels, dest, max_path);
+                break;
+            case 16:
+                split_words_n<16>(src, rows, channels, dest, max_path);
+                break;
+            case 32:
+                split_words_n<32>(src, rows, channels, dest, max_path);
+                break;
+            default:
+                split_words_n<0>(src, rows, channels, dest, max_path);
+                break;
+            }
+        }
+    }
+}
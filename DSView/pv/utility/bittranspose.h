@@ -0,0 +1,80 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef UTILITY_BITTRANSPOSE_H
+#define UTILITY_BITTRANSPOSE_H
+
+#include <stdint.h>
+
+namespace pv
+{
+    namespace bits
+    {
+        /**
+         * Transpose a 8x8 bit matrix, bit c of byte r moves to bit r of byte c.
+         */
+        uint64_t transpose8(uint64_t x);
+
+        /**
+         * The vector paths of the kernels below, each one falls back to the lower ones.
+         */
+        enum SimdPath
+        {
+            SIMD_SCALAR = 0,
+            SIMD_SSE2,
+            SIMD_AVX2
+        };
+
+        /**
+         * The best path of this build on the running CPU.
+         */
+        SimdPath simd_path();
+
+        /**
+         * Convert channel bit planes to the cross format, unitsize bytes per sample.
+         * A NULL plane is a constant channel, its level is taken from levels.
+         * The planes are read from byte_offset, at most 8 * unitsize planes.
+         */
+        void planes_to_units(const uint8_t *const *planes, const bool *levels, int plane_count,
+                            uint64_t byte_offset, uint64_t sample_count, uint8_t *dest, int unitsize);
+
+        /**
+         * As above, with the paths limited to max_path. The tests compare them.
+         */
+        void planes_to_units(const uint8_t *const *planes, const bool *levels, int plane_count,
+                            uint64_t byte_offset, uint64_t sample_count, uint8_t *dest, int unitsize,
+                            SimdPath max_path);
+
+        /**
+         * Split rows of interleaved channel words into one stream per channel,
+         * word c of row r moves to dest[c][r]. The stores bypass the cache.
+         */
+        void split_words(const uint64_t *src, uint64_t rows, int channels, uint64_t *const *dest);
+
+        /**
+         * As above, with the paths limited to max_path. The tests compare them.
+         */
+        void split_words(const uint64_t *src, uint64_t rows, int channels, uint64_t *const *dest,
+                        SimdPath max_path);
+    }
+}
+
+#endif
@@ -46,6 +46,7 @@ LogicSignal::LogicSignal(data::LogicSnapshot *data,
 {
     _trig = NONTRIG; 
     _paint_align_sample_count = 0;
+    _edge_valid = false;
 }
 
 LogicSignal::LogicSignal(view::LogicSignal *s,
@@ -56,6 +57,7 @@ LogicSignal::LogicSignal(view::LogicSignal *s,
     _trig(s->get_trig())
 { 
     _paint_align_sample_count = 0;
+    _edge_valid = false;
 }
 
 LogicSignal::~LogicSignal()
@@ -107,14 +109,25 @@ void LogicSignal::paint_mid_align_sample(QPainter &p, int left, int right, QColo
 
 void LogicSignal::paint_mid_align(QPainter &p, int left, int right, QColor fore, QColor back, uint64_t end_align_sample)
 {
-	using pv::view::View;
-
     (void)back;
 
+    if (prepare_edges(left, right, end_align_sample)) {
+        extract_edges(false);
+        paint_edges(p, fore);
+    }
+}
+
+bool LogicSignal::prepare_edges(int left, int right, uint64_t end_align_sample)
+{
+	using pv::view::View;
+
 	assert(_data);
     assert(_view);
 	assert(right >= left);
 
+    _edge_valid = false;
+    _wave_lines.clear();
+
     const int y = get_y() + _totalHeight * 0.5;
     const double scale = _view->scale();
     assert(scale > 0);
@@ -125,10 +138,10 @@ void LogicSignal::paint_mid_align(QPainter &p, int left, int right, QColor fore,
 
     double samplerate = _data->samplerate();
     if (_data->empty() || samplerate == 0)
-		return;
+		return false;
   
     if (!_data->has_data(_probe->index))
-        return;
+        return false;
 
     if (end_align_sample >= _data->get_ring_sample_count())
         end_align_sample = _data->get_ring_sample_count() - 1;
@@ -143,21 +156,54 @@ void LogicSignal::paint_mid_align(QPainter &p, int left, int right, QColor fore,
     const uint64_t start_index = max((uint64_t)floor(start), (uint64_t)0);
     
     if (start_index > end_index)
-        return;
+        return false;
 
     width = min(width, (uint16_t)ceil((end_index + 1)/samples_per_pixel - offset));
-    const uint16_t max_togs = width / TogMaxScale;
 
-    const bool first_sample = _data->get_display_edges(_cur_pulses, _cur_edges,
-                                                          start_index, end_index, width, max_togs,
-                                                          offset,
-                                                          samples_per_pixel, _probe->index);
+    _edge_start = start_index;
+    _edge_end = end_index;
+    _edge_width = width;
+    _edge_max_togs = width / TogMaxScale;
+    _edge_offset = offset;
+    _edge_samples_per_pixel = samples_per_pixel;
+    _edge_high = high_offset;
+    _edge_low = low_offset;
+    _edge_valid = true;
+
+    return true;
+}
+
+void LogicSignal::extract_edges(bool batch)
+{
+    if (!_edge_valid)
+        return;
+
+    const uint16_t width = _edge_width;
+    const uint16_t max_togs = _edge_max_togs;
+    const int high_offset = _edge_high;
+    const int low_offset = _edge_low;
+    bool first_sample;
+
+    if (batch) {
+        first_sample = _data->get_display_edges_batch(_cur_pulses, _cur_edges,
+                                                          _edge_start, _edge_end, width, max_togs,
+                                                          _edge_offset,
+                                                          _edge_samples_per_pixel, _probe->index);
+    }
+    else {
+        first_sample = _data->get_display_edges(_cur_pulses, _cur_edges,
+                                                          _edge_start, _edge_end, width, max_togs,
+                                                          _edge_offset,
+                                                          _edge_samples_per_pixel, _probe->index);
+    }
     assert(_cur_pulses.size() >= width);
 
     int preX = 0;
     int preY = first_sample ? high_offset : low_offset;
     int x = preX;
-    std::vector<QLine> wave_lines;
+    std::vector<QLine> &wave_lines = _wave_lines;
+
+    wave_lines.clear();
     
     if (_cur_edges.size() < max_togs) {
         std::vector<std::pair<uint16_t, bool>>::const_iterator i;
@@ -185,9 +231,15 @@ void LogicSignal::paint_mid_align(QPainter &p, int left, int right, QColor fore,
         }
         wave_lines.push_back(QLine(preX, preY, x, preY));
     }
+}
+
+void LogicSignal::paint_edges(QPainter &p, QColor fore)
+{
+    if (!_edge_valid || _wave_lines.empty())
+        return;
 
     p.setPen(_colour.isValid() ? _colour : fore);
-    p.drawLines(wave_lines.data(), wave_lines.size());
+    p.drawLines(_wave_lines.data(), _wave_lines.size());
 }
 
 void LogicSignal::paint_caps(QPainter &p, QLineF *const lines,
@@ -463,22 +515,12 @@ bool LogicSignal::edges(uint64_t end, uint64_t start, uint64_t &rising, uint64_t
     if (end > (sample_count - 1))
         return false;
 
-    const int ch_index = get_index();
-    bool sample = _data->get_sample(start, ch_index);
-
-    rising = 0;
-    falling = 0;
-    do {
-        if (_data->get_nxt_edge(index, sample, sample_count, 1, ch_index)) {
-            if (index > end)
-                break;
-            rising += !sample;
-            falling += sample;
-            sample = !sample;
-        } else {
-            break;
-        }
-    } while(index <= end);
+    data::LogicSnapshot::RangeStats stats;
+    if (!_data->get_range_stats(start, end, get_index(), stats, false))
+        return false;
+
+    rising = stats.rising;
+    falling = stats.falling;
 
     return true;
 }
@@ -27,6 +27,7 @@
 #include "signal.h"
 
 #include <vector> 
+#include <QLine>
 
 namespace pv {
 
@@ -111,6 +112,14 @@ public:
 
     void paint_mid_align_sample(QPainter &p, int left, int right, QColor fore, QColor back, uint64_t end_align_sample);
 
+    // paint_mid_align_sample() in three steps, so that a repaint can walk
+    // the channels in parallel. prepare_edges() and paint_edges() run on
+    // the UI thread, extract_edges(true) on any thread while the snapshot
+    // is held by begin_display_edges().
+    bool prepare_edges(int left, int right, uint64_t end_align_sample);
+    void extract_edges(bool batch);
+    void paint_edges(QPainter &p, QColor fore);
+
 protected:
     void paint_type_options(QPainter &p, int right, const QPoint pt, QColor fore);
 
@@ -128,6 +137,17 @@ private:
     std::vector<std::pair<bool, bool>> _cur_pulses;
     LogicSetRegions _trig;
     uint64_t    _paint_align_sample_count;
+
+    bool        _edge_valid;
+    uint64_t    _edge_start;
+    uint64_t    _edge_end;
+    uint16_t    _edge_width;
+    uint16_t    _edge_max_togs;
+    int64_t     _edge_offset;
+    double      _edge_samples_per_pixel;
+    int         _edge_high;
+    int         _edge_low;
+    std::vector<QLine> _wave_lines;
 };
 
 } // namespace view
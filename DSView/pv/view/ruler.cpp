@@ -25,6 +25,7 @@
 #include <math.h>
 #include <limits.h>
 #include <cmath>
+#include <algorithm>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QStyleOption>
@@ -57,6 +58,7 @@ const int Ruler::FirstSIPrefixPower = -15;
 const int Ruler::pricision = 2;
 
 const int Ruler::HoverArrowSize = 4;
+const int Ruler::SearchDensityHeight = 8;
 
 const int Ruler::CursorSelWidth = 20;
 
@@ -243,6 +245,9 @@ void Ruler::paintEvent(QPaintEvent*)
     else
         draw_logic_tick_mark(p);
 
+    if (!_view.get_search_hits().empty())
+        draw_search_density(p);
+
     p.setRenderHint(QPainter::Antialiasing, true);
 	// Draw the hover mark
 	draw_hover_mark(p);
@@ -674,6 +679,34 @@ void Ruler::draw_osc_tick_mark(QPainter &p)
     }
 }
 
+void Ruler::draw_search_density(QPainter &p)
+{
+    const std::vector<uint64_t> &hits = _view.get_search_hits();
+    const int b = height() - 1;
+    const int w = _view.get_view_width();
+
+    p.setPen(View::Blue);
+
+    auto it = hits.begin();
+
+    for (int x = 0; x < w && it != hits.end(); x++) {
+        if (x + _view.offset() < 0)
+            continue;
+
+        const uint64_t end_index = _view.pixel2index(x + 1);
+        it = std::lower_bound(it, hits.end(), _view.pixel2index(x));
+        auto end = std::lower_bound(it, hits.end(), end_index);
+
+        // The height grows with the log of the hit count in this pixel.
+        const int count = (int)(end - it);
+        if (count > 0) {
+            const int h = min((int)log2(count) + 2, SearchDensityHeight);
+            p.drawLine(x, b, x, b - h + 1);
+        }
+        it = end;
+    }
+}
+
 void Ruler::draw_hover_mark(QPainter &p)
 {
     const double x = _view.hover_point().x();
@@ -50,6 +50,7 @@ private:
 	static const int FirstSIPrefixPower;
     static const int pricision;
 	static const int HoverArrowSize;
+    static const int SearchDensityHeight;
     static const int CursorSelWidth;
 
     static const int CursorHsbColorTable[CURSOR_HSB_COLOR_TABLE_LENGTH];
@@ -91,6 +92,11 @@ private:
 
     void draw_cursor_sel(QPainter &p);
 
+    /**
+	 * Draw the density of the search hits at the bottom.
+	 */
+    void draw_search_density(QPainter &p);
+
     int in_cursor_sel_rect(QPointF pos);
 
     QRectF get_cursor_sel_rect(int index);
@@ -491,6 +491,9 @@ void View::frame_began()
     _search_hit = false;
     _search_pos = 0;
     set_search_pos(_search_pos, _search_hit);
+
+    std::vector<uint64_t> hits;
+    set_search_hits(hits);
 }
 
 void View::receive_end()
@@ -509,7 +512,31 @@ void View::receive_end()
                     _viewbottom->set_rle_depth(actual_samples);
                 }
             }
-        }       
+        }
+
+        bool throughput = false;
+        double rate;
+
+        if (_device_agent->is_demo()
+            && _device_agent->get_config_bool(SR_CONF_DEMO_THROUGHPUT, throughput) && throughput
+            && _device_agent->get_config_double(SR_CONF_DEMO_THROUGHPUT_RATE, rate)) {
+            _viewbottom->set_throughput_rate(rate);
+        }
+
+        bool stream = false;
+        bool adaptive = false;
+        uint64_t size;
+        int count;
+        double headroom;
+
+        if (_device_agent->is_hardware_logic()
+            && _device_agent->get_config_bool(SR_CONF_STREAM, stream) && stream
+            && _device_agent->get_config_bool(SR_CONF_ADAPTIVE_TRANSFER, adaptive) && adaptive
+            && _device_agent->get_config_uint64(SR_CONF_TRANSFER_SIZE, size)
+            && _device_agent->get_config_int32(SR_CONF_TRANSFER_COUNT, count)
+            && _device_agent->get_config_double(SR_CONF_TRANSFER_HEADROOM, headroom)) {
+            _viewbottom->set_transfer_info(count, size, headroom);
+        }
     }
     _time_viewport->unshow_wait_trigger();
 }
@@ -576,6 +603,18 @@ void View::set_search_pos(uint64_t search_pos, bool hit)
     }
 }
 
+void View::set_search_hits(std::vector<uint64_t> &hits)
+{
+    _search_hits.swap(hits);
+    _ruler->update();
+}
+
+void View::append_search_hits(const std::vector<uint64_t> &hits)
+{
+    _search_hits.insert(_search_hits.end(), hits.begin(), hits.end());
+    _ruler->update();
+}
+
 void View::normalize_layout()
 {   
     int v_min = INT_MAX;
@@ -248,6 +248,16 @@ public:
         return _search_pos;
     }
 
+    // The sorted positions of all the search hits, the ruler draws their density.
+    void set_search_hits(std::vector<uint64_t> &hits);
+
+    // Add the hits found after the current ones, while find all runs.
+    void append_search_hits(const std::vector<uint64_t> &hits);
+
+    inline const std::vector<uint64_t>& get_search_hits(){
+        return _search_hits;
+    }
+
     void scroll_to_logic_last_data_time();
 
     /*
@@ -473,6 +483,7 @@ private:
     bool        _show_search_cursor;
     uint64_t    _search_pos;
     bool        _search_hit;
+    std::vector<uint64_t> _search_hits;
 
     bool        _show_xcursors;
     std::list<XCursor*> _xcursorList;
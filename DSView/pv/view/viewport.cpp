@@ -37,6 +37,7 @@
 #include <QStyleOption>
 #include <QPainterPath> 
 #include <math.h>
+#include <string.h>
 #include <QWheelEvent>
  
 #include "../config/appconfig.h"
@@ -97,6 +98,14 @@ Viewport::Viewport(View &parent, View_type type) :
     _lst_wait_tigger_time = high_resolution_clock::now();
     _tigger_wait_times = 0;
 
+    _edge_next = 0;
+    _edge_left = 0;
+    _edge_exit = false;
+
+    memset(_paint_hist, 0, sizeof(_paint_hist));
+    _paint_count = 0;
+    _paint_last_us = 0;
+
     // drag inertial
     _drag_strength = 0;
     _drag_timer.setSingleShot(true);
@@ -121,6 +130,16 @@ Viewport::Viewport(View &parent, View_type type) :
 Viewport::~Viewport()
 {
     REMOVE_UI(this);
+
+    {
+        std::lock_guard<std::mutex> lock(_edge_mutex);
+        _edge_exit = true;
+    }
+    _edge_cond.notify_all();
+
+    for (auto &th : _edge_workers){
+        th.join();
+    }
 }
 
 int Viewport::get_total_height()
@@ -237,6 +256,11 @@ void Viewport::doPaint()
             t->paint_fore(p, 0, _view.get_view_width(), fore, back);
     }
 
+    if (mode == LOGIC && _type == TIME_VIEW
+        && AppConfig::Instance().appOptions.paintTimeOverlay){
+        paintPaintTime(p, fore, back);
+    }
+
     if (_view.get_signalHeight() != _curSignalHeight)
             _curSignalHeight = _view.get_signalHeight();
 
@@ -261,6 +285,140 @@ void Viewport::paintCursors(QPainter &p)
     }
 }
 
+void Viewport::extract_logic_edges(std::vector<LogicSignal*> &logic_signals)
+{
+    if (logic_signals.empty())
+        return;
+
+    data::LogicSnapshot *snapshot = logic_signals[0]->data();
+    assert(snapshot);
+
+    if (logic_signals.size() > 1 && _edge_workers.empty()){
+        int num = (int)std::thread::hardware_concurrency() - 1;
+        if (num > MaxEdgeWorkers)
+            num = MaxEdgeWorkers;
+
+        for (int i = 0; i < num; i++){
+            _edge_workers.push_back(std::thread(&Viewport::edge_proc, this));
+        }
+    }
+
+    snapshot->begin_display_edges();
+
+    std::unique_lock<std::mutex> lock(_edge_mutex);
+    _edge_jobs = logic_signals;
+    _edge_next = 0;
+    _edge_left = logic_signals.size();
+    _edge_cond.notify_all();
+
+    // The UI thread takes channels too, then waits for the rest.
+    while (_edge_next < _edge_jobs.size())
+    {
+        LogicSignal *logic_signal = _edge_jobs[_edge_next++];
+        assert(logic_signal->data() == snapshot);
+        lock.unlock();
+        logic_signal->extract_edges(true);
+        lock.lock();
+        _edge_left--;
+    }
+
+    _edge_done_cond.wait(lock, [this]{ return _edge_left == 0; });
+    _edge_jobs.clear();
+    lock.unlock();
+
+    snapshot->end_display_edges();
+}
+
+void Viewport::edge_proc()
+{
+    std::unique_lock<std::mutex> lock(_edge_mutex);
+
+    while (true)
+    {
+        _edge_cond.wait(lock, [this]{
+            return _edge_exit || _edge_next < _edge_jobs.size();
+        });
+
+        if (_edge_exit){
+            break;
+        }
+
+        LogicSignal *logic_signal = _edge_jobs[_edge_next++];
+        lock.unlock();
+        logic_signal->extract_edges(true);
+        lock.lock();
+
+        if (--_edge_left == 0){
+            _edge_done_cond.notify_all();
+        }
+    }
+}
+
+void Viewport::record_paint_time(int64_t us)
+{
+    if (!AppConfig::Instance().appOptions.paintTimeOverlay){
+        if (_paint_count > 0){
+            memset(_paint_hist, 0, sizeof(_paint_hist));
+            _paint_count = 0;
+        }
+        return;
+    }
+
+    int64_t ms = us / 1000;
+    int bin = 0;
+
+    while (ms > 0 && bin < PaintTimeBins - 1){
+        ms >>= 1;
+        bin++;
+    }
+
+    _paint_hist[bin]++;
+    _paint_count++;
+    _paint_last_us = us;
+}
+
+void Viewport::paintPaintTime(QPainter &p, QColor fore, QColor back)
+{
+    const QRect xrect = _view.get_view_rect();
+    const int row = p.fontMetrics().height() + 2;
+    const int label_width = p.fontMetrics().horizontalAdvance(">=64 ms ");
+    const int bar_width = 120;
+    const int width = label_width + bar_width + 60;
+    const int height = row * (PaintTimeBins + 1) + 10;
+    QRect rect(xrect.right() - width - 10, xrect.top() + 10, width, height);
+    uint64_t max_count = 1;
+
+    for (int i = 0; i < PaintTimeBins; i++){
+        max_count = max(max_count, _paint_hist[i]);
+    }
+
+    back.setAlpha(200);
+    p.setPen(fore);
+    p.setBrush(back);
+    p.drawRect(rect);
+
+    int y = rect.top() + 5;
+    p.drawText(QRect(rect.left() + 5, y, width - 10, row), Qt::AlignLeft | Qt::AlignVCenter,
+               QString("Paint %1 ms, %2 frames").arg(_paint_last_us / 1000.0, 0, 'f', 2).arg(_paint_count));
+    y += row;
+
+    for (int i = 0; i < PaintTimeBins; i++)
+    {
+        QString label = (i == PaintTimeBins - 1) ? QString(">=%1 ms").arg(1 << (i - 1))
+                                                 : QString("<%1 ms").arg(1 << i);
+        int bar = (int)(bar_width * _paint_hist[i] / max_count);
+
+        p.setPen(fore);
+        p.drawText(QRect(rect.left() + 5, y, label_width, row), Qt::AlignRight | Qt::AlignVCenter, label);
+        p.drawText(QRect(rect.left() + 10 + label_width + bar_width, y, 50, row), Qt::AlignLeft | Qt::AlignVCenter,
+                   QString::number(_paint_hist[i]));
+        p.setPen(Qt::NoPen);
+        p.setBrush(View::Blue);
+        p.drawRect(rect.left() + 5 + label_width, y + 2, max(bar, 1), row - 4);
+        y += row;
+    }
+}
+
 void Viewport::paintSignals(QPainter &p, QColor fore, QColor back)
 { 
     std::vector<Trace*> traces;
@@ -270,6 +428,26 @@ void Viewport::paintSignals(QPainter &p, QColor fore, QColor back)
     {
         bool bFirst = true;
         uint64_t end_align_sample;
+        std::vector<LogicSignal*> logic_signals;
+        QElapsedTimer paint_timer;
+
+        paint_timer.start();
+
+        // Walk the channel edges on the workers first, then only draw.
+        for(auto t : traces){
+            if (t->enabled() && t->signal_type() == SR_CHANNEL_LOGIC){
+                LogicSignal *logic_signal = (LogicSignal*)t;
+
+                if (bFirst)
+                    end_align_sample = logic_signal->data()->get_ring_sample_count();
+
+                if (logic_signal->prepare_edges(0, t->get_view_rect().right(), end_align_sample))
+                    logic_signals.push_back(logic_signal);
+                bFirst = false;
+            }
+        }
+
+        extract_logic_edges(logic_signals);
 
         for(auto t : traces){
             if (t->enabled()){
@@ -277,18 +455,15 @@ void Viewport::paintSignals(QPainter &p, QColor fore, QColor back)
                 if (t->signal_type() == SR_CHANNEL_LOGIC)
                 {
                     LogicSignal *logic_signal = (LogicSignal*)t;
-                
-                    if (bFirst)
-                        end_align_sample = logic_signal->data()->get_ring_sample_count();
-            
-                    logic_signal->paint_mid_align_sample(p, 0, t->get_view_rect().right(), fore, back, end_align_sample);
-                    bFirst = false;
+                    logic_signal->paint_edges(p, fore);
                 }
                 else{
                     t->paint_mid(p, 0, t->get_view_rect().right(), fore, back);
                 }               
             }                
         }
+
+        record_paint_time(paint_timer.nsecsElapsed() / 1000);
     } 
     else {
         if (_view.scale() != _curScale ||
@@ -32,6 +32,10 @@
 #include <QNativeGestureEvent>
 #include <QElapsedTimer>
 #include <chrono>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "../view/view.h"
 #include "../dsvdef.h"
@@ -58,6 +62,7 @@ enum UpdateEventType
 };
 
 class Signal;
+class LogicSignal;
 class View;
 
 //main graph view port, in the middle region
@@ -77,6 +82,9 @@ public:
     static const double DragDamping;
     static const int SnapMinSpace = 10;
     static const int WaitLoopTime = 400;
+
+    static const int MaxEdgeWorkers = 8;
+    static const int PaintTimeBins = 8;
     enum ActionType {
         NO_ACTION,
 
@@ -146,6 +154,11 @@ private:
     void paintProgress(QPainter& p, QColor fore, QColor back);
     void paintMeasure(QPainter &p, QColor fore, QColor back);
     void paintCursors(QPainter &p);
+    void paintPaintTime(QPainter &p, QColor fore, QColor back);
+
+    void extract_logic_edges(std::vector<LogicSignal*> &logic_signals);
+    void edge_proc();
+    void record_paint_time(int64_t us);
 
     void start_trigger_timer(int msec);
     void get_captured_progress(double &progress, int &progress100);
@@ -242,6 +255,22 @@ private:
     int             _tigger_wait_times;
     QAction         *_yAction;
     QAction         *_xAction;
+
+    // Workers walking the logic channels of a repaint.
+    std::vector<std::thread>    _edge_workers;
+    std::mutex                  _edge_mutex;
+    std::condition_variable     _edge_cond;
+    std::condition_variable     _edge_done_cond;
+    std::vector<LogicSignal*>   _edge_jobs;
+    size_t                      _edge_next;
+    size_t                      _edge_left;
+    bool                        _edge_exit;
+
+    // Logic repaint times. Bin 0 counts those under 1 ms, bin n those
+    // under 2^n ms, the last bin all the longer ones.
+    uint64_t        _paint_hist[PaintTimeBins];
+    uint64_t        _paint_count;
+    int64_t         _paint_last_us;
 };
 
 } // namespace view
@@ -81,7 +81,7 @@ void ViewStatus::paintEvent(QPaintEvent *)
     if (mode == LOGIC) {
         fore.setAlpha(View::ForeAlpha);
         p.setPen(fore);
-        p.drawText(this->rect(), Qt::AlignLeft | Qt::AlignVCenter, _rle_depth);
+        p.drawText(this->rect(), Qt::AlignLeft | Qt::AlignVCenter, _rle_depth + _throughput_rate + _transfer_info);
         p.drawText(this->rect(), Qt::AlignRight | Qt::AlignVCenter, _trig_time);
 
         p.setPen(Qt::NoPen);
@@ -147,6 +147,8 @@ void ViewStatus::clear()
 {
     _trig_time.clear();
     _rle_depth.clear();
+    _throughput_rate.clear();
+    _transfer_info.clear();
     _capture_status.clear();
     update();
 }
@@ -199,6 +201,22 @@ void ViewStatus::set_rle_depth(uint64_t depth)
     _rle_depth = QString::number(depth) + L_S(STR_PAGE_DLG, S_ID(IDS_DLG_SAMPLES_CAPTURED), "Samples Captured!");
 }
 
+void ViewStatus::set_throughput_rate(double rate)
+{
+    _throughput_rate = L_S(STR_PAGE_DLG, S_ID(IDS_DLG_DEMO_THROUGHPUT_RATE), "Throughput: ")
+                    + QString::number(rate, 'f', 2) + "MSa/s";
+    update();
+}
+
+void ViewStatus::set_transfer_info(int count, uint64_t size, double headroom)
+{
+    _transfer_info = L_S(STR_PAGE_DLG, S_ID(IDS_DLG_USB_TRANSFERS), " USB Transfers: ")
+                    + QString::number(count) + " x " + QString::number(size / 1024) + "KB"
+                    + L_S(STR_PAGE_DLG, S_ID(IDS_DLG_USB_HEADROOM), ", Headroom: ")
+                    + QString::number(headroom, 'f', 2);
+    update();
+}
+
 void ViewStatus::set_capture_status(bool triggered, int progess)
 {
     if (triggered) {
@@ -62,6 +62,8 @@ public slots:
     void repeat_unshow();
     void set_trig_time(QDateTime time);
     void set_rle_depth(uint64_t depth);    
+    void set_throughput_rate(double rate);
+    void set_transfer_info(int count, uint64_t size, double headroom);
 
 private:
     SigSession *_session;
@@ -70,6 +72,8 @@ private:
 
     QString _trig_time;
     QString _rle_depth;
+    QString _throughput_rate;
+    QString _transfer_info;
     QString _capture_status;
 
     int _last_sig_index;
@@ -0,0 +1,267 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../../../pv/data/decode/annotationrestable.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(AnnotationResTableTest)
+
+// The slots the table starts with, RES_MIN_SLOT_COUNT. It grows at half full.
+static const int MinSlotCount = 1024;
+
+// The texts of an annotation, NULL terminated as libsigrokdecode hands them.
+struct Texts
+{
+	Texts(const vector<string> &lines) : lines(lines)
+	{
+		for (string &l : this->lines)
+			ptrs.push_back(&l[0]);
+		ptrs.push_back(NULL);
+	}
+
+	char** get()
+	{
+		return ptrs.data();
+	}
+
+	vector<string> lines;
+	vector<char*> ptrs;
+};
+
+static int make_index(AnnotationResTable &table, const vector<string> &lines,
+					  const char *number_hex, AnnotationSourceItem **newItem = NULL)
+{
+	Texts texts(lines);
+	AnnotationSourceItem *item = NULL;
+	const int index = table.MakeIndex(texts.get(), number_hex, item);
+	if (newItem)
+		*newItem = item;
+	return index;
+}
+
+static string key_text(int i)
+{
+	char buf[32];
+	sprintf(buf, "key %d", i);
+	return buf;
+}
+
+BOOST_AUTO_TEST_CASE(SameTextSameIndex)
+{
+	AnnotationResTable table;
+	AnnotationSourceItem *item = NULL;
+
+	const int a = make_index(table, {"Data", "D"}, "3F", &item);
+	BOOST_REQUIRE(item != NULL);
+	BOOST_CHECK_EQUAL(a, 0);
+
+	// From other buffers with the same bytes, no new item.
+	item = NULL;
+	BOOST_CHECK_EQUAL(make_index(table, {"Data", "D"}, "3F", &item), a);
+	BOOST_CHECK(item == NULL);
+
+	// Any difference in the lines or the number is a new text.
+	BOOST_CHECK_NE(make_index(table, {"Data", "D"}, "3E"), a);
+	BOOST_CHECK_NE(make_index(table, {"Data", "D"}, NULL), a);
+	BOOST_CHECK_NE(make_index(table, {"Data"}, "3F"), a);
+	BOOST_CHECK_NE(make_index(table, {"Data", "D", "x"}, "3F"), a);
+	BOOST_CHECK_EQUAL(table.GetCount(), 5);
+
+	// No number and an empty one are the same.
+	BOOST_CHECK_EQUAL(make_index(table, {"Data", "D"}, ""), make_index(table, {"Data", "D"}, NULL));
+	BOOST_CHECK_EQUAL(table.GetCount(), 5);
+}
+
+// The line ends are part of the key, so the lines can not run together.
+BOOST_AUTO_TEST_CASE(LineBoundaries)
+{
+	AnnotationResTable table;
+
+	const int a = make_index(table, {"ab", "c"}, "");
+	const int b = make_index(table, {"a", "bc"}, "");
+	const int c = make_index(table, {"abc"}, "");
+
+	BOOST_CHECK_NE(a, b);
+	BOOST_CHECK_NE(a, c);
+	BOOST_CHECK_NE(b, c);
+
+	// Nor the last line with the number.
+	BOOST_CHECK_NE(make_index(table, {"ab"}, "12"), make_index(table, {"ab1"}, "2"));
+
+	BOOST_CHECK_EQUAL(make_index(table, {"a", "bc"}, ""), b);
+	BOOST_CHECK_EQUAL(table.GetCount(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(NewLinesIgnored)
+{
+	AnnotationResTable table;
+	AnnotationSourceItem *item = NULL;
+
+	const int a = make_index(table, {"Start", "S"}, "", &item);
+	BOOST_REQUIRE(item != NULL);
+	BOOST_CHECK_EQUAL(item->src_lines.size(), 2);
+
+	BOOST_CHECK_EQUAL(make_index(table, {"\n", "Start", "S"}, ""), a);
+	BOOST_CHECK_EQUAL(make_index(table, {"Start", "\nx", "S", "\n"}, ""), a);
+	BOOST_CHECK_EQUAL(table.GetCount(), 1);
+
+	item = NULL;
+	const int b = make_index(table, {"\nx", "Stop"}, "", &item);
+	BOOST_REQUIRE(item != NULL);
+	BOOST_CHECK_NE(b, a);
+	BOOST_REQUIRE_EQUAL(item->src_lines.size(), 1);
+	BOOST_CHECK_EQUAL(item->src_lines[0].toStdString(), "Stop");
+}
+
+// The item keeps the number from the key, not the decoder's buffer.
+BOOST_AUTO_TEST_CASE(NumberInArena)
+{
+	AnnotationResTable table;
+	AnnotationSourceItem *item = NULL;
+	char number[] = "A5C3";
+
+	const int a = make_index(table, {"Byte"}, number, &item);
+	BOOST_REQUIRE(item != NULL);
+	BOOST_CHECK(item->is_numeric);
+	BOOST_REQUIRE(item->str_number_hex != NULL);
+	BOOST_CHECK(item->str_number_hex != number);
+	BOOST_CHECK_EQUAL(string(item->str_number_hex), "A5C3");
+	BOOST_CHECK_EQUAL(item->cur_display_format, -1);
+
+	strcpy(number, "0000");
+	BOOST_CHECK_EQUAL(string(table.GetItem(a)->str_number_hex), "A5C3");
+
+	// Not a number: none given, or too long to format.
+	make_index(table, {"Byte"}, NULL, &item);
+	BOOST_CHECK(!item->is_numeric);
+	BOOST_CHECK(item->str_number_hex == NULL);
+
+	const string longer(DECODER_MAX_DATA_BLOCK_LEN + 1, 'F');
+	make_index(table, {"Byte"}, longer.c_str(), &item);
+	BOOST_CHECK(!item->is_numeric);
+
+	const string longest(DECODER_MAX_DATA_BLOCK_LEN, 'F');
+	make_index(table, {"Byte"}, longest.c_str(), &item);
+	BOOST_CHECK(item->is_numeric);
+	BOOST_CHECK_EQUAL(string(item->str_number_hex), longest);
+}
+
+// Many times past the first slot table, and past a key arena block. The
+// keys found before each growth still resolve to their index.
+BOOST_AUTO_TEST_CASE(GrowSlots)
+{
+	AnnotationResTable table;
+	const int count = MinSlotCount * 16 + 7;
+	vector<char*> numbers;
+
+	for (int i = 0; i < count; i++){
+		AnnotationSourceItem *item = NULL;
+		char number[16];
+		sprintf(number, "%X", i);
+
+		BOOST_REQUIRE_EQUAL(make_index(table, {key_text(i)}, number, &item), i);
+		BOOST_REQUIRE(item != NULL);
+		numbers.push_back(item->str_number_hex);
+
+		// Check all of them on the way across the first growths.
+		if (i == MinSlotCount / 2 || i == MinSlotCount){
+			for (int j = 0; j <= i; j++){
+				sprintf(number, "%X", j);
+				BOOST_REQUIRE_EQUAL(make_index(table, {key_text(j)}, number), j);
+			}
+		}
+	}
+
+	BOOST_CHECK_EQUAL(table.GetCount(), count);
+
+	for (int i = 0; i < count; i++){
+		char number[16];
+		sprintf(number, "%X", i);
+		BOOST_REQUIRE_EQUAL(make_index(table, {key_text(i)}, number), i);
+
+		AnnotationSourceItem *item = table.GetItem(i);
+		BOOST_REQUIRE_EQUAL(item->src_lines[0].toStdString(), key_text(i));
+		BOOST_REQUIRE(item->str_number_hex == numbers[i]);
+		BOOST_REQUIRE_EQUAL(string(item->str_number_hex), number);
+	}
+
+	BOOST_CHECK_EQUAL(table.GetCount(), count);
+}
+
+// The paint thread reads the items while the decode thread adds them.
+// Every published item is complete, across item segments and growths.
+BOOST_AUTO_TEST_CASE(ReadWhileMakeIndex)
+{
+	AnnotationResTable table;
+	const int count = 3 * 65536 + 100;
+	atomic<bool> stop(false);
+	atomic<int> bad(0);
+	atomic<int> reads(0);
+
+	thread reader([&]{
+		int checked = 0;
+		while (!stop.load()){
+			const int n = table.GetCount();
+			if (n == 0){
+				this_thread::yield();
+				continue;
+			}
+
+			// The newest one and one of the older ones.
+			for (int i : {n - 1, checked % n}){
+				AnnotationSourceItem *item = table.GetItem(i);
+				if (item == NULL || item->src_lines.size() != 1
+					|| item->src_lines[0].toStdString() != key_text(i)
+					|| item->str_number_hex != NULL)
+					bad++;
+			}
+			checked += 7919;
+			reads++;
+			this_thread::yield();
+		}
+	});
+
+	for (int i = 0; i < count; i++){
+		if (make_index(table, {key_text(i)}, NULL) != i)
+			bad++;
+		if (i % 1024 == 0)
+			this_thread::yield();
+	}
+	stop = true;
+	reader.join();
+
+	BOOST_CHECK_EQUAL(bad.load(), 0);
+	BOOST_CHECK(reads.load() > 0);
+	BOOST_CHECK_EQUAL(table.GetCount(), count);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../logicfeed.h"
+#include "../../../pv/data/decode/loopwindow.h"
+
+using namespace std;
+using namespace logicfeed;
+using pv::data::LogicSnapshot;
+using pv::data::decode::LoopWindow;
+
+BOOST_AUTO_TEST_SUITE(LoopWindowTest)
+
+// A loop capture of one channel, a ring of two leaf blocks with the samples
+// of six going through it.
+struct LoopFixture
+{
+	LoopFixture() :
+		ring(2 * LogicSnapshot::get_leaf_block_samples()),
+		cap(1, 6 * LogicSnapshot::get_leaf_block_samples()),
+		probes(1), fed(0), mismatches(0)
+	{
+		mt19937_64 rng(9);
+		for (uint64_t &w : cap.words[0])
+			w = rng();
+
+		snapshot.init();
+		snapshot.set_loop(true);
+	}
+
+	// The next rows of the capture, as SigSession hands them over in loop mode.
+	void feed_rows(uint64_t rows)
+	{
+		vector<uint64_t> data = cross_rows(cap, fed / 64, rows);
+		sr_datafeed_logic logic;
+		memset(&logic, 0, sizeof(logic));
+		logic.format = LA_CROSS_DATA;
+		logic.length = data.size() * 8;
+		logic.data = data.data();
+
+		if (fed == 0)
+			snapshot.first_payload(logic, ring, probes.list());
+		else
+			snapshot.append_payload(logic);
+		fed += rows * 64;
+
+		// The ring grows as the mipmap is built.
+		const uint64_t count = min(fed, ring);
+		for (int i = 0; i < 100 && snapshot.get_ring_sample_count() < count; i++)
+			snapshot.wait_samples(count - 1, 100);
+	}
+
+	// Reads the decoder samples [from, to) at the ring index DecoderStack takes,
+	// sample i of a decode started at base is sample base + i of the capture.
+	bool read(LoopWindow &win, uint64_t base, uint64_t from, uint64_t to)
+	{
+		for (uint64_t i = from; i < to; i += 997){
+			if (!win.update(snapshot.get_loop_discard_count(), i))
+				return false;
+			if (snapshot.get_sample(i - win.shift(), 0) != cap.bit(0, base + i))
+				mismatches++;
+		}
+		return true;
+	}
+
+	// All the ring holds from decoded on.
+	bool read_ring(LoopWindow &win, uint64_t base, uint64_t &decoded)
+	{
+		if (!win.update(snapshot.get_loop_discard_count(), decoded))
+			return false;
+
+		const uint64_t end = win.shift() + snapshot.get_ring_sample_count();
+		if (!read(win, base, decoded, end))
+			return false;
+		decoded = end;
+		return true;
+	}
+
+	const uint64_t ring;
+	Capture cap;
+	Probes probes;
+	LogicSnapshot snapshot;
+	uint64_t fed;
+	uint64_t mismatches;
+};
+
+static const uint64_t PacketRows = 64 * 1024;
+
+BOOST_FIXTURE_TEST_CASE(FollowsRingHead, LoopFixture)
+{
+	LoopWindow win;
+	uint64_t decoded = 0;
+	win.start(snapshot.get_loop_discard_count());
+
+	while (fed < cap.samples)
+	{
+		feed_rows(min(PacketRows, (cap.samples - fed) / 64));
+		BOOST_REQUIRE(read_ring(win, 0, decoded));
+		BOOST_CHECK_EQUAL(win.progress(decoded, snapshot.get_ring_sample_count()), 100);
+	}
+
+	BOOST_CHECK_EQUAL(mismatches, 0);
+	BOOST_CHECK(!win.overrun());
+	BOOST_CHECK_EQUAL(win.shift(), cap.samples - ring);
+	BOOST_CHECK_EQUAL(decoded, cap.samples);
+
+	// Halfway into the ring, and behind its head.
+	BOOST_CHECK_EQUAL(win.progress(win.shift() + ring / 2, ring), 50);
+	BOOST_CHECK_EQUAL(win.progress(win.shift() - 1, ring), 0);
+}
+
+// The decoder falls behind, the ring head passes it. It starts again from
+// the head, as DecoderStack::do_decode_work() does.
+BOOST_FIXTURE_TEST_CASE(OverrunRestartsAtHead, LoopFixture)
+{
+	LoopWindow win;
+	uint64_t decoded = 0;
+	win.start(snapshot.get_loop_discard_count());
+
+	feed_rows(ring / 2 / 64);
+	BOOST_REQUIRE(read_ring(win, 0, decoded));
+
+	// A ring and a half more while the decoder is busy.
+	const uint64_t busy_end = fed + ring * 3 / 2;
+	while (fed < busy_end)
+		feed_rows(PacketRows);
+
+	BOOST_CHECK(!read_ring(win, 0, decoded));
+	BOOST_CHECK(win.overrun());
+	BOOST_CHECK_EQUAL(decoded, ring / 2);
+
+	const uint64_t base = snapshot.get_loop_discard_count();
+	BOOST_CHECK_EQUAL(base, fed - ring);
+	win.start(base);
+	decoded = 0;
+	BOOST_CHECK(!win.overrun());
+
+	while (fed < cap.samples)
+	{
+		BOOST_REQUIRE(read_ring(win, base, decoded));
+		feed_rows(min(PacketRows, (cap.samples - fed) / 64));
+	}
+	BOOST_REQUIRE(read_ring(win, base, decoded));
+
+	BOOST_CHECK_EQUAL(mismatches, 0);
+	BOOST_CHECK_EQUAL(base + decoded, cap.samples);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,351 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../../../pv/data/decode/rowdata.h"
+#include "../../../pv/data/decode/decoderstatus.h"
+
+using namespace std;
+
+using pv::data::decode::Annotation;
+using pv::data::decode::RowData;
+
+BOOST_AUTO_TEST_SUITE(RowDataTest)
+
+// The annotations libsigrokdecode hands over per callback, SRD_ANN_BATCH_SIZE.
+static const uint64_t BatchSize = 1024;
+static const uint64_t AnnotationCount = 4 * 1024 * 1024;
+
+static double elapsed_seconds(const chrono::steady_clock::time_point &begin)
+{
+	chrono::duration<double> d = chrono::steady_clock::now() - begin;
+	return d.count();
+}
+
+static Annotation make_annotation(uint64_t i, DecoderStatus *status)
+{
+	return Annotation(i * 10, i * 10 + 8, 0, 0, -1, status);
+}
+
+// Reads the row like the paint thread does while the decoder appends.
+static void read_row(RowData *row, atomic<bool> *stop)
+{
+	Annotation a;
+
+	while (!stop->load())
+	{
+		uint64_t size = row->get_annotation_size();
+		if (size > 0)
+			row->get_annotation(&a, size - 1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(PushAnnotations)
+{
+	DecoderStatus status;
+	RowData single;
+	RowData batched;
+	vector<Annotation> batch;
+	bool ok = true;
+	atomic<bool> stop(false);
+
+	thread reader(read_row, &single, &stop);
+	auto begin = chrono::steady_clock::now();
+	for (uint64_t i = 0; i < AnnotationCount; i++){
+		ok &= single.push_annotation(make_annotation(i, &status));
+	}
+	const double single_time = elapsed_seconds(begin);
+	stop = true;
+	reader.join();
+
+	batch.reserve(BatchSize);
+	stop = false;
+	reader = thread(read_row, &batched, &stop);
+	begin = chrono::steady_clock::now();
+	for (uint64_t i = 0; i < AnnotationCount; i += BatchSize)
+	{
+		batch.clear();
+		for (uint64_t j = i; j < i + BatchSize && j < AnnotationCount; j++){
+			batch.push_back(make_annotation(j, &status));
+		}
+		ok &= batched.push_annotations(batch);
+	}
+	const double batch_time = elapsed_seconds(begin);
+	stop = true;
+	reader.join();
+
+	BOOST_REQUIRE(ok);
+
+	BOOST_REQUIRE_EQUAL(single.get_annotation_size(), AnnotationCount);
+	BOOST_REQUIRE_EQUAL(batched.get_annotation_size(), AnnotationCount);
+
+	for (uint64_t i = 0; i < AnnotationCount; i += 4099)
+	{
+		Annotation a, b;
+		BOOST_REQUIRE(single.get_annotation(&a, i));
+		BOOST_REQUIRE(batched.get_annotation(&b, i));
+		BOOST_CHECK_EQUAL(a.start_sample(), i * 10);
+		BOOST_CHECK_EQUAL(b.start_sample(), a.start_sample());
+		BOOST_CHECK_EQUAL(b.end_sample(), a.end_sample());
+	}
+
+	BOOST_TEST_MESSAGE("Annotations one by one: " << AnnotationCount / single_time << "/s");
+	BOOST_TEST_MESSAGE("Annotations in batches of " << BatchSize << ": "
+		<< AnnotationCount / batch_time << "/s");
+
+	// The rows do not free their chunks on destruction.
+	single.clear();
+	batched.clear();
+}
+
+// The annotations of a decoder in a live loop capture, the view shows them
+// from the ring head on.
+BOOST_AUTO_TEST_CASE(SampleBase)
+{
+	// Three chunks of RowData and some more.
+	const uint64_t count = 3 * 4096 + 500;
+	vector<uint64_t> starts, ends;
+	RowData row;
+
+	for (uint64_t i = 0; i < count; i++){
+		// A long one now and then holds back the ones behind it.
+		const uint64_t len = (i % 1000 == 0 && i > 0) ? 25000 : 8;
+		starts.push_back(i * 10);
+		ends.push_back(i * 10 + len);
+		BOOST_REQUIRE(row.push_annotation(Annotation(starts[i], ends[i], 0, 0, -1, NULL)));
+	}
+
+	const uint64_t full_bytes = row.get_bytes_used();
+	const uint64_t max_end = *max_element(ends.begin(), ends.end());
+	uint64_t first = 0;
+
+	for (uint64_t base : {0, 5, 25, 9999, 20000, 40000, 50000, 123456})
+	{
+		row.set_sample_base(base);
+
+		// The leading annotations that ended at or before the base are dropped.
+		while (first < count && ends[first] <= base)
+			first++;
+
+		BOOST_REQUIRE_EQUAL(row.get_annotation_size(), count - first);
+		BOOST_CHECK_EQUAL(row.get_max_sample(), max_end - base);
+
+		for (uint64_t j = 0; j < count - first; j += 37)
+		{
+			Annotation a;
+			BOOST_REQUIRE(row.get_annotation(&a, j));
+			BOOST_CHECK_EQUAL(a.start_sample(), starts[first + j] > base ? starts[first + j] - base : 0);
+			BOOST_CHECK_EQUAL(a.end_sample(), ends[first + j] > base ? ends[first + j] - base : 0);
+		}
+
+		for (uint64_t v : {(uint64_t)0, (uint64_t)3, (uint64_t)4444, (uint64_t)20005})
+		{
+			uint64_t index = 0;
+			while (first + index < count && starts[first + index] <= v + base)
+				index++;
+			BOOST_CHECK_EQUAL(row.get_annotation_index(v), index);
+
+			vector<Annotation> subset;
+			uint64_t expect = 0;
+			bool same = true;
+			row.get_annotation_subset(subset, v, v + 333);
+
+			for (uint64_t i = 0; i < count; i++){
+				if (starts[i] <= v + 333 + base && ends[i] > v + base){
+					same &= expect < subset.size() && subset[expect].end_sample() == ends[i] - base;
+					expect++;
+				}
+			}
+			BOOST_CHECK_EQUAL(subset.size(), expect);
+			BOOST_CHECK_MESSAGE(same, "base " << base << ", view " << v);
+		}
+	}
+
+	// The chunks of the dropped annotations are released.
+	BOOST_CHECK(first > 4096);
+	BOOST_CHECK(row.get_bytes_used() < full_bytes);
+
+	row.clear();
+}
+
+// A plain sorted copy of a row, to check RowData against.
+struct RefRow
+{
+	struct Item
+	{
+		uint64_t start;
+		uint64_t end;
+		int id;
+	};
+
+	RefRow() : max_end(0), base(0) {}
+
+	// After the ones with the same start, as the row keeps them.
+	void push(uint64_t start, uint64_t end, int id)
+	{
+		auto it = upper_bound(items.begin(), items.end(), start,
+			[](uint64_t s, const Item &i){ return s < i.start; });
+		items.insert(it, {start, end, id});
+		max_end = max(max_end, end);
+	}
+
+	void set_sample_base(uint64_t b)
+	{
+		base = b;
+		uint64_t first = 0;
+		while (first < items.size() && items[first].end <= base)
+			first++;
+		items.erase(items.begin(), items.begin() + first);
+	}
+
+	uint64_t view(uint64_t sample)
+	{
+		return sample > base ? sample - base : 0;
+	}
+
+	vector<Item> items;
+	uint64_t max_end;
+	uint64_t base;
+};
+
+static void check_row(RowData &row, RefRow &ref, mt19937 &rng, uint64_t tail)
+{
+	BOOST_REQUIRE_EQUAL(row.get_annotation_size(), ref.items.size());
+	BOOST_CHECK_EQUAL(row.get_max_sample(), ref.view(ref.max_end));
+
+	bool same = true;
+	for (uint64_t i = 0; i < ref.items.size(); i++){
+		Annotation a;
+		same &= row.get_annotation(&a, i) && a.res_index() == ref.items[i].id
+			&& a.start_sample() == ref.view(ref.items[i].start)
+			&& a.end_sample() == ref.view(ref.items[i].end);
+	}
+	BOOST_CHECK_MESSAGE(same, "items, base " << ref.base);
+
+	vector<uint64_t> views = {0, 1, ref.view(tail)};
+	for (int i = 0; i < 30; i++)
+		views.push_back(rng() % (ref.view(tail) + 1));
+
+	for (uint64_t v : views)
+	{
+		uint64_t index = 0;
+		while (index < ref.items.size() && ref.items[index].start <= v + ref.base)
+			index++;
+		BOOST_CHECK_EQUAL(row.get_annotation_index(v), index);
+
+		for (uint64_t width : {(uint64_t)333, (uint64_t)30000})
+		{
+			vector<Annotation> subset;
+			vector<int> expect;
+			row.get_annotation_subset(subset, v, v + width);
+
+			for (const RefRow::Item &i : ref.items){
+				if (i.start <= v + width + ref.base && i.end > v + ref.base)
+					expect.push_back(i.id);
+			}
+
+			bool match = subset.size() == expect.size();
+			for (uint64_t i = 0; match && i < subset.size(); i++)
+				match = subset[i].res_index() == expect[i];
+			BOOST_CHECK_MESSAGE(match, "base " << ref.base << ", view " << v
+				<< ", width " << width << ", got " << subset.size() << ", expect " << expect.size());
+		}
+	}
+}
+
+// Stacked decoders can put an annotation that starts before the last one.
+// It is moved into place, across the chunks and the index blocks, and the
+// row reads the same as a sorted copy.
+BOOST_AUTO_TEST_CASE(OutOfOrderAppend)
+{
+	mt19937 rng(5);
+	RowData row;
+	RefRow ref;
+	uint64_t tail = 0;
+	int id = 0;
+
+	auto push = [&](uint64_t start, uint64_t end){
+		BOOST_REQUIRE(row.push_annotation(Annotation(start, end, 0, 0, id, NULL)));
+		ref.push(start, end, id);
+		id++;
+	};
+
+	auto fill = [&](uint64_t count){
+		for (uint64_t i = 0; i < count; i++){
+			tail += 10;
+			push(tail, tail + 8);
+
+			if (i % 97 == 50){
+				// Back by up to 7000 items, a long one now and then.
+				const uint64_t back = min(tail, (uint64_t)(rng() % 70000));
+				const uint64_t len = (rng() % 4 == 0) ? 40000 : 5;
+				push(tail - back, tail - back + len);
+			}
+		}
+	};
+
+	fill(3 * 4096 + 300);
+
+	// Right behind a chunk and an index block border, and at the front.
+	push(4096 * 10 - 5, 4096 * 10 + 2);
+	push(64 * 10 + 10, 64 * 10 + 10);
+	push(0, 3);
+	push(tail - 1, tail + 1);
+	push(tail, tail + 2);
+
+	// A batch of them, as a decoder stack hands them over.
+	vector<Annotation> batch;
+	for (uint64_t i = 0; i < 200; i++){
+		const uint64_t start = (i % 2) ? tail - (rng() % 50000) : tail + i;
+		batch.push_back(Annotation(start, start + 20, 0, 0, id, NULL));
+		ref.push(start, start + 20, id);
+		id++;
+	}
+	BOOST_REQUIRE(row.push_annotations(batch));
+
+	check_row(row, ref, rng, tail);
+
+	// The front chunks are dropped, the ones pushed later go behind the base.
+	for (uint64_t base : {(uint64_t)30000, (uint64_t)50000, (uint64_t)90000})
+	{
+		row.set_sample_base(base);
+		ref.set_sample_base(base);
+		check_row(row, ref, rng, tail);
+
+		fill(2000);
+		push(base - 100, base + 50);
+		push(base + 3, base + 4);
+		check_row(row, ref, rng, tail);
+	}
+
+	row.clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,383 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+#include "logicfeed.h"
+
+using namespace std;
+using namespace logicfeed;
+using pv::data::LogicSnapshot;
+
+BOOST_AUTO_TEST_SUITE(LogicBlocksTest)
+
+// A leaf block as the session driver finds it in a file saved with the mipmap.
+struct BlockEntry
+{
+	uint16_t order;
+	uint64_t index;
+	uint64_t data_len;
+	uint64_t offset; // 0 for a constant block
+	bool level;
+};
+
+// Writes the whole leaf blocks at 8 byte aligned offsets, as StoreSession
+// stores them when saveMipmap is on.
+static bool save_blocks(LogicSnapshot &snapshot, int channels, const char *path,
+						vector<BlockEntry> &entries)
+{
+	FILE *file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+
+	const uint64_t space = LogicSnapshot::get_leaf_block_space();
+	const char pad[8] = {0};
+	uint64_t pos = 0;
+	bool ok = true;
+	entries.clear();
+
+	for (int ch = 0; ch < channels; ch++){
+		for (int i = 0; i < snapshot.get_block_num(); i++){
+			bool level = false;
+			const uint8_t *lbp = snapshot.get_block_buf(i, ch, level);
+			BlockEntry e = {(uint16_t)ch, (uint64_t)i, snapshot.get_block_size(i), 0, level};
+
+			if (lbp != NULL){
+				// Leave the first 8 bytes out, an offset of 0 is a constant block.
+				const uint64_t skip = 8 - pos % 8;
+				ok &= fwrite(pad, 1, skip, file) == skip;
+				pos += skip;
+				e.offset = pos;
+				ok &= fwrite(lbp, 1, space, file) == space;
+				pos += space;
+			}
+			entries.push_back(e);
+		}
+	}
+
+	return fclose(file) == 0 && ok;
+}
+
+// Sends the blocks of the mapped file, as the session driver does.
+static bool load_blocks(LogicSnapshot &snapshot, Probes &probes, uint64_t samples,
+						const char *path, const vector<BlockEntry> &entries)
+{
+	GMappedFile *file = g_mapped_file_new(path, FALSE, NULL);
+	if (file == NULL)
+		return false;
+
+	const char *contents = g_mapped_file_get_contents(file);
+	bool ok = true;
+
+	for (size_t i = 0; i < entries.size(); i++){
+		const BlockEntry &e = entries[i];
+		sr_datafeed_logic_block block;
+		memset(&block, 0, sizeof(block));
+		block.order = e.order;
+		block.index = e.index;
+		block.data_len = e.data_len;
+		block.level = e.level ? 0xff : 0;
+		block.scale_power = LogicSnapshot::get_scale_power();
+		block.scale_level = LogicSnapshot::get_scale_level();
+		block.file = file;
+
+		if (e.offset > 0){
+			block.data = contents + e.offset;
+			block.size = LogicSnapshot::get_leaf_block_space();
+		}
+
+		if (i == 0)
+			ok &= snapshot.first_block(block, samples, probes.list());
+		else
+			ok &= snapshot.append_block(block);
+	}
+
+	snapshot.capture_ended();
+	g_mapped_file_unref(file);
+	return ok;
+}
+
+static bool same_samples(LogicSnapshot &snapshot, const Capture &cap)
+{
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+
+	if (snapshot.get_ring_sample_count() != cap.samples)
+		return false;
+
+	for (int ch = 0; ch < cap.channels(); ch++){
+		for (int i = 0; i < snapshot.get_block_num(); i++){
+			bool level = false;
+			const uint8_t *data = snapshot.get_block_buf(i, ch, level);
+			const uint64_t words = snapshot.get_block_size(i) / 8;
+			const uint64_t *expect = cap.words[ch].data() + i * block / 64;
+
+			for (uint64_t w = 0; w < words; w++){
+				const uint64_t v = data ? ((const uint64_t*)data)[w] : (level ? ~0ULL : 0);
+				if (v != expect[w])
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+static Capture make_capture()
+{
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+	mt19937_64 rng(5);
+	Capture cap(3, 2 * block + 64 * 300);
+
+	cap.set_random(0, rng, 1, 500);
+	// Constant low, then high from the middle of the second block.
+	cap.set_edges(1, {block + 12345});
+	cap.set_random(2, rng, 20, 40000);
+	return cap;
+}
+
+// Open a file saved with its mipmap, save it to the same path and open it
+// again. The blocks in use point into the file while it is written.
+BOOST_AUTO_TEST_CASE(SaveOverMappedFile)
+{
+	const char *path = "logicblocks_mapped.bin";
+	const Capture cap = make_capture();
+	Probes probes(cap.channels());
+	vector<BlockEntry> entries;
+
+	{
+		LogicSnapshot captured;
+		feed(captured, probes, cap, 4000);
+		BOOST_REQUIRE(save_blocks(captured, cap.channels(), path, entries));
+	}
+
+	LogicSnapshot loaded;
+	BOOST_REQUIRE(load_blocks(loaded, probes, cap.samples, path, entries));
+	BOOST_CHECK(loaded.has_mapped_blocks());
+	BOOST_CHECK(same_samples(loaded, cap));
+
+	BOOST_REQUIRE(loaded.copy_mapped_blocks());
+	BOOST_CHECK(!loaded.has_mapped_blocks());
+
+	// Truncates the file first, the snapshot must not read it any more.
+	vector<BlockEntry> saved;
+	BOOST_REQUIRE(save_blocks(loaded, cap.channels(), path, saved));
+	BOOST_CHECK(same_samples(loaded, cap));
+
+	LogicSnapshot reloaded;
+	BOOST_REQUIRE(load_blocks(reloaded, probes, cap.samples, path, saved));
+	BOOST_CHECK(same_samples(reloaded, cap));
+
+	reloaded.free_data();
+	remove(path);
+}
+
+// The blocks of a file get the summaries of the captured ones.
+BOOST_AUTO_TEST_CASE(LoadedBlocksHaveStats)
+{
+	const char *path = "logicblocks_stats.bin";
+	const Capture cap = make_capture();
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+	Probes probes(cap.channels());
+	vector<BlockEntry> entries;
+	LogicSnapshot captured;
+
+	feed(captured, probes, cap, 4000);
+	BOOST_REQUIRE(save_blocks(captured, cap.channels(), path, entries));
+
+	LogicSnapshot loaded;
+	BOOST_REQUIRE(load_blocks(loaded, probes, cap.samples, path, entries));
+
+	for (int ch = 0; ch < cap.channels(); ch++){
+		for (uint64_t b = 0; b < cap.samples / block; b++){
+			LogicSnapshot::LeafStats a, l;
+			BOOST_REQUIRE(captured.get_leaf_stats(b * block, ch, a));
+			BOOST_REQUIRE(loaded.get_leaf_stats(b * block, ch, l));
+			BOOST_CHECK_MESSAGE(memcmp(&a, &l, sizeof(a)) == 0, "channel " << ch << ", block " << b);
+		}
+	}
+
+	loaded.free_data();
+	remove(path);
+}
+
+// Only the mipmap levels of a reused block are cleared, the samples are
+// written again.
+BOOST_AUTO_TEST_CASE(ReusedBlocksGetNewLevels)
+{
+	const Capture cap = make_capture();
+	const uint64_t samples_space = LogicSnapshot::get_leaf_block_samples() / 8;
+	const uint64_t levels_space = LogicSnapshot::get_leaf_block_space() - samples_space;
+	Probes probes(cap.channels());
+	mt19937_64 rng(9);
+
+	// Toggles in every block of each channel.
+	Capture noise(cap.channels(), cap.samples);
+	for (int ch = 0; ch < cap.channels(); ch++)
+		noise.set_random(ch, rng, 1, 50);
+
+	LogicSnapshot reused;
+	feed(reused, probes, noise, 4000);
+	feed(reused, probes, cap, 4000);
+
+	LogicSnapshot fresh;
+	feed(fresh, probes, cap, 4000);
+
+	BOOST_CHECK(same_samples(reused, cap));
+	BOOST_REQUIRE_EQUAL(reused.get_block_num(), fresh.get_block_num());
+
+	for (int ch = 0; ch < cap.channels(); ch++){
+		for (int i = 0; i < fresh.get_block_num(); i++){
+			bool rlevel = false;
+			bool flevel = false;
+			const uint8_t *r = reused.get_block_buf(i, ch, rlevel);
+			const uint8_t *f = fresh.get_block_buf(i, ch, flevel);
+
+			BOOST_REQUIRE_EQUAL(r == NULL, f == NULL);
+			if (r == NULL){
+				BOOST_CHECK_EQUAL(rlevel, flevel);
+				continue;
+			}
+			BOOST_CHECK_MESSAGE(memcmp(r + samples_space, f + samples_space, levels_space) == 0,
+				"channel " << ch << ", block " << i);
+		}
+	}
+}
+
+// The mipmap built a few rows at a time, the worker going over each block
+// many times, is the one built in a single pass over the block.
+BOOST_AUTO_TEST_CASE(IncrementalMipmapMatchesRebuild)
+{
+	Capture cap = make_capture();
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+	const uint64_t samples_space = block / 8;
+	const uint64_t levels_space = LogicSnapshot::get_leaf_block_space() - samples_space;
+	const uint64_t rows = cap.samples / 64;
+	Probes probes(cap.channels());
+	mt19937_64 rng(13);
+
+	// Constant words, toggling only on the boundaries the passes stop at.
+	vector<uint64_t> edges;
+	for (uint64_t i = 64; i < cap.samples; i += 64 * (1 + rng() % 3))
+		edges.push_back(i);
+	cap.set_edges(0, edges);
+
+	LogicSnapshot incremental;
+	incremental.init();
+	int passes = 0;
+
+	for (uint64_t r = 0; r < rows;)
+	{
+		// Odd sizes, the passes end anywhere in a word of the levels.
+		const uint64_t n = min(rows - r, 1 + rng() % 4000);
+		vector<uint64_t> data = cross_rows(cap, r, n);
+		sr_datafeed_logic logic;
+		memset(&logic, 0, sizeof(logic));
+		logic.format = LA_CROSS_DATA;
+		logic.length = data.size() * 8;
+		logic.data = data.data();
+
+		if (r == 0)
+			incremental.first_payload(logic, cap.samples, probes.list());
+		else
+			incremental.append_payload(logic);
+		r += n;
+
+		// Let the worker catch up before the next rows arrive.
+		for (int i = 0; i < 100 && incremental.get_ring_sample_count() < r * 64; i++)
+			incremental.wait_samples(r * 64 - 1, 100);
+		if (incremental.get_ring_sample_count() == r * 64 && (r * 64) % block != 0)
+			passes++;
+	}
+	incremental.capture_ended();
+
+	LogicSnapshot rebuilt;
+	feed(rebuilt, probes, cap, rows);
+
+	// Most passes stopped inside a block.
+	BOOST_CHECK(passes > 100);
+	BOOST_CHECK(same_samples(incremental, cap));
+	BOOST_REQUIRE_EQUAL(incremental.get_block_num(), rebuilt.get_block_num());
+
+	for (int ch = 0; ch < cap.channels(); ch++){
+		for (int i = 0; i < rebuilt.get_block_num(); i++){
+			bool ilevel = false;
+			bool rlevel = false;
+			const uint8_t *a = incremental.get_block_buf(i, ch, ilevel);
+			const uint8_t *b = rebuilt.get_block_buf(i, ch, rlevel);
+
+			BOOST_REQUIRE_EQUAL(a == NULL, b == NULL);
+			if (a == NULL){
+				BOOST_CHECK_EQUAL(ilevel, rlevel);
+				continue;
+			}
+			BOOST_CHECK_MESSAGE(memcmp(a + samples_space, b + samples_space, levels_space) == 0,
+				"channel " << ch << ", block " << i);
+
+			LogicSnapshot::LeafStats is, rs;
+			const bool ihas = incremental.get_leaf_stats(i * block, ch, is);
+			BOOST_REQUIRE_EQUAL(ihas, rebuilt.get_leaf_stats(i * block, ch, rs));
+			if (ihas)
+				BOOST_CHECK(memcmp(&is, &rs, sizeof(is)) == 0);
+		}
+	}
+}
+
+// A block held by a decoder keeps the file mapped.
+BOOST_AUTO_TEST_CASE(CopyWhileDecoding)
+{
+	const char *path = "logicblocks_decode.bin";
+	const Capture cap = make_capture();
+	Probes probes(cap.channels());
+	vector<BlockEntry> entries;
+
+	{
+		LogicSnapshot captured;
+		feed(captured, probes, cap, 4000);
+		BOOST_REQUIRE(save_blocks(captured, cap.channels(), path, entries));
+	}
+
+	LogicSnapshot loaded;
+	BOOST_REQUIRE(load_blocks(loaded, probes, cap.samples, path, entries));
+
+	void *lbp = NULL;
+	uint64_t end = cap.samples - 1;
+	loaded.decode_begin();
+	BOOST_REQUIRE(loaded.get_samples(0, end, 0, &lbp) != NULL);
+
+	BOOST_CHECK(!loaded.copy_mapped_blocks());
+	BOOST_CHECK(loaded.has_mapped_blocks());
+
+	loaded.free_decode_lpb(lbp);
+	loaded.decode_end();
+
+	BOOST_CHECK(loaded.copy_mapped_blocks());
+	BOOST_CHECK(!loaded.has_mapped_blocks());
+	BOOST_CHECK(same_samples(loaded, cap));
+
+	remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_TEST_LOGICFEED_H
+#define DSVIEW_TEST_LOGICFEED_H
+
+#include <glib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "../../pv/data/logicsnapshot.h"
+
+// Builds a LogicSnapshot from known samples the way a capture fills it:
+// cross data packets, 64 samples of each channel in turn.
+namespace logicfeed
+{
+
+struct Capture
+{
+	uint64_t samples; // a multiple of 64
+	std::vector<std::vector<uint64_t>> words; // per channel, LSB first
+
+	Capture(int channels, uint64_t sample_count) :
+		samples(sample_count),
+		words(channels, std::vector<uint64_t>(sample_count / 64, 0))
+	{
+	}
+
+	bool bit(int ch, uint64_t i) const
+	{
+		return (words[ch][i / 64] >> (i % 64)) & 1;
+	}
+
+	void set(int ch, uint64_t i, bool v)
+	{
+		if (v)
+			words[ch][i / 64] |= 1ULL << (i % 64);
+		else
+			words[ch][i / 64] &= ~(1ULL << (i % 64));
+	}
+
+	// Toggle at each edge position, from the given start level.
+	void set_edges(int ch, const std::vector<uint64_t> &edges, bool level = false)
+	{
+		uint64_t e = 0;
+		for (uint64_t i = 0; i < samples; i++){
+			while (e < edges.size() && edges[e] == i){
+				level = !level;
+				e++;
+			}
+			set(ch, i, level);
+		}
+	}
+
+	// Pulses of random width between min_len and max_len samples.
+	void set_random(int ch, std::mt19937_64 &rng, uint64_t min_len, uint64_t max_len)
+	{
+		std::vector<uint64_t> edges;
+		for (uint64_t i = rng() % max_len; i < samples; i += min_len + rng() % (max_len - min_len + 1))
+			edges.push_back(i);
+		set_edges(ch, edges, rng() & 1);
+	}
+
+	int channels() const
+	{
+		return words.size();
+	}
+};
+
+// The probes of a device with all its logic channels enabled.
+class Probes
+{
+public:
+	explicit Probes(int count) :
+		_probes(count), _list(NULL)
+	{
+		for (int i = 0; i < count; i++){
+			memset(&_probes[i], 0, sizeof(sr_channel));
+			_probes[i].index = i;
+			_probes[i].type = SR_CHANNEL_LOGIC;
+			_probes[i].enabled = TRUE;
+			_list = g_slist_append(_list, &_probes[i]);
+		}
+	}
+
+	~Probes()
+	{
+		g_slist_free(_list);
+	}
+
+	GSList *list()
+	{
+		return _list;
+	}
+
+private:
+	std::vector<sr_channel> _probes;
+	GSList *_list;
+};
+
+// The cross data of rows [row, row + count), one 64 bit word per channel and row.
+inline std::vector<uint64_t> cross_rows(const Capture &cap, uint64_t row, uint64_t count)
+{
+	std::vector<uint64_t> data;
+	for (uint64_t r = row; r < row + count; r++){
+		for (int ch = 0; ch < cap.channels(); ch++)
+			data.push_back(cap.words[ch][r]);
+	}
+	return data;
+}
+
+// Feed the capture in packets of packet_rows rows, end it unless told not to.
+inline void feed(pv::data::LogicSnapshot &snapshot, Probes &probes, const Capture &cap,
+				 uint64_t packet_rows, bool end = true)
+{
+	const uint64_t rows = cap.samples / 64;
+
+	// SigSession resets the snapshot before a capture starts.
+	snapshot.init();
+
+	for (uint64_t r = 0; r < rows; r += packet_rows)
+	{
+		std::vector<uint64_t> data = cross_rows(cap, r, std::min(packet_rows, rows - r));
+
+		sr_datafeed_logic logic;
+		memset(&logic, 0, sizeof(logic));
+		logic.format = LA_CROSS_DATA;
+		logic.length = data.size() * 8;
+		logic.data = data.data();
+
+		if (r == 0)
+			snapshot.first_payload(logic, cap.samples, probes.list());
+		else
+			snapshot.append_payload(logic);
+	}
+
+	if (end)
+		snapshot.capture_ended();
+}
+
+} // namespace logicfeed
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include <boost/test/unit_test.hpp>
+
+#include "logicfeed.h"
+
+using namespace std;
+using namespace logicfeed;
+using pv::data::LogicSnapshot;
+
+BOOST_AUTO_TEST_SUITE(LogicIngestTest)
+
+// The best of the runs is reported.
+static const int BenchRuns = 3;
+
+// Cross data packets through append_payload(), as the USB transfers of a
+// 16 channel capture arrive. One packet of random rows is sent again and
+// again, the samples are checked once the capture ends.
+BOOST_AUTO_TEST_CASE(IngestCrossPayloads)
+{
+	const int channels = 16;
+	const uint64_t packet_rows = 8192; // 1MB
+	const uint64_t samples = 4 * LogicSnapshot::get_leaf_block_samples();
+	const uint64_t packets = samples / 64 / packet_rows;
+	Capture cap(channels, packet_rows * 64);
+	Probes probes(channels);
+	mt19937_64 rng(21);
+
+	for (int ch = 0; ch < channels; ch++){
+		for (uint64_t &w : cap.words[ch])
+			w = rng();
+	}
+
+	vector<uint64_t> data = cross_rows(cap, 0, packet_rows);
+	sr_datafeed_logic logic;
+	memset(&logic, 0, sizeof(logic));
+	logic.format = LA_CROSS_DATA;
+	logic.length = data.size() * 8;
+	logic.data = data.data();
+
+	double sec = 0;
+
+	for (int run = 0; run < BenchRuns; run++)
+	{
+		LogicSnapshot snapshot;
+		snapshot.init();
+
+		auto begin = chrono::steady_clock::now();
+		snapshot.first_payload(logic, samples, probes.list());
+		for (uint64_t p = 1; p < packets; p++)
+			snapshot.append_payload(logic);
+		chrono::duration<double> d = chrono::steady_clock::now() - begin;
+		sec = (run == 0) ? d.count() : min(sec, d.count());
+
+		snapshot.capture_ended();
+		BOOST_REQUIRE_EQUAL(snapshot.get_ring_sample_count(), samples);
+
+		bool same = true;
+		for (int ch = 0; ch < channels; ch++){
+			for (int i = 0; i < snapshot.get_block_num(); i++){
+				bool level = false;
+				const uint64_t *w = (const uint64_t*)snapshot.get_block_buf(i, ch, level);
+				const uint64_t words = snapshot.get_block_size(i) / 8;
+
+				same &= (w != NULL);
+				for (uint64_t k = 0; w && k < words; k++)
+					same &= (w[k] == cap.words[ch][k % packet_rows]);
+			}
+		}
+		BOOST_CHECK_MESSAGE(same, "run " << run);
+	}
+
+	BOOST_TEST_MESSAGE("ingest, channels:" << channels
+		<< ", " << samples * channels / 8 / sec / 1e9 << " GB/s");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
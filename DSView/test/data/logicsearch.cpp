@@ -0,0 +1,281 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <future>
+#include <chrono>
+
+#include <boost/test/unit_test.hpp>
+
+#include "logicfeed.h"
+
+using namespace std;
+using namespace logicfeed;
+using pv::data::LogicSnapshot;
+
+BOOST_AUTO_TEST_SUITE(LogicSearchTest)
+
+typedef map<uint16_t, QString> Pattern;
+
+static bool is_edge_flag(char flag)
+{
+	return flag == 'R' || flag == 'F' || flag == 'C';
+}
+
+static bool has_edge_flag(const Pattern &pattern)
+{
+	for (auto &p : pattern){
+		if (is_edge_flag(p.second.toStdString()[0]))
+			return true;
+	}
+	return false;
+}
+
+// The sample by sample definition of a match at q: the level channels are
+// read at lv, the edge channels toggle between q - 1 and q.
+static bool match_at(const Capture &cap, const Pattern &pattern, uint64_t q, uint64_t lv)
+{
+	for (auto &p : pattern)
+	{
+		const char flag = p.second.toStdString()[0];
+		const int ch = p.first;
+		const bool pre = q > 0 ? cap.bit(ch, q - 1) : false;
+		const bool cur = cap.bit(ch, q);
+
+		if ((flag == '0' && cap.bit(ch, lv))
+			|| (flag == '1' && !cap.bit(ch, lv))
+			|| (flag == 'R' && !(!pre && cur))
+			|| (flag == 'F' && !(pre && !cur))
+			|| (flag == 'C' && pre == cur))
+			return false;
+	}
+	return true;
+}
+
+// The matches of a next search at q, the levels at q. An edge needs the
+// sample before it.
+static vector<uint64_t> next_hits(const Capture &cap, const Pattern &pattern)
+{
+	vector<uint64_t> hits;
+	for (uint64_t q = has_edge_flag(pattern) ? 1 : 0; q < cap.samples; q++){
+		if (match_at(cap, pattern, q, q))
+			hits.push_back(q);
+	}
+	return hits;
+}
+
+// The matches of a previous search at q, the levels at q - 1.
+static vector<uint64_t> prev_hits(const Capture &cap, const Pattern &pattern)
+{
+	vector<uint64_t> hits;
+	for (uint64_t q = 1; q < cap.samples; q++){
+		if (match_at(cap, pattern, q, q - 1))
+			hits.push_back(q);
+	}
+	return hits;
+}
+
+static Capture make_capture()
+{
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+	const uint64_t samples = 2 * block + 64 * 777;
+	mt19937_64 rng(17);
+	Capture cap(4, samples);
+
+	// Edges around the word boundaries, the second leaf block is idle.
+	cap.set_edges(0, {1, 63, 64, 65, 127, 4095, 4096, 100000, block - 1,
+		2 * block + 5, 2 * block + 64 * 3, samples - 2});
+	cap.set_random(1, rng, 1, 300);
+	cap.set_random(2, rng, 1, 6);
+	// Constant high, its blocks are not kept.
+	cap.set_edges(3, {}, true);
+
+	return cap;
+}
+
+struct SearchFixture
+{
+	SearchFixture() :
+		cap(make_capture()), probes(cap.channels())
+	{
+		feed(snapshot, probes, cap, 1000);
+	}
+
+	Capture cap;
+	Probes probes;
+	LogicSnapshot snapshot;
+};
+
+static vector<Pattern> make_patterns()
+{
+	return {
+		{{0, "R"}},
+		{{0, "C"}, {3, "1"}},
+		{{1, "F"}, {2, "1"}},
+		{{1, "R"}, {2, "R"}},
+		{{2, "0"}, {1, "1"}},
+		{{0, "1"}, {2, "C"}, {1, "X"}},
+		{{3, "0"}},
+		{{0, "F"}, {3, "0"}},
+	};
+}
+
+static vector<int64_t> start_positions(const Capture &cap)
+{
+	const int64_t block = LogicSnapshot::get_leaf_block_samples();
+	vector<int64_t> pos = {1, 2, 62, 63, 64, 65, 4094, 99999, 100000, block - 2,
+		block, block + 12345, 2 * block - 1, 2 * block + 4, (int64_t)cap.samples - 3};
+	mt19937_64 rng(3);
+	for (int i = 0; i < 20; i++)
+		pos.push_back(1 + rng() % (cap.samples - 3));
+	return pos;
+}
+
+BOOST_FIXTURE_TEST_CASE(SearchNextMatchesPerSample, SearchFixture)
+{
+	const int64_t end = cap.samples - 1;
+
+	for (Pattern &pattern : make_patterns())
+	{
+		const vector<uint64_t> hits = next_hits(cap, pattern);
+		// A level pattern matches at the start position, an edge after it.
+		const int64_t first = has_edge_flag(pattern) ? 1 : 0;
+
+		for (int64_t start : start_positions(cap))
+		{
+			int64_t index = start;
+			const bool found = snapshot.pattern_search(0, end, index, pattern, true);
+			auto it = lower_bound(hits.begin(), hits.end(), (uint64_t)(start + first));
+			const bool rfound = it != hits.end();
+
+			BOOST_CHECK_EQUAL(found, rfound);
+			if (found && rfound)
+				BOOST_CHECK_EQUAL((uint64_t)index, *it);
+		}
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(SearchPreviousMatchesPerSample, SearchFixture)
+{
+	const int64_t end = cap.samples - 1;
+
+	for (Pattern &pattern : make_patterns())
+	{
+		const vector<uint64_t> hits = prev_hits(cap, pattern);
+		// The result is the position after the matched levels.
+		const int64_t last = has_edge_flag(pattern) ? 0 : 1;
+
+		for (int64_t start : start_positions(cap))
+		{
+			int64_t index = start;
+			const bool found = snapshot.pattern_search(0, end, index, pattern, false);
+			auto it = upper_bound(hits.begin(), hits.end(), (uint64_t)(start + last));
+			const bool rfound = it != hits.begin();
+
+			BOOST_CHECK_EQUAL(found, rfound);
+			if (found && rfound)
+				BOOST_CHECK_EQUAL((uint64_t)index, *(it - 1));
+		}
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(FindAllMatchesPerSample, SearchFixture)
+{
+	for (Pattern &pattern : make_patterns())
+	{
+		vector<uint64_t> hits;
+		const vector<uint64_t> ref = next_hits(cap, pattern);
+
+		BOOST_CHECK(snapshot.pattern_search_all(0, cap.samples - 1, hits, pattern, UINT64_MAX));
+		BOOST_CHECK_EQUAL(hits.size(), ref.size());
+		BOOST_CHECK(hits == ref);
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(FindAllStopsAtLimit, SearchFixture)
+{
+	Pattern pattern = {{2, "C"}};
+	const vector<uint64_t> ref = next_hits(cap, pattern);
+	vector<uint64_t> hits;
+
+	BOOST_REQUIRE(ref.size() > 1000);
+	BOOST_CHECK(snapshot.pattern_search_all(0, cap.samples - 1, hits, pattern, 1000));
+	BOOST_CHECK(hits == vector<uint64_t>(ref.begin(), ref.begin() + 1000));
+
+	// A range inside the capture.
+	const uint64_t lo = ref[500] - 1;
+	const uint64_t hi = ref[900];
+	BOOST_CHECK(snapshot.pattern_search_all(lo, hi, hits, pattern, UINT64_MAX));
+	BOOST_CHECK(hits == vector<uint64_t>(ref.begin() + 500, ref.begin() + 901));
+}
+
+// Find all hands over the hits of each chunk with the snapshot unlocked.
+BOOST_FIXTURE_TEST_CASE(FindAllStreamsHits, SearchFixture)
+{
+	Pattern pattern = {{1, "C"}};
+	vector<uint64_t> hits;
+	vector<uint64_t> streamed;
+	int calls = 0;
+	int unlocked = 0;
+
+	BOOST_CHECK(snapshot.pattern_search_all(0, cap.samples - 1, hits, pattern, UINT64_MAX,
+		[&](const vector<uint64_t> &found){
+			calls++;
+			streamed.insert(streamed.end(), found.begin(), found.end());
+
+			// Another reader gets the snapshot while the search is paused.
+			auto reader = async(launch::async, [&]{ return snapshot.get_sample(found[0], 1); });
+			if (reader.wait_for(chrono::seconds(5)) == future_status::ready){
+				unlocked++;
+				reader.get();
+			}
+		}));
+
+	// One call per leaf block of the capture.
+	BOOST_CHECK_EQUAL(calls, 3);
+	BOOST_CHECK_EQUAL(unlocked, calls);
+	BOOST_CHECK(streamed == hits);
+	BOOST_CHECK(hits == next_hits(cap, pattern));
+}
+
+BOOST_FIXTURE_TEST_CASE(FindAllCancel, SearchFixture)
+{
+	Pattern pattern = {{2, "C"}};
+	vector<uint64_t> hits;
+	int calls = 0;
+
+	BOOST_CHECK(!snapshot.pattern_search_all(0, cap.samples - 1, hits, pattern, UINT64_MAX,
+		[&](const vector<uint64_t> &){
+			calls++;
+			snapshot.cancel_search();
+		}));
+
+	BOOST_CHECK_EQUAL(calls, 1);
+	BOOST_CHECK(!hits.empty());
+	BOOST_CHECK(hits.back() < LogicSnapshot::get_leaf_block_samples());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,253 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+#include "logicfeed.h"
+
+using namespace std;
+using namespace logicfeed;
+using pv::data::LogicSnapshot;
+
+BOOST_AUTO_TEST_SUITE(LogicStatsTest)
+
+typedef LogicSnapshot::RangeStats RangeStats;
+
+// The edges of each channel, sample s is an edge when it differs from s - 1.
+struct ChannelEdges
+{
+	vector<uint64_t> pos;
+	vector<uint64_t> ones; // the high samples before each word
+
+	ChannelEdges(const Capture &cap, int ch)
+	{
+		uint64_t last = cap.words[ch][0] & 1;
+		uint64_t count = 0;
+
+		for (uint64_t w = 0; w < cap.words[ch].size(); w++)
+		{
+			const uint64_t word = cap.words[ch][w];
+			uint64_t edges = word ^ ((word << 1) | last);
+
+			for (int b = 0; b < 64; b++){
+				if ((edges >> b) & 1)
+					pos.push_back(w * 64 + b);
+			}
+			ones.push_back(count);
+			count += __builtin_popcountll(word);
+			last = word >> 63;
+		}
+		ones.push_back(count);
+	}
+};
+
+static uint64_t ones_before(const Capture &cap, const ChannelEdges &e, int ch, uint64_t s)
+{
+	uint64_t n = e.ones[s / 64];
+	for (uint64_t i = s & ~63ULL; i < s; i++)
+		n += cap.bit(ch, i);
+	return n;
+}
+
+// The sample by sample definition of the stats of [start, end].
+static RangeStats ref_stats(const Capture &cap, const ChannelEdges &e, int ch,
+							uint64_t start, uint64_t end)
+{
+	RangeStats st = {0, 0, 0, 0, 0, 0, 0};
+	const uint64_t lo = upper_bound(e.pos.begin(), e.pos.end(), start) - e.pos.begin();
+	const uint64_t hi = upper_bound(e.pos.begin(), e.pos.end(), end) - e.pos.begin();
+
+	st.high_samples = ones_before(cap, e, ch, end + 1) - ones_before(cap, e, ch, start);
+
+	for (uint64_t k = lo; k < hi; k++)
+	{
+		const bool high = cap.bit(ch, e.pos[k]);
+		st.rising += high;
+		st.falling += !high;
+
+		if (k + 1 < hi){
+			const uint64_t width = e.pos[k + 1] - e.pos[k];
+			uint64_t &min_width = high ? st.min_high : st.min_low;
+			uint64_t &max_width = high ? st.max_high : st.max_low;
+			if (min_width == 0 || width < min_width)
+				min_width = width;
+			max_width = max(max_width, width);
+		}
+	}
+	return st;
+}
+
+static Capture make_capture()
+{
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+	const uint64_t samples = 3 * block + 64 * 777;
+	mt19937_64 rng(23);
+	Capture cap(4, samples);
+
+	cap.set_random(0, rng, 1, 300);
+	// An edge on a block start, then an idle block.
+	cap.set_edges(1, {100, block, 2 * block + 5, 2 * block + 64 * 3, 3 * block + 10});
+	cap.set_random(2, rng, 1, 6);
+	// Constant high, its blocks are not kept.
+	cap.set_edges(3, {}, true);
+
+	return cap;
+}
+
+struct StatsFixture
+{
+	StatsFixture() :
+		cap(make_capture()), probes(cap.channels())
+	{
+		feed(snapshot, probes, cap, 1000);
+		for (int ch = 0; ch < cap.channels(); ch++)
+			edges.push_back(ChannelEdges(cap, ch));
+	}
+
+	Capture cap;
+	Probes probes;
+	LogicSnapshot snapshot;
+	vector<ChannelEdges> edges;
+};
+
+static vector<pair<uint64_t, uint64_t>> make_ranges(const Capture &cap)
+{
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+	const uint64_t last = cap.samples - 1;
+	vector<pair<uint64_t, uint64_t>> ranges = {
+		{0, 0}, {0, 63}, {5, 70}, {63, 64}, {1000, 1000 + 64 * 5 + 3},
+		{0, last}, {1, last}, {block - 1, block}, {block, 2 * block - 1},
+		{block - 1, 2 * block}, {block + 1, 3 * block - 1}, {100, 3 * block},
+		{2 * block + 3, last}, {3 * block, last},
+	};
+	mt19937_64 rng(4);
+	for (int i = 0; i < 10; i++){
+		uint64_t a = rng() % cap.samples;
+		uint64_t b = rng() % cap.samples;
+		ranges.push_back({min(a, b), max(a, b)});
+	}
+	return ranges;
+}
+
+static bool same_stats(const RangeStats &a, const RangeStats &b, bool with_pulses)
+{
+	return a.rising == b.rising && a.falling == b.falling && a.high_samples == b.high_samples
+		&& (!with_pulses || (a.min_high == b.min_high && a.max_high == b.max_high
+			&& a.min_low == b.min_low && a.max_low == b.max_low));
+}
+
+BOOST_FIXTURE_TEST_CASE(RangeStatsMatchPerSample, StatsFixture)
+{
+	for (auto &r : make_ranges(cap))
+	{
+		for (int ch = 0; ch < cap.channels(); ch++)
+		{
+			const RangeStats ref = ref_stats(cap, edges[ch], ch, r.first, r.second);
+
+			for (bool with_pulses : {true, false})
+			{
+				RangeStats st;
+				BOOST_REQUIRE(snapshot.get_range_stats(r.first, r.second, ch, st, with_pulses));
+				BOOST_CHECK_MESSAGE(same_stats(st, ref, with_pulses), "channel " << ch
+					<< ", [" << r.first << ", " << r.second << "], pulses " << with_pulses
+					<< ", got " << st.rising << "/" << st.falling << "/" << st.high_samples
+					<< " " << st.min_high << "-" << st.max_high << " " << st.min_low << "-" << st.max_low
+					<< ", expect " << ref.rising << "/" << ref.falling << "/" << ref.high_samples
+					<< " " << ref.min_high << "-" << ref.max_high << " " << ref.min_low << "-" << ref.max_low);
+			}
+		}
+	}
+}
+
+typedef LogicSnapshot::LeafStats LeafStats;
+
+// The summary of the leaf block from block_start, from the edges inside it.
+static LeafStats ref_leaf_stats(const Capture &cap, const ChannelEdges &e, int ch,
+								uint64_t block_start)
+{
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+	const RangeStats rs = ref_stats(cap, e, ch, block_start, block_start + block - 1);
+	LeafStats st = {0, 0, 0, 0, 0, 0, 0, 0};
+
+	st.edges = rs.rising + rs.falling;
+	st.ones = rs.high_samples;
+	st.min_high = rs.min_high;
+	st.max_high = rs.max_high;
+	st.min_low = rs.min_low;
+	st.max_low = rs.max_low;
+
+	if (st.edges > 0){
+		const uint64_t lo = upper_bound(e.pos.begin(), e.pos.end(), block_start) - e.pos.begin();
+		st.first_edge = e.pos[lo] - block_start;
+		st.last_edge = e.pos[lo + st.edges - 1] - block_start;
+	}
+	return st;
+}
+
+static bool same_leaf_stats(const LeafStats &a, const LeafStats &b)
+{
+	return a.edges == b.edges && a.ones == b.ones && a.first_edge == b.first_edge
+		&& a.last_edge == b.last_edge && a.min_high == b.min_high && a.max_high == b.max_high
+		&& a.min_low == b.min_low && a.max_low == b.max_low;
+}
+
+BOOST_FIXTURE_TEST_CASE(LeafStatsMatchPerSample, StatsFixture)
+{
+	const uint64_t block = LogicSnapshot::get_leaf_block_samples();
+
+	for (int ch = 0; ch < cap.channels(); ch++)
+	{
+		for (uint64_t b = 0; b < cap.samples / block; b++)
+		{
+			const LeafStats ref = ref_leaf_stats(cap, edges[ch], ch, b * block);
+
+			// Any sample of the block gives its summary.
+			for (uint64_t index : {b * block, b * block + 12345, (b + 1) * block - 1})
+			{
+				LeafStats st;
+				BOOST_REQUIRE(snapshot.get_leaf_stats(index, ch, st));
+				BOOST_CHECK_MESSAGE(same_leaf_stats(st, ref), "channel " << ch << ", block " << b
+					<< ", got " << st.edges << "/" << st.ones << " " << st.first_edge << "-" << st.last_edge
+					<< ", expect " << ref.edges << "/" << ref.ones << " " << ref.first_edge << "-" << ref.last_edge);
+			}
+		}
+
+		// The last block is not complete.
+		LeafStats st;
+		BOOST_CHECK(!snapshot.get_leaf_stats(cap.samples - 1, ch, st));
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(RangeStatsBadRange, StatsFixture)
+{
+	RangeStats st;
+
+	BOOST_CHECK(!snapshot.get_range_stats(10, 9, 0, st));
+	BOOST_CHECK(!snapshot.get_range_stats(0, cap.samples, 0, st));
+	BOOST_CHECK(!snapshot.get_range_stats(0, 10, cap.channels(), st));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <glib.h>
+#include <stdint.h>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+extern "C" {
+#include "../../../libsigrok4DSL/libsigrok-internal.h"
+}
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(DemoTest)
+
+// A packet is whole rows of 64 samples of every channel, the most that fit
+// in the packet size, and one row when the size is below a row.
+BOOST_AUTO_TEST_CASE(ThroughputPacketLen)
+{
+	const int channel_counts[] = {1, 2, 3, 5, 8, 16, 32};
+	const uint64_t sizes[] = {0, 1, 7, 8, 100, 1000, 4096, 65535, 1024 * 1024, 1024 * 1024 + 1};
+
+	BOOST_CHECK_EQUAL(demo_throughput_packet_len(16, 1024 * 1024), 65536);
+	BOOST_CHECK_EQUAL(demo_throughput_packet_len(3, 1000), 41 * 8);
+	BOOST_CHECK_EQUAL(demo_throughput_packet_len(32, 100), 8);
+
+	for (int n : channel_counts)
+	{
+		const uint64_t row = n * 8;
+
+		for (uint64_t size : sizes)
+		{
+			const uint64_t len = demo_throughput_packet_len(n, size);
+			const uint64_t total = len * n;
+
+			BOOST_CHECK_MESSAGE(len >= 8 && len % 8 == 0, "channels:" << n << ", size:" << size);
+			if (size >= row){
+				BOOST_CHECK_MESSAGE(total <= size && total + row > size,
+					"channels:" << n << ", size:" << size << ", packet:" << total);
+			}
+			else{
+				BOOST_CHECK_MESSAGE(total == row, "channels:" << n << ", size:" << size);
+			}
+		}
+	}
+}
+
+// The toggles of one channel in a packet of cross data.
+static uint64_t count_edges(const vector<uint64_t> &words, int chan_num, int ch, uint64_t bits)
+{
+	uint64_t edges = 0;
+	int last = words[ch] & 1;
+
+	for (uint64_t i = 1; i < bits; i++){
+		const int level = (words[(i / 64) * chan_num + ch] >> (i % 64)) & 1;
+		edges += (level != last);
+		last = level;
+	}
+	return edges;
+}
+
+// Each channel toggles at the edge density on average, at every sample for
+// a density of 1 and never for 0.
+BOOST_AUTO_TEST_CASE(ThroughputEdgeDensity)
+{
+	const int chan_num = 4;
+	const uint64_t packet_len = 64 * 1024;
+	const uint64_t bits = packet_len * 8;
+	const double densities[] = {0, 0.001, 0.01, 0.1, 0.5, 0.9, 1};
+	vector<uint64_t> words(chan_num * packet_len / 8 + 1);
+
+	for (double density : densities)
+	{
+		// The word past the packet stays as it is.
+		words.back() = 0x5a5a5a5a5a5a5a5aULL;
+		demo_throughput_data(words.data(), chan_num, packet_len, density);
+		BOOST_CHECK_EQUAL(words.back(), 0x5a5a5a5a5a5a5a5aULL);
+
+		uint64_t edges = 0;
+		for (int ch = 0; ch < chan_num; ch++)
+			edges += count_edges(words, chan_num, ch, bits);
+
+		const double expect = density * (bits - 1) * chan_num;
+
+		if (density == 0 || density == 1){
+			BOOST_CHECK_MESSAGE(edges == (uint64_t)expect, "density:" << density
+				<< ", edges:" << edges);
+		}
+		else{
+			// Well within the spread of a binomial count this large.
+			const double tolerance = (density < 0.01) ? 0.1 : 0.02;
+			BOOST_CHECK_MESSAGE(edges > expect * (1 - tolerance) && edges < expect * (1 + tolerance),
+				"density:" << density << ", edges:" << edges << ", expected:" << expect);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
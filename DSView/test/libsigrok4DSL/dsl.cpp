@@ -0,0 +1,490 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include <boost/test/unit_test.hpp>
+
+extern "C" {
+#include "../../../libsigrok4DSL/hardware/DSL/dsl.h"
+}
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(DslTest)
+
+// A ring of slots buffers, each one numbered in its first bytes.
+struct IngestFixture
+{
+	IngestFixture()
+	{
+		memset(&ing, 0, sizeof(ing));
+		g_mutex_init(&ing.consume);
+		ing.forward = collect;
+		ing.cb_data = this;
+	}
+
+	~IngestFixture()
+	{
+		dsl_ingest_free(&ing);
+		g_mutex_clear(&ing.consume);
+	}
+
+	bool init(gint slots)
+	{
+		return dsl_ingest_init(&ing, slots, sizeof(uint64_t)) == SR_OK;
+	}
+
+	// The forward callback, keeps the length and the number in the data.
+	static void collect(void *cb_data, uint8_t *buf, uint64_t length)
+	{
+		IngestFixture *self = (IngestFixture*)cb_data;
+		uint64_t seq = 0;
+		memcpy(&seq, buf, sizeof(seq));
+		self->lengths.push_back(length);
+		self->seqs.push_back(seq);
+	}
+
+	struct DSL_ingest ing;
+	vector<uint64_t> lengths;
+	vector<uint64_t> seqs;
+};
+
+BOOST_AUTO_TEST_CASE(IngestSlots)
+{
+	const size_t mb = 1024 * 1024;
+
+	// Twice the transfers in flight, MIN_INGEST_SLOTS at least.
+	BOOST_CHECK_EQUAL(dsl_ingest_slots(1, mb), MIN_INGEST_SLOTS);
+	BOOST_CHECK_EQUAL(dsl_ingest_slots(20, 256 * 1024), 40);
+	// Never more than MAX_INGEST_BYTES, and room for one buffer.
+	BOOST_CHECK_EQUAL(dsl_ingest_slots(64, mb), (gint)(MAX_INGEST_BYTES / mb));
+	BOOST_CHECK_EQUAL(dsl_ingest_slots(64, 4 * mb), (gint)(MAX_INGEST_BYTES / (4 * mb)));
+	BOOST_CHECK_EQUAL(dsl_ingest_slots(8, MAX_INGEST_BYTES), 2);
+}
+
+// The buffers come out in order, many times round the ring. Each put swaps
+// the filled buffer for a free one, nothing is copied.
+BOOST_FIXTURE_TEST_CASE(IngestRingWraps, IngestFixture)
+{
+	BOOST_REQUIRE(init(5));
+
+	vector<uint8_t*> mine;
+	for (int i = 0; i < 3; i++)
+		mine.push_back((uint8_t*)g_malloc0(sizeof(uint64_t)));
+
+	uint64_t put = 0;
+	uint64_t got = 0;
+
+	for (int round = 0; round < 20; round++)
+	{
+		// 1 to 3 buffers in the ring.
+		const int n = 1 + round % 3;
+		vector<uint8_t*> sent;
+
+		for (int i = 0; i < n; i++){
+			uint8_t *buf = mine[i];
+			memcpy(buf, &put, sizeof(put));
+			sent.push_back(buf);
+			BOOST_REQUIRE(dsl_ingest_put(&ing, &mine[i], 100 + put));
+			BOOST_CHECK(mine[i] != buf);
+			put++;
+		}
+
+		for (int i = 0; i < n; i++){
+			uint8_t *data = NULL;
+			uint64_t length = 0;
+			uint64_t seq = 0;
+
+			BOOST_REQUIRE(dsl_ingest_get(&ing, &data, &length));
+			memcpy(&seq, data, sizeof(seq));
+			BOOST_CHECK(data == sent[i]);
+			BOOST_CHECK_EQUAL(seq, got);
+			BOOST_CHECK_EQUAL(length, 100 + got);
+			dsl_ingest_release(&ing);
+			got++;
+		}
+
+		uint8_t *data = NULL;
+		uint64_t length = 0;
+		BOOST_CHECK(!dsl_ingest_get(&ing, &data, &length));
+	}
+
+	BOOST_CHECK_EQUAL(ing.high_water, 3);
+	BOOST_CHECK_EQUAL(ing.stalls, 0);
+
+	for (uint8_t *buf : mine)
+		g_free(buf);
+}
+
+// A full ring keeps the producer's buffer and counts the drop.
+BOOST_FIXTURE_TEST_CASE(IngestRingFull, IngestFixture)
+{
+	BOOST_REQUIRE(init(4));
+
+	uint8_t *buf = (uint8_t*)g_malloc0(sizeof(uint64_t));
+	uint8_t *data = NULL;
+	uint64_t length = 0;
+
+	// One slot always stays free.
+	for (uint64_t i = 0; i < 3; i++)
+		BOOST_REQUIRE(dsl_ingest_put(&ing, &buf, i));
+
+	uint8_t *const held = buf;
+	BOOST_CHECK(!dsl_ingest_put(&ing, &buf, 3));
+	BOOST_CHECK(!dsl_ingest_put(&ing, &buf, 4));
+	BOOST_CHECK(buf == held);
+	BOOST_CHECK_EQUAL(ing.stalls, 2);
+	BOOST_CHECK_EQUAL(ing.high_water, 3);
+
+	// The dropped buffers never show up.
+	BOOST_REQUIRE(dsl_ingest_get(&ing, &data, &length));
+	BOOST_CHECK_EQUAL(length, 0);
+	dsl_ingest_release(&ing);
+
+	BOOST_CHECK(dsl_ingest_put(&ing, &buf, 5));
+
+	for (uint64_t expect : {1, 2, 5}){
+		BOOST_REQUIRE(dsl_ingest_get(&ing, &data, &length));
+		BOOST_CHECK_EQUAL(length, expect);
+		dsl_ingest_release(&ing);
+	}
+	BOOST_CHECK(!dsl_ingest_get(&ing, &data, &length));
+
+	g_free(buf);
+}
+
+// A buffered capture on a full ring: the producer forwards what the ring
+// holds, then its own buffer, so nothing is lost and the order is kept.
+BOOST_FIXTURE_TEST_CASE(IngestRingFlush, IngestFixture)
+{
+	BOOST_REQUIRE(init(4));
+
+	uint8_t *buf = (uint8_t*)g_malloc0(sizeof(uint64_t));
+	uint64_t next = 1;
+
+	for (int round = 0; round < 3; round++){
+		for (;;){
+			memcpy(buf, &next, sizeof(next));
+			if (!dsl_ingest_put(&ing, &buf, next))
+				break;
+			next++;
+		}
+		dsl_ingest_flush(&ing, buf, next);
+		next++;
+
+		uint8_t *data = NULL;
+		uint64_t length = 0;
+		BOOST_CHECK(!dsl_ingest_get(&ing, &data, &length));
+	}
+
+	// One more through the consumer side.
+	memcpy(buf, &next, sizeof(next));
+	BOOST_REQUIRE(dsl_ingest_put(&ing, &buf, next));
+	BOOST_CHECK(dsl_ingest_forward(&ing));
+	BOOST_CHECK(!dsl_ingest_forward(&ing));
+
+	BOOST_REQUIRE_EQUAL(lengths.size(), next);
+	for (uint64_t i = 0; i < next; i++){
+		BOOST_CHECK_EQUAL(lengths[i], i + 1);
+		BOOST_CHECK_EQUAL(seqs[i], i + 1);
+	}
+	BOOST_CHECK_EQUAL(ing.stalls, 3);
+
+	g_free(buf);
+}
+
+// The same with the ingest thread forwarding at the same time: every
+// buffer arrives once and in order.
+BOOST_FIXTURE_TEST_CASE(IngestRingFlushThreads, IngestFixture)
+{
+	const uint64_t count = 100000;
+	BOOST_REQUIRE(init(8));
+
+	int done = 0;
+	thread consumer([&]{
+		for (;;){
+			if (dsl_ingest_forward(&ing))
+				continue;
+			// The last puts may land after the empty ring was seen.
+			if (g_atomic_int_get(&done) && !dsl_ingest_forward(&ing))
+				break;
+			this_thread::yield();
+		}
+	});
+
+	uint8_t *buf = (uint8_t*)g_malloc0(sizeof(uint64_t));
+	for (uint64_t i = 1; i <= count; i++){
+		memcpy(buf, &i, sizeof(i));
+		if (!dsl_ingest_put(&ing, &buf, i))
+			dsl_ingest_flush(&ing, buf, i);
+	}
+	g_atomic_int_set(&done, 1);
+	consumer.join();
+	g_free(buf);
+
+	bool ordered = true;
+	for (size_t i = 0; i < lengths.size(); i++)
+		ordered &= lengths[i] == i + 1 && seqs[i] == i + 1;
+
+	BOOST_CHECK(ordered);
+	BOOST_CHECK_EQUAL(lengths.size(), count);
+}
+
+// The USB thread and the ingest thread at full speed. The producer puts
+// each buffer again until there is room, so all of them arrive once and in
+// order, with the data they were put with. Each refused put is a stall.
+BOOST_FIXTURE_TEST_CASE(IngestRingThreads, IngestFixture)
+{
+	const uint64_t count = 200000;
+	BOOST_REQUIRE(init(8));
+
+	vector<uint64_t> received;
+	bool data_ok = true;
+
+	thread consumer([&]{
+		uint64_t last = 0;
+		do {
+			uint8_t *data = NULL;
+			uint64_t length = 0;
+			if (!dsl_ingest_get(&ing, &data, &length)){
+				this_thread::yield();
+				continue;
+			}
+
+			uint64_t seq = 0;
+			memcpy(&seq, data, sizeof(seq));
+			data_ok &= (seq == length);
+			received.push_back(length);
+			last = length;
+			dsl_ingest_release(&ing);
+		}
+		while (last != count);
+	});
+
+	uint8_t *buf = (uint8_t*)g_malloc0(sizeof(uint64_t));
+	uint64_t retries = 0;
+	for (uint64_t i = 1; i <= count; i++){
+		memcpy(buf, &i, sizeof(i));
+		while (!dsl_ingest_put(&ing, &buf, i)){
+			retries++;
+			this_thread::yield();
+		}
+	}
+	consumer.join();
+	g_free(buf);
+
+	bool ordered = true;
+	for (size_t i = 1; i < received.size(); i++)
+		ordered &= received[i - 1] < received[i];
+
+	BOOST_CHECK(data_ok);
+	BOOST_CHECK(ordered);
+	BOOST_CHECK_EQUAL(received.size(), count);
+	BOOST_CHECK_EQUAL((uint64_t)ing.stalls, retries);
+	BOOST_CHECK(ing.high_water <= 7);
+}
+
+// The capture's libusb event thread. A stop joins it within the handler
+// timeout, a start stops the previous thread, and stop is a no-op when no
+// thread runs.
+BOOST_AUTO_TEST_CASE(EventThreadStartStop)
+{
+	libusb_context *ctx = NULL;
+	BOOST_REQUIRE_EQUAL(libusb_init(&ctx), 0);
+
+	struct DSL_context *devc = (struct DSL_context*)g_malloc0(sizeof(struct DSL_context));
+	struct sr_dev_inst sdi;
+	memset(&sdi, 0, sizeof(sdi));
+	sdi.priv = devc;
+
+	dsl_stop_events(devc);
+	BOOST_CHECK(devc->event_thread == NULL);
+
+	for (int i = 0; i < 5; i++)
+	{
+		BOOST_REQUIRE_EQUAL(dsl_start_events(&sdi, ctx), SR_OK);
+		BOOST_CHECK(devc->event_thread != NULL);
+		BOOST_CHECK(devc->event_ctx == ctx);
+		BOOST_CHECK_EQUAL(devc->event_exit, 0);
+
+		// Started again, from a capture that did not stop its thread.
+		if (i % 2){
+			BOOST_REQUIRE_EQUAL(dsl_start_events(&sdi, ctx), SR_OK);
+			BOOST_CHECK(devc->event_thread != NULL);
+			BOOST_CHECK_EQUAL(devc->event_exit, 0);
+		}
+
+		this_thread::sleep_for(chrono::milliseconds(10 * i));
+
+		auto begin = chrono::steady_clock::now();
+		dsl_stop_events(devc);
+		chrono::duration<double> d = chrono::steady_clock::now() - begin;
+
+		BOOST_CHECK(devc->event_thread == NULL);
+		BOOST_CHECK_EQUAL(devc->event_exit, 1);
+		// The handler wakes every 50ms to check the exit flag.
+		BOOST_CHECK_LT(d.count(), 0.5);
+
+		dsl_stop_events(devc);
+		BOOST_CHECK(devc->event_thread == NULL);
+	}
+
+	g_free(devc);
+	libusb_exit(ctx);
+}
+
+// The transfer sizing of a stream with count transfers of size bytes, as
+// dsl_start_transfers() sets it up.
+static struct DSL_adapt adapt_setup(size_t size, unsigned int count)
+{
+	struct DSL_adapt ad;
+	memset(&ad, 0, sizeof(ad));
+	ad.active = TRUE;
+	ad.base_size = size;
+	ad.length = size;
+	ad.capacity = size * ADAPT_MAX_SCALE;
+	ad.base_count = count;
+	ad.max_count = 2 * count;
+	ad.count = count;
+	ad.window_headroom = 1.0;
+	return ad;
+}
+
+// One window with its lowest headroom, then a completion as
+// receive_transfer() handles it: a transfer is queued or retired.
+static void adapt_window(struct DSL_adapt &ad, double headroom, double load)
+{
+	ad.window_headroom = headroom;
+	if (dsl_adapt_window(&ad, load))
+		ad.count++;
+
+	if (ad.retire > 0){
+		ad.retire--;
+		ad.count--;
+	}
+}
+
+// A host that falls behind gets more transfers first, then longer ones,
+// never past max_count and the capacity of the buffers.
+BOOST_AUTO_TEST_CASE(AdaptGrowsToLimits)
+{
+	const size_t size = 64 * 1024;
+	struct DSL_adapt ad = adapt_setup(size, 8);
+
+	for (int i = 0; i < 8; i++){
+		adapt_window(ad, 0.1, 0);
+		BOOST_CHECK_EQUAL(ad.count, 9 + i);
+		BOOST_CHECK_EQUAL(ad.length, size);
+	}
+
+	for (int i = 0; i < 100; i++){
+		adapt_window(ad, 0.1, 0);
+		BOOST_CHECK_LE(ad.count, ad.max_count);
+		BOOST_CHECK_LE(ad.length, ad.capacity);
+	}
+
+	BOOST_CHECK_EQUAL(ad.count, 16);
+	BOOST_CHECK_EQUAL(ad.length, ad.capacity);
+	BOOST_CHECK_EQUAL(ad.grows, 9);
+	BOOST_CHECK_EQUAL(ad.shrinks, 0);
+}
+
+// A busy ingest thread gets longer transfers, not more of them.
+BOOST_AUTO_TEST_CASE(AdaptBusyIngest)
+{
+	const size_t size = 64 * 1024;
+	struct DSL_adapt ad = adapt_setup(size, 8);
+
+	for (int i = 0; i < 20; i++)
+		adapt_window(ad, 1.0, ADAPT_INGEST_LOAD + 0.1);
+
+	BOOST_CHECK_EQUAL(ad.count, 8);
+	BOOST_CHECK_EQUAL(ad.length, ad.capacity);
+	BOOST_CHECK_EQUAL(ad.calm_windows, 0);
+}
+
+// Calm windows give back the length, then the transfers, one step per
+// ADAPT_CALM_WINDOWS windows and never below the base values.
+BOOST_AUTO_TEST_CASE(AdaptShrinksToBase)
+{
+	const size_t size = 64 * 1024;
+	struct DSL_adapt ad = adapt_setup(size, 8);
+
+	for (int i = 0; i < 20; i++)
+		adapt_window(ad, 0.1, 0);
+	BOOST_REQUIRE_EQUAL(ad.count, 16);
+	BOOST_REQUIRE_EQUAL(ad.length, ad.capacity);
+
+	for (int i = 0; i < ADAPT_CALM_WINDOWS - 1; i++)
+		adapt_window(ad, 0.95, 0);
+	BOOST_CHECK_EQUAL(ad.shrinks, 0);
+
+	adapt_window(ad, 0.95, 0);
+	BOOST_CHECK_EQUAL(ad.shrinks, 1);
+	BOOST_CHECK_EQUAL(ad.length, size);
+	BOOST_CHECK_EQUAL(ad.count, 16);
+
+	for (int i = 0; i < 8 * ADAPT_CALM_WINDOWS; i++){
+		adapt_window(ad, 0.95, 0);
+		BOOST_CHECK_EQUAL(ad.shrinks, 1 + (i + 1) / ADAPT_CALM_WINDOWS);
+	}
+	BOOST_CHECK_EQUAL(ad.count, 8);
+
+	for (int i = 0; i < 10 * ADAPT_CALM_WINDOWS; i++)
+		adapt_window(ad, 0.95, 0);
+
+	BOOST_CHECK_EQUAL(ad.count, 8);
+	BOOST_CHECK_EQUAL(ad.length, size);
+	BOOST_CHECK_EQUAL(ad.shrinks, 9);
+}
+
+// A window between the two thresholds restarts the calm count, and a host
+// that falls behind again takes back a pending retire first.
+BOOST_AUTO_TEST_CASE(AdaptCalmReset)
+{
+	const size_t size = 64 * 1024;
+	struct DSL_adapt ad = adapt_setup(size, 8);
+	ad.count = 12;
+
+	for (int i = 0; i < ADAPT_CALM_WINDOWS - 1; i++)
+		adapt_window(ad, 0.95, 0);
+	adapt_window(ad, 0.7, 0);
+	for (int i = 0; i < ADAPT_CALM_WINDOWS - 1; i++)
+		adapt_window(ad, 0.95, 0);
+	BOOST_CHECK_EQUAL(ad.shrinks, 0);
+	BOOST_CHECK_EQUAL(ad.count, 12);
+
+	ad.window_headroom = 0.95;
+	BOOST_CHECK(!dsl_adapt_window(&ad, 0));
+	BOOST_CHECK_EQUAL(ad.retire, 1);
+
+	ad.window_headroom = 0.1;
+	BOOST_CHECK(!dsl_adapt_window(&ad, 0));
+	BOOST_CHECK_EQUAL(ad.retire, 0);
+	BOOST_CHECK_EQUAL(ad.grows, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
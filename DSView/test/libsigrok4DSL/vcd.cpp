@@ -0,0 +1,277 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <glib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+extern "C" {
+#include "../../../libsigrok4DSL/libsigrok-internal.h"
+}
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(VcdTest)
+
+// Per sample levels, bit p of a unit is the channel at position p.
+struct Levels
+{
+	int channels;
+	vector<uint16_t> units;
+};
+
+static Levels random_levels(int channels, uint64_t samples, uint32_t seed)
+{
+	mt19937 rng(seed);
+	Levels lv;
+	lv.channels = channels;
+	lv.units.resize(samples);
+
+	uint16_t unit = rng();
+	for (uint64_t i = 0; i < samples; i++){
+		// Channels toggle at different rates, some at the same sample.
+		for (int p = 0; p < channels; p++){
+			if (rng() % (4 << p) == 0)
+				unit ^= 1 << p;
+		}
+		lv.units[i] = unit & ((1 << channels) - 1);
+	}
+	return lv;
+}
+
+// The output module as StoreSession::export_exec() sets it up.
+class VcdOutput
+{
+public:
+	VcdOutput(int channels, uint64_t samplerate) :
+		_probes(channels), _names(channels)
+	{
+		memset(&_sdi, 0, sizeof(_sdi));
+		memset(&_output, 0, sizeof(_output));
+
+		for (int i = 0; i < channels; i++){
+			_names[i] = to_string(i);
+			memset(&_probes[i], 0, sizeof(sr_channel));
+			_probes[i].index = i;
+			_probes[i].type = SR_CHANNEL_LOGIC;
+			_probes[i].enabled = TRUE;
+			_probes[i].name = (char*)_names[i].c_str();
+			_sdi.channels = g_slist_append(_sdi.channels, &_probes[i]);
+		}
+
+		for (const struct sr_output_module **m = sr_output_list(); *m; m++){
+			if (!strcmp((*m)->id, "vcd"))
+				_output.module = *m;
+		}
+
+		_output.sdi = &_sdi;
+		_ok = _output.module && _output.module->init(&_output, NULL) == SR_OK;
+
+		struct sr_config src;
+		struct sr_datafeed_meta meta;
+		src.key = SR_CONF_SAMPLERATE;
+		src.data = g_variant_new_uint64(samplerate);
+		meta.config = g_slist_append(NULL, &src);
+		send(SR_DF_META, &meta);
+		g_slist_free(meta.config);
+		g_variant_unref(src.data);
+	}
+
+	~VcdOutput()
+	{
+		if (_ok)
+			_output.module->cleanup(&_output);
+		g_slist_free(_sdi.channels);
+	}
+
+	bool ok()
+	{
+		return _ok;
+	}
+
+	void send(int type, const void *payload)
+	{
+		struct sr_datafeed_packet p;
+		GString *out = NULL;
+
+		p.type = type;
+		p.status = SR_PKT_OK;
+		p.payload = payload;
+		p.bExportOriginalData = 0;
+
+		if (_ok && _output.module->receive(&_output, &p, &out) == SR_OK && out){
+			_text.append(out->str, out->len);
+			g_string_free(out, TRUE);
+		}
+	}
+
+	// The value changes, the header carries the date.
+	string body()
+	{
+		const string end_defs = "$enddefinitions $end\n";
+		const size_t pos = _text.find(end_defs);
+		return pos == string::npos ? string() : _text.substr(pos + end_defs.size());
+	}
+
+private:
+	vector<sr_channel> _probes;
+	vector<string> _names;
+	struct sr_dev_inst _sdi;
+	struct sr_output _output;
+	string _text;
+	bool _ok;
+};
+
+// The block path: cross units of unitsize bytes, packet_samples at a time.
+static string export_blocks(const Levels &lv, uint64_t samplerate, uint64_t packet_samples)
+{
+	VcdOutput vcd(lv.channels, samplerate);
+	const int unitsize = (lv.channels + 7) / 8;
+	const uint64_t samples = lv.units.size();
+
+	for (uint64_t i = 0; i < samples; i += packet_samples)
+	{
+		const uint64_t n = min(packet_samples, samples - i);
+		vector<uint8_t> data;
+		for (uint64_t k = i; k < i + n; k++){
+			for (int b = 0; b < unitsize; b++)
+				data.push_back(lv.units[k] >> (b * 8));
+		}
+
+		struct sr_datafeed_logic logic;
+		memset(&logic, 0, sizeof(logic));
+		logic.length = data.size();
+		logic.unitsize = unitsize;
+		logic.data = data.data();
+		vcd.send(SR_DF_LOGIC, &logic);
+	}
+
+	vcd.send(SR_DF_END, NULL);
+	BOOST_CHECK(vcd.ok());
+	return vcd.body();
+}
+
+// The edge path as StoreSession::export_logic_edges() sends it: the initial
+// levels at sample 0, then the changes in sample order. A packet is closed
+// once it holds batch changes, never between two changes of one sample.
+static string export_edges(const Levels &lv, uint64_t samplerate, uint64_t batch)
+{
+	VcdOutput vcd(lv.channels, samplerate);
+	vector<uint64_t> samples;
+	vector<uint16_t> channels;
+	vector<uint8_t> levels;
+
+	auto flush = [&](uint64_t length){
+		struct sr_datafeed_logic_edge ep;
+		ep.count = samples.size();
+		ep.samples = samples.data();
+		ep.channels = channels.data();
+		ep.levels = levels.data();
+		ep.length = length;
+		vcd.send(SR_DF_LOGIC_EDGE, &ep);
+		samples.clear();
+		channels.clear();
+		levels.clear();
+	};
+
+	for (int p = 0; p < lv.channels; p++){
+		samples.push_back(0);
+		channels.push_back(p);
+		levels.push_back((lv.units[0] >> p) & 1);
+	}
+
+	for (uint64_t i = 1; i < lv.units.size(); i++)
+	{
+		const uint16_t changed = lv.units[i] ^ lv.units[i - 1];
+		if (changed == 0)
+			continue;
+
+		if (samples.size() >= batch)
+			flush(i);
+
+		for (int p = 0; p < lv.channels; p++){
+			if ((changed >> p) & 1){
+				samples.push_back(i);
+				channels.push_back(p);
+				levels.push_back((lv.units[i] >> p) & 1);
+			}
+		}
+	}
+
+	flush(lv.units.size());
+	vcd.send(SR_DF_END, NULL);
+	BOOST_CHECK(vcd.ok());
+	return vcd.body();
+}
+
+BOOST_AUTO_TEST_CASE(EdgePacketsMatchBlocks)
+{
+	struct Case
+	{
+		int channels;
+		uint64_t samples;
+		uint64_t samplerate;
+	};
+
+	// One and two byte units, each VCD timescale.
+	const vector<Case> cases = {
+		{1, 5000, SR_KHZ(1)},
+		{5, 100000, SR_MHZ(1)},
+		{8, 100000, SR_MHZ(100)},
+		{12, 200000, SR_MHZ(400)},
+		{16, 50000, SR_GHZ(1)},
+	};
+
+	for (const Case &c : cases)
+	{
+		const Levels lv = random_levels(c.channels, c.samples, c.channels);
+		const string blocks = export_blocks(lv, c.samplerate, 4096);
+
+		BOOST_REQUIRE(!blocks.empty());
+		BOOST_CHECK(export_blocks(lv, c.samplerate, 1000) == blocks);
+
+		for (uint64_t batch : {1, 7, 8192}){
+			BOOST_CHECK_MESSAGE(export_edges(lv, c.samplerate, batch) == blocks,
+				c.channels << " channels, batch " << batch);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(EdgePacketsIdleCapture)
+{
+	Levels lv;
+	lv.channels = 3;
+	lv.units.assign(10000, 0x5);
+
+	const string blocks = export_blocks(lv, SR_MHZ(1), 4096);
+
+	// The initial levels and the end time, nothing in between.
+	BOOST_CHECK_EQUAL(blocks, "#0 1! 0\" 1#\n#10000\n");
+	BOOST_CHECK_EQUAL(export_edges(lv, SR_MHZ(1), 8192), blocks);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+#include "decoderun.h"
+
+using namespace std;
+using namespace decoderun;
+
+BOOST_AUTO_TEST_SUITE(DecoderTest)
+
+// One channel toggling after each gap, from a low level.
+static Capture gap_capture(const vector<uint64_t> &gaps, uint64_t samplerate)
+{
+	Capture cap;
+	uint64_t samples = 100;
+
+	for (uint64_t g : gaps)
+		samples += g;
+
+	cap.samplerate = samplerate;
+	cap.samples = samples;
+	cap.data.resize(1);
+	cap.data[0].assign((samples + 7) / 8, 0);
+	cap.levels.assign(1, 0);
+
+	bool level = false;
+	uint64_t s = 0;
+	for (uint64_t g : gaps){
+		for (uint64_t i = 0; i < g; i++, s++){
+			if (level)
+				cap.data[0][s / 8] |= 1 << (s % 8);
+		}
+		level = !level;
+	}
+	for (; s < samples; s++){
+		if (level)
+			cap.data[0][s / 8] |= 1 << (s % 8);
+	}
+	return cap;
+}
+
+static bool bit(const Capture &cap, int ch, uint64_t i)
+{
+	return (cap.data[ch][i / 8] >> (i % 8)) & 1;
+}
+
+// The annotations of guess_bitrate, from the edges sample by sample.
+static vector<Ann> ref_bitrates(const Capture &cap)
+{
+	vector<Ann> anns;
+	uint64_t last = 0;
+	uint64_t width = 0;
+	bool first = true;
+
+	for (uint64_t s = 1; s < cap.samples; s++)
+	{
+		if (bit(cap, 0, s) == bit(cap, 0, s - 1))
+			continue;
+
+		if (!first && (width == 0 || s - last < width)){
+			width = s - last;
+			const uint64_t rate = (uint64_t)((double)cap.samplerate / (double)width);
+			anns.push_back({last, s, 0, to_string(rate)});
+		}
+		first = false;
+		last = s;
+	}
+	return anns;
+}
+
+// The edges come from wait_bulk(), the shortest bit keeps shrinking past
+// the 4096 records of one call and across the chunks.
+BOOST_AUTO_TEST_CASE(GuessBitrateBulkEdges)
+{
+	BOOST_REQUIRE(load_decoder("guess_bitrate"));
+
+	const int edges = 10000;
+	mt19937 rng(7);
+	vector<uint64_t> gaps;
+	for (int i = 0; i < edges; i++)
+		gaps.push_back(10 + (edges - i) / 2 + rng() % 4);
+
+	const Capture cap = gap_capture(gaps, 10000000);
+	const vector<Ann> ref = ref_bitrates(cap);
+	uint64_t edge_4096 = 0;
+	for (int i = 0; i <= 4096; i++)
+		edge_4096 += gaps[i];
+	BOOST_REQUIRE(ref.size() > 1000);
+	BOOST_REQUIRE(ref.back().end > edge_4096);
+
+	for (uint64_t chunk : {cap.samples, (uint64_t)1000000, (uint64_t)64 * 7 + 3})
+	{
+		DecodeRun run("guess_bitrate", {{"data", 0}});
+		BOOST_REQUIRE(run.ok());
+		BOOST_REQUIRE(run.run(cap, chunk));
+		BOOST_CHECK_MESSAGE(run.annotations() == ref, "chunk " << chunk
+			<< ", got " << run.annotations().size() << ", expect " << ref.size());
+	}
+}
+
+// The pin tuples a decoder keeps from wait() must not change under it,
+// while the tuples it let go are used again.
+BOOST_AUTO_TEST_CASE(HeldPinTuples)
+{
+	BOOST_REQUIRE(load_decoder("test_pins"));
+
+	const uint64_t samples = 64 * 5000;
+	mt19937 rng(3);
+	Capture cap;
+	cap.samplerate = 1000000;
+	cap.samples = samples;
+	cap.data.resize(2);
+	cap.levels.assign(2, 0);
+
+	for (int ch = 0; ch < 2; ch++){
+		cap.data[ch].resize(samples / 8);
+		bool level = false;
+		for (uint64_t i = 0; i < samples; i++){
+			if (rng() % (5 + ch * 4) == 0)
+				level = !level;
+			if (level)
+				cap.data[ch][i / 8] |= 1 << (i % 8);
+		}
+	}
+
+	vector<Ann> ref;
+	for (uint64_t s = 1; s < samples; s++){
+		const bool a = bit(cap, 0, s);
+		const bool b = bit(cap, 1, s);
+		if (a != bit(cap, 0, s - 1) || b != bit(cap, 1, s - 1))
+			ref.push_back({s, s, 0, to_string(a) + to_string(b)});
+	}
+
+	for (uint64_t chunk : {samples, (uint64_t)1000})
+	{
+		DecodeRun run("test_pins", {{"a", 0}, {"b", 1}});
+		BOOST_REQUIRE(run.ok());
+		BOOST_REQUIRE(run.run(cap, chunk));
+		BOOST_CHECK_MESSAGE(run.annotations() == ref, "chunk " << chunk
+			<< ", got " << run.annotations().size() << ", expect " << ref.size());
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,60 @@
+##
+## This file is part of the DSView project.
+## DSView is based on PulseView.
+##
+## Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+##
+## This program is free software; you can redistribute it and/or modify
+## it under the terms of the GNU General Public License as published by
+## the Free Software Foundation; either version 2 of the License, or
+## (at your option) any later version.
+##
+## This program is distributed in the hope that it will be useful,
+## but WITHOUT ANY WARRANTY; without even the implied warranty of
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+## GNU General Public License for more details.
+##
+## You should have received a copy of the GNU General Public License
+## along with this program; if not, see <http://www.gnu.org/licenses/>.
+##
+
+import sigrokdecode as srd
+
+class Decoder(srd.Decoder):
+    api_version = 3
+    id = 'test_end'
+    name = 'Test end'
+    longname = 'Annotations from end()'
+    desc = 'Puts a summary of the edges when the input is over.'
+    license = 'gplv2+'
+    inputs = ['logic']
+    outputs = []
+    tags = ['Util']
+    channels = (
+        {'id': 'a', 'name': 'A', 'desc': 'Line'},
+    )
+    annotations = (
+        ('edge', 'Edge'),
+        ('summary', 'Summary'),
+    )
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.edges = 0
+
+    def start(self):
+        self.out_ann = self.register(srd.OUTPUT_ANN)
+
+    def end(self):
+        s = self.last_samplenum
+        self.put(s, s, self.out_ann, [1, ['%d edges' % self.edges]])
+        self.put(s, s, self.out_ann, [1, ['end']])
+
+    def decode(self):
+        while True:
+            self.wait({0: 'e'})
+            self.edges += 1
+            s = self.samplenum
+            self.put(s, s, self.out_ann, [0, ['edge']])
@@ -0,0 +1,66 @@
+##
+## This file is part of the DSView project.
+## DSView is based on PulseView.
+##
+## Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+##
+## This program is free software; you can redistribute it and/or modify
+## it under the terms of the GNU General Public License as published by
+## the Free Software Foundation; either version 2 of the License, or
+## (at your option) any later version.
+##
+## This program is distributed in the hope that it will be useful,
+## but WITHOUT ANY WARRANTY; without even the implied warranty of
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+## GNU General Public License for more details.
+##
+## You should have received a copy of the GNU General Public License
+## along with this program; if not, see <http://www.gnu.org/licenses/>.
+##
+
+import sigrokdecode as srd
+
+class Decoder(srd.Decoder):
+    api_version = 3
+    id = 'test_pins'
+    name = 'Test pins'
+    longname = 'Held pin tuples'
+    desc = 'Checks that the pin tuples kept by a decoder do not change.'
+    license = 'gplv2+'
+    inputs = ['logic']
+    outputs = []
+    tags = ['Util']
+    channels = (
+        {'id': 'a', 'name': 'A', 'desc': 'First line'},
+        {'id': 'b', 'name': 'B', 'desc': 'Second line'},
+    )
+    annotations = (
+        ('pins', 'Pin values'),
+        ('changed', 'Held tuple changed'),
+    )
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        pass
+
+    def start(self):
+        self.out_ann = self.register(srd.OUTPUT_ANN)
+
+    def decode(self):
+        held = []
+        while True:
+            # pins is still held when wait() is called again.
+            pins = self.wait([{0: 'e'}, {1: 'e'}])
+            s = self.samplenum
+            self.put(s, s, self.out_ann, [0, ['%d%d' % pins]])
+
+            # Keep every third tuple for two more of them.
+            if s % 3 == 0:
+                held.append((s, pins, tuple(list(pins))))
+                del held[:-2]
+
+            for (ss, p, copy) in held:
+                if p != copy:
+                    self.put(ss, s, self.out_ann, [1, ['%d%d' % p]])
@@ -0,0 +1,256 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_TEST_DECODERUN_H
+#define DSVIEW_TEST_DECODERUN_H
+
+#include <Python.h>
+#include <glib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+
+extern "C" {
+#include "../../../libsigrokdecode4DSL/libsigrokdecode-internal.h"
+}
+
+// Runs one of the bundled protocol decoders over a capture the way
+// DecoderStack::execute_decode_stack() does, and keeps its annotations.
+namespace decoderun
+{
+
+struct Ann
+{
+	uint64_t start;
+	uint64_t end;
+	int cls;
+	std::string text;
+
+	bool operator==(const Ann &a) const
+	{
+		return start == a.start && end == a.end && cls == a.cls && text == a.text;
+	}
+};
+
+// One byte buffer per decoder channel, LSB first. An empty buffer is a
+// constant channel at its level.
+struct Capture
+{
+	uint64_t samples;
+	uint64_t samplerate;
+	std::vector<std::vector<uint8_t>> data;
+	std::vector<uint8_t> levels;
+};
+
+// Loads the decoders once per process, the interpreter is never shut down.
+// The test decoders are found next to the bundled ones.
+inline bool load_decoder(const char *module)
+{
+	static std::mutex lock;
+	static bool init_ok = false;
+	static bool init_done = false;
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (!init_done){
+		init_done = true;
+		init_ok = (srd_init(DSVIEW_TEST_DECODERS_DIR) == SRD_OK)
+			&& (srd_decoder_searchpath_add(DSVIEW_TEST_PD_DIR) == SRD_OK);
+	}
+
+	return init_ok && srd_decoder_load(module) == SRD_OK;
+}
+
+// A UART line at the decoder's default settings: 8N1, LSB first, idle high.
+inline Capture uart_capture(const std::vector<uint8_t> &bytes, uint64_t samples_per_bit)
+{
+	Capture cap;
+	std::vector<bool> line;
+
+	for (int i = 0; i < 20; i++)
+		line.push_back(true);
+
+	for (uint8_t b : bytes){
+		line.push_back(false);
+		for (int i = 0; i < 8; i++)
+			line.push_back((b >> i) & 1);
+		line.push_back(true);
+		line.push_back(true);
+	}
+
+	cap.samplerate = 115200 * samples_per_bit;
+	cap.samples = line.size() * samples_per_bit;
+	cap.data.resize(1);
+	cap.data[0].assign((cap.samples + 7) / 8, 0);
+	cap.levels.assign(1, 1);
+
+	for (uint64_t i = 0; i < cap.samples; i++){
+		if (line[i / samples_per_bit])
+			cap.data[0][i / 8] |= 1 << (i % 8);
+	}
+
+	return cap;
+}
+
+class DecodeRun
+{
+public:
+	// channels maps the decoder channel ids to the capture channels.
+	DecodeRun(const char *decoder_id, const std::map<std::string, int> &channels) :
+		_session(NULL), _di(NULL), _calls(0)
+	{
+		srd_session_new(&_session);
+
+		if (_session){
+			// The decoder fills in the defaults of the options left out.
+			GHashTable *const opt_hash = g_hash_table_new_full(g_str_hash,
+				g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+			_di = srd_inst_new(_session, decoder_id, opt_hash);
+			g_hash_table_destroy(opt_hash);
+		}
+
+		if (_di){
+			GHashTable *const probes = g_hash_table_new_full(g_str_hash,
+				g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+
+			for (auto &c : channels){
+				GVariant *const gvar = g_variant_new_int32(c.second);
+				g_variant_ref_sink(gvar);
+				g_hash_table_insert(probes, g_strdup(c.first.c_str()), gvar);
+			}
+
+			srd_inst_channel_set_all(_di, probes);
+			g_hash_table_destroy(probes);
+		}
+	}
+
+	~DecodeRun()
+	{
+		if (_session)
+			srd_session_destroy(_session);
+	}
+
+	bool ok()
+	{
+		return _di != NULL;
+	}
+
+	// Feeds the capture in chunks of at most chunk samples.
+	bool run(const Capture &cap, uint64_t chunk, bool batch = false)
+	{
+		char *error = NULL;
+
+		srd_session_metadata_set(_session, SRD_CONF_SAMPLERATE,
+			g_variant_new_uint64(cap.samplerate));
+
+		if (batch)
+			srd_pd_output_batch_callback_add(_session, SRD_OUTPUT_ANN, batch_callback, this);
+		else
+			srd_pd_output_callback_add(_session, SRD_OUTPUT_ANN, callback, this);
+
+		if (srd_session_start(_session, &error) != SRD_OK){
+			g_free(error);
+			return false;
+		}
+
+		std::vector<const uint8_t*> inbuf(_di->dec_num_channels);
+		std::vector<uint8_t> inbuf_const(_di->dec_num_channels);
+		bool ret = true;
+
+		for (uint64_t i = 0; i < cap.samples && ret;)
+		{
+			const uint64_t end = std::min(i + chunk, cap.samples);
+
+			for (int j = 0; j < _di->dec_num_channels; j++){
+				const int ch = _di->dec_channelmap[j];
+				const bool has_data = ch >= 0 && !cap.data[ch].empty();
+				inbuf[j] = has_data ? cap.data[ch].data() + i / 8 : NULL;
+				inbuf_const[j] = ch >= 0 ? cap.levels[ch] : 0;
+			}
+
+			ret = srd_session_send(_session, i, end, inbuf.data(), inbuf_const.data(),
+								   end - i, &error) == SRD_OK;
+			i = end;
+		}
+
+		if (ret)
+			ret = srd_session_end(_session, &error) == SRD_OK;
+
+		g_free(error);
+		return ret;
+	}
+
+	const std::vector<Ann>& annotations()
+	{
+		return _anns;
+	}
+
+	// How many times the decoder called back.
+	uint64_t calls()
+	{
+		return _calls;
+	}
+
+private:
+	void push(const struct srd_proto_data *pdata)
+	{
+		const struct srd_proto_data_annotation *pda =
+			(const struct srd_proto_data_annotation*)pdata->data;
+
+		Ann a;
+		a.start = pdata->start_sample;
+		a.end = pdata->end_sample;
+		a.cls = pda->ann_class;
+		if (pda->ann_text && pda->ann_text[0])
+			a.text = pda->ann_text[0];
+		_anns.push_back(a);
+	}
+
+	// Each call takes the lock once, as DecoderStack locks a row per call.
+	static void callback(struct srd_proto_data *pdata, void *cb_data)
+	{
+		DecodeRun *const run = (DecodeRun*)cb_data;
+		std::lock_guard<std::mutex> lock(run->_lock);
+		run->_calls++;
+		run->push(pdata);
+	}
+
+	static void batch_callback(struct srd_proto_data *pdata_list, int count, void *cb_data)
+	{
+		DecodeRun *const run = (DecodeRun*)cb_data;
+		std::lock_guard<std::mutex> lock(run->_lock);
+		run->_calls++;
+		for (int i = 0; i < count; i++)
+			run->push(&pdata_list[i]);
+	}
+
+	struct srd_session *_session;
+	struct srd_decoder_inst *_di;
+	std::vector<Ann> _anns;
+	std::mutex _lock;
+	uint64_t _calls;
+};
+
+} // namespace decoderun
+
+#endif
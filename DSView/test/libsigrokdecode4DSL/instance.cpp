@@ -0,0 +1,348 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <Python.h>
+#include <structmember.h>
+#include <glib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+extern "C" {
+#include "../../../libsigrokdecode4DSL/libsigrokdecode-internal.h"
+}
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(InstanceTest)
+
+struct TermSpec
+{
+	int type;
+	int channel;
+	uint64_t skip;
+};
+
+typedef vector<TermSpec> CondSpec;
+
+// The sample buffers of a capture, a channel without samples is constant.
+struct Capture
+{
+	uint64_t samples;
+	vector<vector<uint8_t>> data;
+	vector<uint8_t> levels;
+
+	bool bit(int ch, uint64_t i) const
+	{
+		if (data[ch].empty())
+			return levels[ch] != 0;
+		return (data[ch][i / 8] >> (i % 8)) & 1;
+	}
+};
+
+// Drives find_match() chunk by chunk the way Decoder_wait() and
+// srd_inst_decode() do, without the Python side.
+class Waiter
+{
+public:
+	Waiter(const Capture &cap, uint64_t chunk) :
+		_cap(cap), _chunk(chunk), _next(0), _end(0)
+	{
+		const int n = cap.data.size();
+
+		memset(&_di, 0, sizeof(_di));
+		_di.inst_id = (char*)"test";
+		_di.dec_num_channels = n;
+		_di.first_pos = TRUE;
+
+		for (int i = 0; i < n; i++)
+			_map.push_back(i);
+		_di.dec_channelmap = _map.data();
+
+		_inbuf.resize(n);
+		_di.inbuf_const = _cap.levels.data();
+	}
+
+	~Waiter()
+	{
+		condition_list_free(&_di);
+		if (_di.old_pins_array)
+			g_array_free(_di.old_pins_array, TRUE);
+	}
+
+	bool wait(const vector<CondSpec> &conds, uint64_t &samplenum, uint64_t &matches)
+	{
+		set_conditions(conds);
+
+		while (true)
+		{
+			if (_di.abs_end_samplenum == 0)
+			{
+				if (_next >= _cap.samples)
+					return false;
+				feed_chunk();
+			}
+
+			gboolean found = FALSE;
+			process_samples_until_condition_match(&_di, &found);
+
+			if (found){
+				samplenum = _di.abs_cur_samplenum;
+				matches = _di.match_array;
+				return true;
+			}
+
+			_di.abs_start_samplenum = 0;
+			_di.abs_end_samplenum = 0;
+			_next = _end;
+		}
+	}
+
+private:
+	void set_conditions(const vector<CondSpec> &conds)
+	{
+		condition_list_free(&_di);
+
+		for (const CondSpec &c : conds)
+		{
+			GSList *terms = NULL;
+
+			for (const TermSpec &t : c)
+			{
+				struct srd_term *term = (struct srd_term*)g_malloc0(sizeof(struct srd_term));
+				term->type = t.type;
+				term->channel = t.channel;
+				term->num_samples_to_skip = t.skip;
+				// As create_term_list() counts the sample of the last match.
+				if (t.type == SRD_TERM_SKIP)
+					term->num_samples_already_skipped = _di.abs_cur_matched ? (t.skip != 0) : 0;
+				terms = g_slist_append(terms, term);
+			}
+			_di.condition_list = g_slist_append(_di.condition_list, terms);
+		}
+	}
+
+	void feed_chunk()
+	{
+		const uint64_t start = _next;
+		_end = min(start + _chunk, _cap.samples);
+
+		for (unsigned int ch = 0; ch < _inbuf.size(); ch++){
+			_inbuf[ch] = _cap.data[ch].empty() ? NULL : _cap.data[ch].data() + start / 8;
+		}
+
+		if (_di.first_pos)
+			_di.abs_cur_samplenum = start;
+		_di.abs_start_samplenum = start & ~7ULL;
+		_di.abs_end_samplenum = _end;
+		_di.inbuf = _inbuf.data();
+	}
+
+	const Capture &_cap;
+	uint64_t _chunk;
+	uint64_t _next;
+	uint64_t _end;
+	struct srd_decoder_inst _di;
+	vector<int> _map;
+	vector<const uint8_t*> _inbuf;
+};
+
+static bool term_ok(const Capture &cap, const TermSpec &t, uint64_t s, uint64_t ref)
+{
+	const bool cur = (t.type == SRD_TERM_SKIP) ? false : cap.bit(t.channel, s);
+	const bool old = (t.type == SRD_TERM_SKIP) ? false : cap.bit(t.channel, s > 0 ? s - 1 : 0);
+
+	switch (t.type)
+	{
+	case SRD_TERM_HIGH:
+		return cur;
+	case SRD_TERM_LOW:
+		return !cur;
+	case SRD_TERM_RISING_EDGE:
+		return !old && cur;
+	case SRD_TERM_FALLING_EDGE:
+		return old && !cur;
+	case SRD_TERM_EITHER_EDGE:
+		return old != cur;
+	case SRD_TERM_NO_EDGE:
+		return old == cur;
+	default:
+		return s == ref + t.skip;
+	}
+}
+
+// The sample by sample definition of wait(), ref is the sample of the
+// last match or the first sample.
+static bool ref_wait(const Capture &cap, const vector<CondSpec> &conds,
+					 uint64_t from, uint64_t ref, uint64_t &samplenum, uint64_t &matches)
+{
+	for (uint64_t s = from; s < cap.samples; s++)
+	{
+		matches = 0;
+
+		for (unsigned int j = 0; j < conds.size(); j++)
+		{
+			bool ok = true;
+			for (const TermSpec &t : conds[j])
+				ok = ok && term_ok(cap, t, s, ref);
+			if (ok)
+				matches |= 1ULL << j;
+		}
+
+		if (matches){
+			samplenum = s;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void check_waits(const Capture &cap, const vector<CondSpec> &conds, uint64_t chunk,
+						const char *name)
+{
+	Waiter w(cap, chunk);
+	uint64_t from = 0;
+	uint64_t ref = 0;
+	int count = 0;
+	bool ok = true;
+
+	while (ok)
+	{
+		uint64_t s = 0, m = 0, rs = 0, rm = 0;
+		const bool found = w.wait(conds, s, m);
+		const bool rfound = ref_wait(cap, conds, from, ref, rs, rm);
+
+		ok = (found == rfound) && (!found || (s == rs && m == rm));
+		BOOST_CHECK_MESSAGE(ok, name << ", chunk:" << chunk << ", wait:" << count
+			<< ", got " << found << "@" << s << "/" << m
+			<< ", expect " << rfound << "@" << rs << "/" << rm);
+
+		if (!found)
+			break;
+
+		from = s + 1;
+		ref = s;
+		count++;
+	}
+}
+
+static void set_edges(vector<uint8_t> &data, const vector<uint64_t> &edges, uint64_t samples)
+{
+	bool level = false;
+	uint64_t e = 0;
+
+	data.assign((samples + 7) / 8, 0);
+	for (uint64_t i = 0; i < samples; i++)
+	{
+		while (e < edges.size() && edges[e] == i){
+			level = !level;
+			e++;
+		}
+		if (level)
+			data[i / 8] |= 1 << (i % 8);
+	}
+}
+
+static Capture make_capture()
+{
+	const uint64_t samples = 64 * 300 + 37;
+	mt19937_64 rng(5);
+	Capture cap;
+
+	cap.samples = samples;
+	cap.data.resize(4);
+	cap.levels.assign(4, 0);
+
+	// Edges around the word boundaries, the first and the last sample.
+	set_edges(cap.data[0], {1, 63, 64, 65, 127, 128, 191, 1000, 1001, 4096,
+		64 * 200 - 1, 64 * 200, samples - 1}, samples);
+
+	// Long idle runs between short bursts.
+	vector<uint64_t> edges;
+	for (uint64_t i = 0; i < samples; i += 1500 + rng() % 700)
+	{
+		for (int k = 0; k < 6 && i + k * 3 < samples; k++)
+			edges.push_back(i + k * 3);
+	}
+	set_edges(cap.data[1], edges, samples);
+
+	// Dense random data.
+	cap.data[2].resize((samples + 7) / 8);
+	for (uint8_t &b : cap.data[2])
+		b = (uint8_t)rng();
+
+	// Constant high, no buffer.
+	cap.data[3].clear();
+	cap.levels[3] = 1;
+
+	return cap;
+}
+
+BOOST_AUTO_TEST_CASE(WaitMatchesPerSample)
+{
+	const Capture cap = make_capture();
+
+	const vector<CondSpec> cond_sets[] = {
+		{{{SRD_TERM_FALLING_EDGE, 0, 0}}},
+		{{{SRD_TERM_RISING_EDGE, 0, 0}}},
+		{{{SRD_TERM_EITHER_EDGE, 1, 0}}},
+		{{{SRD_TERM_RISING_EDGE, 1, 0}, {SRD_TERM_HIGH, 0, 0}}, {{SRD_TERM_FALLING_EDGE, 0, 0}}},
+		{{{SRD_TERM_EITHER_EDGE, 2, 0}, {SRD_TERM_LOW, 1, 0}, {SRD_TERM_NO_EDGE, 0, 0}}},
+		{{{SRD_TERM_HIGH, 3, 0}, {SRD_TERM_EITHER_EDGE, 0, 0}}},
+		{{{SRD_TERM_LOW, 3, 0}}, {{SRD_TERM_RISING_EDGE, 1, 0}}},
+		{{{SRD_TERM_LOW, 3, 0}}},
+		{{{SRD_TERM_SKIP, 0, 700}}, {{SRD_TERM_EITHER_EDGE, 1, 0}}},
+		{{{SRD_TERM_SKIP, 0, 65}}, {{SRD_TERM_EITHER_EDGE, 0, 0}}},
+	};
+	// A chunk starts in the middle of a byte and of a word.
+	const uint64_t chunks[] = {cap.samples, 1000, 64 * 7 + 3, 8 * 9};
+
+	for (unsigned int i = 0; i < sizeof(cond_sets) / sizeof(cond_sets[0]); i++)
+	{
+		for (uint64_t chunk : chunks)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "conditions %u", i);
+			check_waits(cap, cond_sets[i], chunk, name);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(IdleCaptureHasNoMatch)
+{
+	Capture cap;
+	cap.samples = 1 << 20;
+	cap.data.resize(2);
+	cap.data[0].assign(cap.samples / 8, 0xff);
+	cap.levels.assign(2, 0);
+
+	const vector<CondSpec> conds = {
+		{{SRD_TERM_FALLING_EDGE, 0, 0}},
+		{{SRD_TERM_HIGH, 1, 0}},
+	};
+
+	check_waits(cap, conds, 1 << 16, "idle");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
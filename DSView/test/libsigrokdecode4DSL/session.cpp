@@ -0,0 +1,184 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <random>
+#include <chrono>
+
+#include <boost/test/unit_test.hpp>
+
+#include "decoderun.h"
+
+using namespace std;
+using namespace decoderun;
+
+BOOST_AUTO_TEST_SUITE(SessionTest)
+
+// Runs on the worker threads too, so it reports instead of checking.
+static bool decode_uart(const Capture &cap, uint64_t chunk, vector<Ann> &anns)
+{
+	DecodeRun run("0:uart", {{"rxtx", 0}});
+
+	if (!run.ok() || !run.run(cap, chunk))
+		return false;
+	anns = run.annotations();
+	return true;
+}
+
+static size_t count_class(const vector<Ann> &anns, int cls)
+{
+	return count_if(anns.begin(), anns.end(), [cls](const Ann &a){ return a.cls == cls; });
+}
+
+// Decoder stacks run at the same time on the decode worker pool. Each one
+// must get exactly the annotations, in the same order, as when run alone.
+BOOST_AUTO_TEST_CASE(ParallelStacksMatchSerial)
+{
+	BOOST_REQUIRE(load_decoder("0-uart"));
+
+	const int stacks = 6;
+	mt19937 rng(11);
+	vector<Capture> caps;
+	vector<vector<uint8_t>> bytes(stacks);
+
+	for (int i = 0; i < stacks; i++){
+		for (int j = 0; j < 1500; j++)
+			bytes[i].push_back((uint8_t)rng());
+		caps.push_back(uart_capture(bytes[i], 8 + i * 3));
+	}
+
+	vector<vector<Ann>> serial(stacks);
+	for (int i = 0; i < stacks; i++){
+		BOOST_REQUIRE(decode_uart(caps[i], 1 << 16, serial[i]));
+		BOOST_CHECK_EQUAL(count_class(serial[i], 0), bytes[i].size());
+	}
+
+	for (int round = 0; round < 3; round++)
+	{
+		vector<vector<Ann>> parallel(stacks);
+		vector<char> ok(stacks, 0);
+		vector<thread> workers;
+
+		for (int i = 0; i < stacks; i++){
+			// Different chunk sizes keep the stacks out of step.
+			const uint64_t chunk = 4096 + i * 1000 + round * 77;
+			workers.push_back(thread([&, i, chunk]{ ok[i] = decode_uart(caps[i], chunk, parallel[i]); }));
+		}
+
+		for (auto &t : workers)
+			t.join();
+
+		for (int i = 0; i < stacks; i++){
+			BOOST_CHECK(ok[i]);
+			BOOST_CHECK_EQUAL(parallel[i].size(), serial[i].size());
+			BOOST_CHECK_MESSAGE(parallel[i] == serial[i], "stack " << i << ", round " << round);
+		}
+	}
+}
+
+// The best of the runs is reported.
+static const int BenchRuns = 3;
+
+// Decoder_put() hands each annotation to srd_pd_output_callback_add()'s
+// callback, or queues it for srd_pd_output_batch_callback_add()'s, the one
+// DecoderStack::annotation_callback() is. Both must deliver the same output.
+BOOST_AUTO_TEST_CASE(AnnotationBatches)
+{
+	BOOST_REQUIRE(load_decoder("0-uart"));
+
+	mt19937 rng(23);
+	vector<uint8_t> bytes(20000);
+	for (uint8_t &b : bytes)
+		b = (uint8_t)rng();
+	const Capture cap = uart_capture(bytes, 8);
+
+	vector<Ann> anns[2];
+	uint64_t calls[2] = {0, 0};
+
+	for (int batch = 0; batch < 2; batch++)
+	{
+		double sec = 0;
+
+		for (int run = 0; run < BenchRuns; run++)
+		{
+			DecodeRun dr("0:uart", {{"rxtx", 0}});
+			BOOST_REQUIRE(dr.ok());
+
+			auto begin = chrono::steady_clock::now();
+			BOOST_REQUIRE(dr.run(cap, 1 << 20, batch));
+			chrono::duration<double> t = chrono::steady_clock::now() - begin;
+			sec = (run == 0) ? t.count() : min(sec, t.count());
+
+			anns[batch] = dr.annotations();
+			calls[batch] = dr.calls();
+		}
+
+		BOOST_TEST_MESSAGE("uart annotations " << (batch ? "in batches" : "one by one")
+			<< ", " << anns[batch].size() << " in " << calls[batch] << " calls, "
+			<< anns[batch].size() / sec << " annotations/s");
+	}
+
+	BOOST_CHECK_EQUAL(count_class(anns[0], 0), bytes.size());
+	BOOST_CHECK_EQUAL(anns[1].size(), anns[0].size());
+	BOOST_CHECK(anns[1] == anns[0]);
+	BOOST_CHECK_EQUAL(calls[0], anns[0].size());
+	BOOST_CHECK(calls[1] < calls[0] / 10);
+}
+
+// What end() puts is handed over before srd_session_end() returns, which is
+// when DecoderStack reports the decode done, not when the session goes.
+BOOST_AUTO_TEST_CASE(EndAnnotations)
+{
+	BOOST_REQUIRE(load_decoder("test_end"));
+
+	const uint64_t samples = 8 * 4000;
+	Capture cap;
+	cap.samplerate = 1000000;
+	cap.samples = samples;
+	cap.data.resize(1);
+	cap.data[0].assign(samples / 8, 0);
+	cap.levels.assign(1, 0);
+
+	// A toggle every 10 samples.
+	vector<Ann> ref;
+	for (uint64_t i = 0; i < samples; i++){
+		if ((i / 10) % 2)
+			cap.data[0][i / 8] |= 1 << (i % 8);
+		if (i > 0 && i % 10 == 0)
+			ref.push_back({i, i, 0, "edge"});
+	}
+	const uint64_t edges = ref.size();
+	ref.push_back({samples, samples, 1, to_string(edges) + " edges"});
+	ref.push_back({samples, samples, 1, "end"});
+
+	for (int batch = 0; batch < 2; batch++)
+	{
+		DecodeRun run("test_end", {{"a", 0}});
+		BOOST_REQUIRE(run.ok());
+		BOOST_REQUIRE(run.run(cap, 3000, batch));
+		BOOST_CHECK_MESSAGE(run.annotations() == ref, "batch " << batch
+			<< ", got " << run.annotations().size() << ", expect " << ref.size());
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,4 +20,9 @@
  */
 
 #define BOOST_TEST_MAIN
-#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#include <log/xlog.h>
+
+// The application creates the writer in dsv_log_init(), the tests log nowhere.
+xlog_writer *dsv_log = NULL;
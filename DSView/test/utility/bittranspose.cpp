@@ -0,0 +1,247 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <string.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../../pv/utility/bittranspose.h"
+
+using namespace std;
+
+namespace bits = pv::bits;
+
+BOOST_AUTO_TEST_SUITE(BitTransposeTest)
+
+// The input of every timed run, larger than the caches.
+static const uint64_t BenchBytes = 64 * 1024 * 1024;
+// The best of the runs is reported.
+static const int BenchRuns = 3;
+
+static double elapsed_seconds(const chrono::steady_clock::time_point &begin)
+{
+	chrono::duration<double> d = chrono::steady_clock::now() - begin;
+	return d.count();
+}
+
+static const char* path_name(bits::SimdPath path)
+{
+	switch (path)
+	{
+	case bits::SIMD_AVX2:
+		return "AVX2";
+	case bits::SIMD_SSE2:
+		return "SSE2";
+	default:
+		return "scalar";
+	}
+}
+
+BOOST_AUTO_TEST_CASE(SplitWords)
+{
+	// The leaf blocks take the channels at the same 32 byte alignment.
+	const int channel_counts[] = {8, 16, 32, 5};
+	mt19937_64 rng(1);
+
+	for (int n : channel_counts)
+	{
+		const uint64_t rows = BenchBytes / 8 / n;
+		// Not a power of two apart, like separate leaf blocks.
+		const uint64_t stride = ((rows + 3) & ~3ULL) + 36;
+		vector<uint64_t> src(rows * n);
+		vector<uint64_t> buf(stride * n + 4);
+		uint64_t *dest[32];
+
+		for (uint64_t &w : src){
+			w = rng();
+		}
+
+		uint64_t *base = buf.data();
+		while (((uintptr_t)base & 31) != 0){
+			base++;
+		}
+		for (int c = 0; c < n; c++){
+			dest[c] = base + c * stride;
+		}
+
+		for (int p = bits::simd_path(); p >= bits::SIMD_SCALAR; p--)
+		{
+			const bits::SimdPath path = (bits::SimdPath)p;
+			double sec = 0;
+
+			for (int run = 0; run < BenchRuns; run++)
+			{
+				fill(buf.begin(), buf.end(), 0);
+
+				auto begin = chrono::steady_clock::now();
+				bits::split_words(src.data(), rows, n, dest, path);
+				const double t = elapsed_seconds(begin);
+				sec = (run == 0) ? t : min(sec, t);
+			}
+
+			bool same = true;
+			for (uint64_t r = 0; r < rows; r++){
+				for (int c = 0; c < n; c++){
+					same &= (dest[c][r] == src[r * n + c]);
+				}
+			}
+			BOOST_CHECK_MESSAGE(same, "split_words " << path_name(path)
+				<< ", channels:" << n);
+
+			BOOST_TEST_MESSAGE("split_words " << path_name(path) << ", channels:" << n
+				<< ", " << rows * n * 8 / sec / 1e9 << " GB/s");
+		}
+	}
+}
+
+// Short runs at every start alignment, each path against the scalar one.
+// The words around the channels must stay as they are.
+BOOST_AUTO_TEST_CASE(SplitWordsSmall)
+{
+	const int channel_counts[] = {1, 2, 3, 4, 5, 8, 12, 16, 20, 32};
+	const uint64_t guard = 0x5a5a5a5a5a5a5a5aULL;
+	mt19937_64 rng(3);
+
+	for (int n : channel_counts)
+	{
+		for (uint64_t rows = 1; rows <= 19; rows++)
+		{
+			// The first word of the channels from 0 to 3 words past a 32 byte line.
+			for (int shift = 0; shift < 4; shift++)
+			{
+				const uint64_t stride = 32 + 4;
+				vector<uint64_t> src(rows * n);
+				vector<uint64_t> expect(stride * n + 4, guard);
+				uint64_t *dest[32];
+
+				for (uint64_t &w : src){
+					w = rng();
+				}
+
+				uint64_t *base = expect.data();
+				while (((uintptr_t)base & 31) != 0){
+					base++;
+				}
+				for (int c = 0; c < n; c++){
+					dest[c] = base + c * stride + shift;
+				}
+				bits::split_words(src.data(), rows, n, dest, bits::SIMD_SCALAR);
+
+				bool scalar_same = true;
+				for (uint64_t r = 0; r < rows; r++){
+					for (int c = 0; c < n; c++){
+						scalar_same &= (dest[c][r] == src[r * n + c]);
+					}
+				}
+				BOOST_CHECK_MESSAGE(scalar_same, "split_words scalar, channels:" << n
+					<< ", rows:" << rows << ", shift:" << shift);
+
+				for (int p = bits::simd_path(); p > bits::SIMD_SCALAR; p--)
+				{
+					const bits::SimdPath path = (bits::SimdPath)p;
+					vector<uint64_t> buf(expect.size(), guard);
+
+					for (int c = 0; c < n; c++){
+						dest[c] = buf.data() + (base - expect.data()) + c * stride + shift;
+					}
+					bits::split_words(src.data(), rows, n, dest, path);
+
+					BOOST_CHECK_MESSAGE(buf == expect, "split_words " << path_name(path)
+						<< ", channels:" << n << ", rows:" << rows << ", shift:" << shift);
+				}
+			}
+		}
+	}
+}
+
+// The per bit loop the export used before planes_to_units.
+static void planes_to_units_by_bit(const uint8_t *const *planes, const bool *levels, int plane_count,
+								   uint64_t sample_count, uint8_t *dest, int unitsize)
+{
+	memset(dest, 0, sample_count * unitsize);
+
+	for (uint64_t j = 0; j < sample_count; j++){
+		for (int k = 0; k < plane_count; k++){
+			if (planes[k] == NULL && levels[k])
+				dest[j * unitsize + k / 8] += 1 << k % 8;
+			else if (planes[k] && (planes[k][j / 8] & (1 << j % 8)))
+				dest[j * unitsize + k / 8] += 1 << k % 8;
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(PlanesToUnits)
+{
+	// The plane count and the constant plane, a NULL plane keeps its level.
+	struct { int planes; int const_plane; } cases[] = {
+		{1, -1}, {8, -1}, {12, 3}, {16, -1}, {24, 0}, {32, -1}, {40, 39}, {64, -1}};
+	// Not a multiple of 64, the tail goes through the byte path.
+	const uint64_t samples = 64 * 5 + 13;
+	// The whole range at once, and chunks which start inside a word.
+	const uint64_t chunks[] = {samples, 64, 8 * 3};
+	mt19937_64 rng(2);
+
+	BOOST_TEST_MESSAGE("planes_to_units, best path:" << path_name(bits::simd_path()));
+
+	for (auto &tc : cases)
+	{
+		const int unitsize = (tc.planes + 7) / 8;
+		vector<vector<uint8_t>> plane_data(tc.planes, vector<uint8_t>((samples + 7) / 8));
+		const uint8_t *planes[64];
+		bool levels[64];
+
+		for (int k = 0; k < tc.planes; k++)
+		{
+			for (uint8_t &b : plane_data[k]){
+				b = (uint8_t)rng();
+			}
+			planes[k] = (k == tc.const_plane) ? NULL : plane_data[k].data();
+			levels[k] = (k % 2) != 0;
+		}
+
+		vector<uint8_t> expect(samples * unitsize);
+		planes_to_units_by_bit(planes, levels, tc.planes, samples, expect.data(), unitsize);
+
+		for (int p = bits::simd_path(); p >= bits::SIMD_SCALAR; p--)
+		{
+			const bits::SimdPath path = (bits::SimdPath)p;
+
+			for (uint64_t chunk : chunks)
+			{
+				vector<uint8_t> units(samples * unitsize, 0xa5);
+
+				for (uint64_t i = 0; i < samples; i += chunk){
+					bits::planes_to_units(planes, levels, tc.planes, i / 8, min(chunk, samples - i),
+										  units.data() + i * unitsize, unitsize, path);
+				}
+
+				BOOST_CHECK_MESSAGE(units == expect, "planes_to_units " << path_name(path)
+					<< ", channels:" << tc.planes << ", chunk:" << chunk);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
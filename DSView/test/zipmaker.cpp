@@ -0,0 +1,253 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../pv/ZipMaker.h"
+
+extern "C" {
+#include "../../libsigrok4DSL/libsigrok-internal.h"
+}
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(ZipMakerTest)
+
+// The session loader maps a stored leaf block in place only when its data
+// is 8-byte aligned in the file, see LogicSnapshot::append_block().
+BOOST_AUTO_TEST_CASE(StoredAligned)
+{
+	const char *path = "zipmaker_stored.zip";
+	const unsigned int align = sizeof(uint64_t);
+	const int count = 24;
+	const unsigned char extra[] = {0x44, 0x4D, 0x02, 0x00, 0x12, 0x34};
+
+	vector<char> data(4096 + 3);
+	for (unsigned int i = 0; i < data.size(); i++)
+		data[i] = (char)(i * 7 + 1);
+
+	ZipMaker maker;
+	BOOST_REQUIRE(maker.CreateNew(path, false));
+
+	// Names of every length and compressed entries between the stored ones
+	// move the next local header to every offset modulo the alignment.
+	for (int i = 0; i < count; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "L-%d/%.*s", i, i % 9, "abcdefghi");
+		BOOST_REQUIRE(maker.AddStored(name, data.data(), data.size() - i % 5,
+			extra, sizeof(extra), align));
+
+		if (i % 3 == 0) {
+			snprintf(name, sizeof(name), "header%d", i);
+			BOOST_REQUIRE(maker.AddFromBuffer(name, data.data(), 5 + i));
+		}
+	}
+	maker.Close();
+
+	unzFile archive = unzOpen64(path);
+	BOOST_REQUIRE(archive != NULL);
+
+	int stored = 0;
+	bool ok = true;
+	for (int ret = unzGoToFirstFile(archive); ret == UNZ_OK; ret = unzGoToNextFile(archive)) {
+		unz_file_info64 info;
+		char name[32];
+		unsigned char global_extra[16];
+
+		BOOST_REQUIRE(unzGetCurrentFileInfo64(archive, &info, name, sizeof(name),
+			global_extra, sizeof(global_extra), NULL, 0) == UNZ_OK);
+		if (info.compression_method != 0)
+			continue;
+
+		// The alignment padding stays out of the central directory.
+		ok &= info.size_file_extra == sizeof(extra)
+			&& memcmp(global_extra, extra, sizeof(extra)) == 0;
+
+		BOOST_REQUIRE(unzOpenCurrentFile(archive) == UNZ_OK);
+		ok &= unzGetCurrentFileZStreamPos64(archive) % align == 0;
+
+		vector<char> read(info.uncompressed_size);
+		ok &= unzReadCurrentFile(archive, read.data(), read.size()) == (int)read.size()
+			&& memcmp(read.data(), data.data(), read.size()) == 0;
+		unzCloseCurrentFile(archive);
+		stored++;
+	}
+	unzClose(archive);
+	remove(path);
+
+	BOOST_CHECK_EQUAL(stored, count);
+	BOOST_CHECK(ok);
+}
+
+// Blocks deflated on several threads and added in order, the way
+// StoreSession::save_logic() writes them, read back through minizip.
+BOOST_AUTO_TEST_CASE(DeflatedRoundTrip)
+{
+	const char *path = "zipmaker_deflated.zip";
+	mt19937 rng(9);
+	vector<vector<char>> blocks;
+
+	blocks.push_back(vector<char>());
+	blocks.push_back(vector<char>(1, 0x5a));
+	// Incompressible, deflate falls back to stored deflate blocks.
+	blocks.push_back(vector<char>(300000));
+	for (char &c : blocks.back())
+		c = (char)rng();
+	// Long runs, as in a slow logic channel.
+	blocks.push_back(vector<char>(1 << 20));
+	for (size_t i = 0; i < blocks.back().size(); i++)
+		blocks.back()[i] = (i / 4099) & 1 ? (char)0xff : 0;
+	for (int i = 0; i < 12; i++){
+		blocks.push_back(vector<char>(1000 + rng() % 70000));
+		for (char &c : blocks.back())
+			c = rng() % 5 == 0 ? (char)rng() : (char)i;
+	}
+
+	vector<ZipDeflateData> zdata(blocks.size());
+	vector<char> ok(blocks.size(), 0);
+	vector<thread> workers;
+	for (int t = 0; t < 4; t++){
+		workers.push_back(thread([&, t]{
+			for (size_t i = t; i < blocks.size(); i += 4)
+				ok[i] = ZipMaker::Deflate(blocks[i].data(), blocks[i].size(), 1 + i % 9, zdata[i]);
+		}));
+	}
+	for (auto &w : workers)
+		w.join();
+
+	ZipMaker maker;
+	BOOST_REQUIRE(maker.CreateNew(path, false));
+	for (size_t i = 0; i < blocks.size(); i++){
+		char name[32];
+		snprintf(name, sizeof(name), "L-0/%d", (int)i);
+		BOOST_CHECK(ok[i]);
+		BOOST_CHECK_EQUAL(zdata[i].raw_size, blocks[i].size());
+		BOOST_REQUIRE(maker.AddDeflated(name, zdata[i]));
+	}
+	maker.Close();
+
+	unzFile archive = unzOpen64(path);
+	BOOST_REQUIRE(archive != NULL);
+
+	size_t i = 0;
+	for (int ret = unzGoToFirstFile(archive); ret == UNZ_OK; ret = unzGoToNextFile(archive), i++) {
+		unz_file_info64 info;
+		BOOST_REQUIRE(i < blocks.size());
+		BOOST_REQUIRE(unzGetCurrentFileInfo64(archive, &info, NULL, 0, NULL, 0, NULL, 0) == UNZ_OK);
+		BOOST_CHECK_EQUAL(info.compression_method, (uLong)Z_DEFLATED);
+		BOOST_CHECK_EQUAL(info.uncompressed_size, blocks[i].size());
+		BOOST_CHECK_EQUAL(info.compressed_size, zdata[i].data.size());
+
+		// Read one byte past the end, the crc is checked when the entry is closed.
+		vector<char> read(blocks[i].size() + 1);
+		BOOST_REQUIRE(unzOpenCurrentFile(archive) == UNZ_OK);
+		BOOST_CHECK_EQUAL(unzReadCurrentFile(archive, read.data(), read.size()), (int)blocks[i].size());
+		BOOST_CHECK(memcmp(read.data(), blocks[i].data(), blocks[i].size()) == 0);
+		BOOST_CHECK_EQUAL(unzCloseCurrentFile(archive), UNZ_OK);
+	}
+	unzClose(archive);
+	remove(path);
+
+	BOOST_CHECK_EQUAL(i, blocks.size());
+}
+
+// The empty entry of a constant logic block, its length and level are in the
+// global extra field, see SR_SESSION_CONST_BLOCK_ID.
+static vector<unsigned char> const_block_extra(uint64_t len, bool level)
+{
+	vector<unsigned char> extra(4 + SR_SESSION_CONST_BLOCK_LEN);
+	extra[0] = SR_SESSION_CONST_BLOCK_ID & 0xff;
+	extra[1] = SR_SESSION_CONST_BLOCK_ID >> 8;
+	extra[2] = SR_SESSION_CONST_BLOCK_LEN;
+	extra[3] = 0;
+	for (int k = 0; k < 8; k++)
+		extra[4 + k] = (len >> (k * 8)) & 0xff;
+	extra[12] = level ? 0xff : 0x0;
+	return extra;
+}
+
+BOOST_AUTO_TEST_CASE(ConstBlockRoundTrip)
+{
+	const char *path = "zipmaker_const.zip";
+	const uint64_t lens[] = {1, 255, 1ULL << 21, 0x0102030405060708ULL};
+	// A leaf block record in front of the constant block record.
+	const unsigned char leaf[] = {0x44, 0x4D, 0x02, 0x00, 0x12, 0x34};
+
+	ZipMaker maker;
+	BOOST_REQUIRE(maker.CreateNew(path, false));
+	for (int i = 0; i < 4; i++){
+		char name[32];
+		snprintf(name, sizeof(name), "L-%d/0", i);
+		vector<unsigned char> extra = const_block_extra(lens[i], i & 1);
+		if (i == 3)
+			extra.insert(extra.begin(), leaf, leaf + sizeof(leaf));
+		BOOST_REQUIRE(maker.AddFromBuffer(name, NULL, 0, extra.data(), extra.size()));
+	}
+	// A block with data, no record.
+	BOOST_REQUIRE(maker.AddFromBuffer("L-4/0", "abc", 3, leaf, sizeof(leaf)));
+	maker.Close();
+
+	unzFile archive = unzOpen64(path);
+	BOOST_REQUIRE(archive != NULL);
+
+	int i = 0;
+	for (int ret = unzGoToFirstFile(archive); ret == UNZ_OK; ret = unzGoToNextFile(archive), i++) {
+		unz_file_info64 info;
+		unsigned char extra[64];
+		uint64_t len = 0;
+		uint8_t level = 0x55;
+
+		BOOST_REQUIRE(unzGetCurrentFileInfo64(archive, &info, NULL, 0,
+			extra, sizeof(extra), NULL, 0) == UNZ_OK);
+		const int found = sr_session_get_const_block(extra, info.size_file_extra, &len, &level);
+
+		if (i < 4){
+			BOOST_CHECK_EQUAL(info.uncompressed_size, 0U);
+			BOOST_CHECK(found);
+			BOOST_CHECK_EQUAL(len, lens[i]);
+			BOOST_CHECK_EQUAL(level, (i & 1) ? 0xff : 0x0);
+		}
+		else{
+			BOOST_CHECK(!found);
+		}
+	}
+	unzClose(archive);
+	remove(path);
+
+	BOOST_CHECK_EQUAL(i, 5);
+
+	// A record cut short by the end of the field is not read.
+	vector<unsigned char> extra = const_block_extra(100, true);
+	uint64_t len = 0;
+	uint8_t level = 0;
+	BOOST_CHECK(!sr_session_get_const_block(extra.data(), extra.size() - 1, &len, &level));
+	extra[2] = SR_SESSION_CONST_BLOCK_LEN - 1;
+	BOOST_CHECK(!sr_session_get_const_block(extra.data(), extra.size(), &len, &level));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1899,19 +1899,13 @@ static int cleanup(void)
 
 static void remove_sources(struct DSL_context *devc)
 {
-    int i;
-    sr_info("%s: remove fds from polling", __func__);
-    /* Remove fds from polling. */
-    for (i = 0; devc->usbfd[i] != -1; i++)
-        sr_source_remove(devc->usbfd[i]);
-    g_free(devc->usbfd);
+    sr_info("%s: remove the status timer", __func__);
+    sr_source_remove(-1);
+    dsl_stop_events(devc);
 }
 
 static int receive_data(int fd, int revents, const struct sr_dev_inst *sdi)
 {
-    int completed = 0;
-    struct timeval tv;
-    struct drv_context *drvc;
     struct DSL_context *devc;
     struct ctl_rd_cmd rd_cmd;
     struct sr_usb_dev_inst *usb;
@@ -1920,13 +1914,10 @@ static int receive_data(int fd, int revents, const struct sr_dev_inst *sdi)
     (void)fd;
     (void)revents;
 
-    drvc = di->priv;
     devc = sdi->priv;
     usb = sdi->conn;
 
-    tv.tv_sec = tv.tv_usec = 0;
-    libusb_handle_events_timeout_completed(drvc->sr_ctx->libusb_ctx, &tv, &completed);
-
+    /* A timer tick, the transfers complete on the event thread. */
     if (devc->trf_completed)
         devc->empty_poll_count = 0;
     else
@@ -1967,8 +1958,6 @@ static int dev_acquisition_start(struct sr_dev_inst *sdi, void *cb_data)
     struct DSL_context *devc;
     struct sr_usb_dev_inst *usb;
     struct drv_context *drvc;
-    const struct libusb_pollfd **lupfd;
-	unsigned int i;
     int ret;
     struct ctl_wr_cmd wr_cmd;
     GSList *l;
@@ -2087,24 +2076,6 @@ static int dev_acquisition_start(struct sr_dev_inst *sdi, void *cb_data)
         return ret;
     }
 
-    /* setup callback function for data transfer */
-    lupfd = libusb_get_pollfds(drvc->sr_ctx->libusb_ctx);
-    for (i = 0; lupfd[i]; i++);
-
-    if (!(devc->usbfd = g_try_malloc0(sizeof(struct libusb_pollfd) * (i + 1)))){
-        sr_err("%s,ERROR:failed to alloc memory.", __func__);
-    	return SR_ERR;
-    }
-
-    for (i = 0; lupfd[i]; i++) {
-        sr_source_add(lupfd[i]->fd, lupfd[i]->events,
-                  dsl_get_timeout(sdi), receive_data, sdi);
-        devc->usbfd[i] = lupfd[i]->fd;
-    }
-
-    devc->usbfd[i] = -1;
-    g_free(lupfd);
-
     wr_cmd.header.dest = DSL_CTL_START;
     wr_cmd.header.size = 0;
     if ((ret = command_ctl_wr(usb->devhdl, wr_cmd)) != SR_OK) {
@@ -2118,6 +2089,10 @@ static int dev_acquisition_start(struct sr_dev_inst *sdi, void *cb_data)
     //std_session_send_df_header(cb_data, LOG_PREFIX);
     std_session_send_df_header(sdi, LOG_PREFIX);
 
+    /* The transfers complete on the event thread, the timer only checks the status. */
+    sr_source_add(-1, 0, dsl_get_status_period(sdi), receive_data, sdi);
+    dsl_start_events(sdi, drvc->sr_ctx->libusb_ctx);
+
     return SR_OK;
 }
 
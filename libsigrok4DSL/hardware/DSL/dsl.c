@@ -1707,6 +1707,41 @@ SR_PRIV int dsl_config_get(int id, GVariant **data, const struct sr_dev_inst *sd
             return SR_ERR;
         *data = g_variant_new_uint64(devc->actual_samples);
         break;
+    case SR_CONF_INGEST_HIGH_WATER:
+        if (!sdi)
+            return SR_ERR;
+        *data = g_variant_new_int32(g_atomic_int_get(&devc->ingest.high_water));
+        break;
+    case SR_CONF_INGEST_STALLS:
+        if (!sdi)
+            return SR_ERR;
+        *data = g_variant_new_int32(g_atomic_int_get(&devc->ingest.stalls));
+        break;
+    case SR_CONF_ADAPTIVE_TRANSFER:
+        if (!sdi)
+            return SR_ERR;
+        *data = g_variant_new_boolean(devc->adaptive);
+        break;
+    case SR_CONF_TRANSFER_SIZE:
+        if (!sdi)
+            return SR_ERR;
+        *data = g_variant_new_uint64(devc->adapt.length);
+        break;
+    case SR_CONF_TRANSFER_COUNT:
+        if (!sdi)
+            return SR_ERR;
+        *data = g_variant_new_int32(devc->adapt.count);
+        break;
+    case SR_CONF_TRANSFER_HEADROOM:
+        if (!sdi)
+            return SR_ERR;
+        *data = g_variant_new_double(devc->adapt.min_headroom);
+        break;
+    case SR_CONF_INGEST_LOAD:
+        if (!sdi)
+            return SR_ERR;
+        *data = g_variant_new_double(devc->adapt.ingest_load);
+        break;
     case SR_CONF_BANDWIDTH:
         if (!sdi)
             return SR_ERR;
@@ -2158,10 +2193,314 @@ SR_PRIV unsigned int dsl_get_timeout(const struct sr_dev_inst *sdi)
         return 20;
 }
 
+/*
+ * The period of the status timer, MAX_EMPTY_POLL idle periods trigger a
+ * progress or overflow query. Capped so a slow stream still stops promptly.
+ */
+SR_PRIV unsigned int dsl_get_status_period(const struct sr_dev_inst *sdi)
+{
+    return min(dsl_get_timeout(sdi), MAX_STATUS_PERIOD);
+}
+
+/*
+ * The ring slots for buffers of size bytes: twice the transfers in flight,
+ * so a burst of completions finds room while the consumer is behind, but
+ * never more than MAX_INGEST_BYTES. A full ring drops the newest buffer.
+ */
+SR_PRIV gint dsl_ingest_slots(unsigned int max_count, size_t size)
+{
+    gint slots = max(2 * (gint)max_count, MIN_INGEST_SLOTS);
+
+    if (size > 0 && (uint64_t)slots * size > MAX_INGEST_BYTES)
+        slots = max((gint)(MAX_INGEST_BYTES / size), 2);
+
+    return slots;
+}
+
+SR_PRIV int dsl_ingest_init(struct DSL_ingest *ing, gint slots, size_t size)
+{
+    gint i;
+
+    ing->bufs = g_try_malloc0(sizeof(uint8_t*) * slots);
+    ing->lengths = g_try_malloc0(sizeof(uint64_t) * slots);
+    if (ing->bufs == NULL || ing->lengths == NULL) {
+        sr_err("%s: ingest ring malloc failed.", __func__);
+        g_free(ing->bufs);
+        g_free(ing->lengths);
+        ing->bufs = NULL;
+        ing->lengths = NULL;
+        return SR_ERR_MALLOC;
+    }
+
+    for (i = 0; i < slots; i++) {
+        if (!(ing->bufs[i] = g_try_malloc0(size))) {
+            sr_err("%s: ingest buffer malloc failed.", __func__);
+            while (i-- > 0)
+                g_free(ing->bufs[i]);
+            g_free(ing->bufs);
+            g_free(ing->lengths);
+            ing->bufs = NULL;
+            ing->lengths = NULL;
+            return SR_ERR_MALLOC;
+        }
+    }
+
+    ing->size = slots;
+    ing->head = 0;
+    ing->tail = 0;
+    ing->waiting = 0;
+    ing->exit = 0;
+    ing->high_water = 0;
+    ing->stalls = 0;
+    ing->busy_us = 0;
+
+    return SR_OK;
+}
+
+SR_PRIV void dsl_ingest_free(struct DSL_ingest *ing)
+{
+    gint i;
+
+    for (i = 0; i < ing->size; i++)
+        g_free(ing->bufs[i]);
+    g_free(ing->bufs);
+    g_free(ing->lengths);
+    ing->bufs = NULL;
+    ing->lengths = NULL;
+    ing->size = 0;
+}
+
+/*
+ * Producer side. The filled buffer goes into the ring and *buf takes the
+ * consumed one of the slot, nothing is copied. A full ring counts a stall
+ * and keeps *buf, the data is dropped.
+ */
+SR_PRIV gboolean dsl_ingest_put(struct DSL_ingest *ing, uint8_t **buf, uint64_t length)
+{
+    gint head = ing->head;
+    gint next = (head + 1) % ing->size;
+    gint used;
+    uint8_t *free_buf;
+
+    if (next == g_atomic_int_get(&ing->tail)) {
+        g_atomic_int_inc(&ing->stalls);
+        return FALSE;
+    }
+
+    free_buf = ing->bufs[head];
+    ing->bufs[head] = *buf;
+    ing->lengths[head] = length;
+    *buf = free_buf;
+    g_atomic_int_set(&ing->head, next);
+
+    used = (next - g_atomic_int_get(&ing->tail) + ing->size) % ing->size;
+    if (used > g_atomic_int_get(&ing->high_water))
+        g_atomic_int_set(&ing->high_water, used);
+
+    return TRUE;
+}
+
+/*
+ * Consumer side, the oldest buffer of the ring. It stays in the ring until
+ * dsl_ingest_release().
+ */
+SR_PRIV gboolean dsl_ingest_get(struct DSL_ingest *ing, uint8_t **data, uint64_t *length)
+{
+    gint tail = g_atomic_int_get(&ing->tail);
+
+    if (tail == g_atomic_int_get(&ing->head))
+        return FALSE;
+
+    *data = ing->bufs[tail];
+    *length = ing->lengths[tail];
+    return TRUE;
+}
+
+SR_PRIV void dsl_ingest_release(struct DSL_ingest *ing)
+{
+    g_atomic_int_set(&ing->tail, (g_atomic_int_get(&ing->tail) + 1) % ing->size);
+}
+
+/*
+ * Consumer side, forwards the oldest buffer of the ring. Returns FALSE on
+ * an empty ring.
+ */
+SR_PRIV gboolean dsl_ingest_forward(struct DSL_ingest *ing)
+{
+    uint8_t *buf;
+    uint64_t length;
+    int64_t start;
+
+    g_mutex_lock(&ing->consume);
+
+    if (!dsl_ingest_get(ing, &buf, &length)) {
+        g_mutex_unlock(&ing->consume);
+        return FALSE;
+    }
+
+    start = g_get_monotonic_time();
+    ing->forward(ing->cb_data, buf, length);
+    ing->busy_us += g_get_monotonic_time() - start;
+    dsl_ingest_release(ing);
+
+    g_mutex_unlock(&ing->consume);
+    return TRUE;
+}
+
+/*
+ * Producer side, for a full ring that must not drop. The caller takes over
+ * from the consumer: the ring is forwarded in order, then buf itself, so
+ * the producer slows down to the pace of the consumer.
+ */
+SR_PRIV void dsl_ingest_flush(struct DSL_ingest *ing, uint8_t *buf, uint64_t length)
+{
+    uint8_t *data;
+    uint64_t len;
+
+    g_mutex_lock(&ing->consume);
+
+    while (dsl_ingest_get(ing, &data, &len)) {
+        ing->forward(ing->cb_data, data, len);
+        dsl_ingest_release(ing);
+    }
+    ing->forward(ing->cb_data, buf, length);
+
+    g_mutex_unlock(&ing->consume);
+}
+
+static void ingest_forward(void *cb_data, uint8_t *buf, uint64_t length)
+{
+    struct sr_datafeed_packet packet;
+    struct sr_datafeed_logic logic;
+
+    packet.type = SR_DF_LOGIC;
+    packet.status = SR_PKT_OK;
+    packet.payload = &logic;
+    logic.format = LA_CROSS_DATA;
+    logic.data_error = 0;
+    logic.length = length;
+    logic.data = buf;
+    ds_data_forward(cb_data, &packet);
+}
+
+static gpointer ingest_proc(gpointer data)
+{
+    struct DSL_context *devc = data;
+    struct DSL_ingest *ing = &devc->ingest;
+    uint8_t *buf;
+    uint64_t length;
+
+    for (;;) {
+        if (!dsl_ingest_forward(ing)) {
+            /* Drained, the exit flag is only honoured on an empty ring. */
+            if (g_atomic_int_get(&ing->exit))
+                break;
+
+            g_mutex_lock(&ing->mutex);
+            g_atomic_int_set(&ing->waiting, 1);
+            if (!dsl_ingest_get(ing, &buf, &length) && !g_atomic_int_get(&ing->exit))
+                g_cond_wait_until(&ing->cond, &ing->mutex,
+                                  g_get_monotonic_time() + 10 * G_TIME_SPAN_MILLISECOND);
+            g_atomic_int_set(&ing->waiting, 0);
+            g_mutex_unlock(&ing->mutex);
+        }
+    }
+
+    return NULL;
+}
+
+static void ingest_stop(struct DSL_context *devc)
+{
+    struct DSL_ingest *ing = &devc->ingest;
+
+    if (ing->thread == NULL)
+        return;
+
+    g_mutex_lock(&ing->mutex);
+    g_atomic_int_set(&ing->exit, 1);
+    g_cond_signal(&ing->cond);
+    g_mutex_unlock(&ing->mutex);
+
+    g_thread_join(ing->thread);
+    ing->thread = NULL;
+
+    sr_info("%s: ingest ring, slots:%d, high water:%d, full:%d",
+            __func__, ing->size, ing->high_water, ing->stalls);
+
+    dsl_ingest_free(ing);
+    g_mutex_clear(&ing->mutex);
+    g_mutex_clear(&ing->consume);
+    g_cond_clear(&ing->cond);
+}
+
+static int ingest_start(const struct sr_dev_inst *sdi)
+{
+    struct DSL_context *devc = sdi->priv;
+    struct DSL_ingest *ing = &devc->ingest;
+    int ret;
+
+    ingest_stop(devc);
+
+    ret = dsl_ingest_init(ing, dsl_ingest_slots(devc->adapt.max_count, devc->adapt.capacity),
+                          devc->adapt.capacity);
+    if (ret != SR_OK)
+        return ret;
+
+    g_mutex_init(&ing->mutex);
+    g_mutex_init(&ing->consume);
+    g_cond_init(&ing->cond);
+    ing->forward = ingest_forward;
+    ing->cb_data = devc->cb_data;
+    ing->thread = g_thread_new("ingest_proc", ingest_proc, devc);
+
+    return SR_OK;
+}
+
+/*
+ * Hand a logic transfer to the ingest thread. This runs on the USB event
+ * thread. On a full ring, a buffered capture forwards the data here, the
+ * device keeps the rest in its memory until the upload resumes. A stream
+ * cannot wait: the data is dropped and the status timer reports the
+ * overflow.
+ */
+static void ingest_push(struct DSL_context *devc, struct libusb_transfer *transfer, uint64_t length)
+{
+    struct DSL_ingest *ing = &devc->ingest;
+
+    if (!dsl_ingest_put(ing, &transfer->buffer, length)) {
+        if (!devc->stream) {
+            dsl_ingest_flush(ing, transfer->buffer, length);
+            return;
+        }
+
+        if (!devc->overflow)
+            sr_err("%s: ingest ring full, drop %llu bytes.", __func__, (u64_t)length);
+        devc->overflow = TRUE;
+        return;
+    }
+
+    if (g_atomic_int_get(&ing->waiting)) {
+        g_mutex_lock(&ing->mutex);
+        g_cond_signal(&ing->cond);
+        g_mutex_unlock(&ing->mutex);
+    }
+}
+
 static void finish_acquisition(struct DSL_context *devc)
 {
     struct sr_datafeed_packet packet;
 
+    /* Deliver what is still in the ring before the end packet. */
+    ingest_stop(devc);
+
+    if (devc->adapt.active) {
+        sr_info("%s: transfers, size:%llu, count:%u, min headroom:%.2f, ingest load:%.2f, grows:%u, shrinks:%u",
+                __func__, (u64_t)devc->adapt.length, devc->adapt.count, devc->adapt.min_headroom,
+                devc->adapt.ingest_load, devc->adapt.grows, devc->adapt.shrinks);
+    }
+    g_free(devc->adapt.submit_time);
+    devc->adapt.submit_time = NULL;
+
     sr_info("%s: send SR_DF_END packet", __func__);
     /* Terminate session. */
     packet.type = SR_DF_END;
@@ -2203,13 +2542,41 @@ static void free_transfer(struct libusb_transfer *transfer, int force)
     }
 }
 
+static int transfer_index(const struct DSL_context *devc, const struct libusb_transfer *transfer)
+{
+    unsigned int i;
+
+    for (i = 0; i < devc->num_transfers; i++) {
+        if (devc->transfers[i] == transfer)
+            return i;
+    }
+    return -1;
+}
+
+static void stamp_transfer(struct DSL_context *devc, const struct libusb_transfer *transfer, int64_t time)
+{
+    int i;
+
+    if (devc->adapt.active && (i = transfer_index(devc, transfer)) >= 0)
+        devc->adapt.submit_time[i] = time;
+}
+
 static void resubmit_transfer(struct libusb_transfer *transfer)
 {
+    struct DSL_context *devc = transfer->user_data;
+    int64_t now = g_get_monotonic_time();
     int ret;
 
-    if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS)
+    if (devc->adapt.active)
+        transfer->length = devc->adapt.length;
+
+    if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS) {
+        stamp_transfer(devc, transfer, now);
         return;
+    }
 
+    if (devc->adapt.active)
+        devc->adapt.count--;
     free_transfer(transfer, 0);
     /* TODO: Stop session? */
 
@@ -2305,6 +2672,142 @@ static void get_measure(const struct sr_dev_inst *sdi, uint8_t *buf, uint32_t of
     }
 }
 
+static void receive_transfer(struct libusb_transfer *transfer);
+
+static int add_transfer(const struct sr_dev_inst *sdi)
+{
+    struct DSL_context *devc = sdi->priv;
+    struct sr_usb_dev_inst *usb = sdi->conn;
+    struct libusb_transfer *transfer;
+    unsigned char *buf;
+    unsigned int i;
+    int64_t now;
+    int ret;
+
+    /* Reuse a slot of a retired transfer, the header transfer is slot 0. */
+    for (i = 1; i < devc->num_transfers && devc->transfers[i] != NULL; i++);
+    if (i > devc->adapt.max_count)
+        return SR_ERR;
+
+    if (!(buf = g_try_malloc0(devc->adapt.capacity))) {
+        sr_err("%s: USB transfer buffer malloc failed.", __func__);
+        return SR_ERR_MALLOC;
+    }
+    transfer = libusb_alloc_transfer(0);
+    libusb_fill_bulk_transfer(transfer, usb->devhdl,
+            6 | LIBUSB_ENDPOINT_IN, buf, devc->adapt.length,
+            (libusb_transfer_cb_fn)receive_transfer, devc, 0);
+
+    now = g_get_monotonic_time();
+    if ((ret = libusb_submit_transfer(transfer)) != 0) {
+        sr_err("%s: Failed to submit transfer: %s.",
+               __func__, libusb_error_name(ret));
+        libusb_free_transfer(transfer);
+        g_free(buf);
+        return SR_ERR;
+    }
+
+    devc->transfers[i] = transfer;
+    if (i == devc->num_transfers)
+        devc->num_transfers++;
+    devc->submitted_transfers++;
+    devc->adapt.count++;
+    stamp_transfer(devc, transfer, now);
+
+    return SR_OK;
+}
+
+/*
+ * The decision at the end of a window, from the lowest headroom of the
+ * window and the ingest load. When the host fell behind, a pending retire
+ * is cancelled, then the queue grows, then the transfer length, and they
+ * are given back after ADAPT_CALM_WINDOWS calm windows. A busy ingest
+ * thread gets larger transfers rather than more of them.
+ * Returns TRUE when the caller should queue one more transfer.
+ */
+SR_PRIV gboolean dsl_adapt_window(struct DSL_adapt *ad, double load)
+{
+    gboolean add = FALSE;
+
+    if (ad->window_headroom < ADAPT_LOW_HEADROOM || load > ADAPT_INGEST_LOAD) {
+        ad->calm_windows = 0;
+
+        if (load <= ADAPT_INGEST_LOAD && ad->retire > 0) {
+            ad->retire--;
+            ad->grows++;
+        }
+        else if (load <= ADAPT_INGEST_LOAD && ad->count < ad->max_count) {
+            ad->grows++;
+            add = TRUE;
+        }
+        else if (ad->length < ad->capacity) {
+            ad->length = min(ad->length * 2, ad->capacity);
+            ad->grows++;
+        }
+    }
+    else if (ad->window_headroom > ADAPT_HIGH_HEADROOM) {
+        if (++ad->calm_windows >= ADAPT_CALM_WINDOWS) {
+            ad->calm_windows = 0;
+
+            if (ad->length > ad->base_size) {
+                ad->length = max(ad->length / 2, ad->base_size);
+                ad->shrinks++;
+            }
+            else if (ad->count - ad->retire > ad->base_count) {
+                ad->retire++;
+                ad->shrinks++;
+            }
+        }
+    }
+    else {
+        ad->calm_windows = 0;
+    }
+
+    ad->window_headroom = 1.0;
+    return add;
+}
+
+/*
+ * Called on each streamed logic completion. The headroom of a transfer is
+ * its completion latency over the time the queue ahead of it and itself
+ * take to fill. A healthy queue is near 1, a transfer that completes right
+ * after its submission found the device buffer already holding data.
+ */
+static void adapt_transfers(const struct sr_dev_inst *sdi, struct libusb_transfer *transfer)
+{
+    struct DSL_context *devc = sdi->priv;
+    struct DSL_adapt *ad = &devc->adapt;
+    int64_t now = g_get_monotonic_time();
+    int64_t elapsed;
+    double expected;
+    double headroom;
+    double load;
+    int i;
+
+    if ((i = transfer_index(devc, transfer)) < 0 || ad->submit_time[i] == 0)
+        return;
+
+    expected = (double)ad->count * transfer->length * 1000.0 / to_bytes_per_ms(devc);
+    headroom = min((now - ad->submit_time[i]) / expected, 1.0);
+    ad->window_headroom = min(ad->window_headroom, headroom);
+    ad->min_headroom = min(ad->min_headroom, headroom);
+
+    elapsed = now - ad->window_start;
+    if (elapsed < ADAPT_WINDOW_MS * 1000)
+        return;
+
+    load = (double)(devc->ingest.busy_us - ad->window_busy_us) / elapsed;
+    ad->ingest_load = load;
+    ad->window_busy_us = devc->ingest.busy_us;
+    ad->window_start = now;
+
+    if (dsl_adapt_window(ad, load) && add_transfer(sdi) != SR_OK) {
+        /* The queue stays as it is, later windows grow the length. */
+        ad->grows--;
+        ad->max_count = ad->count;
+    }
+}
+
 static void receive_transfer(struct libusb_transfer *transfer)
 {
     struct sr_datafeed_packet packet;
@@ -2405,8 +2908,12 @@ static void receive_transfer(struct libusb_transfer *transfer)
             }
 
             /* send data to session bus */
-            if (packet.status == SR_PKT_OK)
-                ds_data_forward(sdi, &packet);
+            if (packet.status == SR_PKT_OK) {
+                if (sdi->mode == LOGIC && devc->ingest.thread != NULL)
+                    ingest_push(devc, transfer, logic.length);
+                else
+                    ds_data_forward(sdi, &packet);
+            }
         }
 
         devc->num_samples += cur_sample_count;
@@ -2428,9 +2935,18 @@ static void receive_transfer(struct libusb_transfer *transfer)
 
             }
         }
+
+        if (devc->adapt.active && devc->status == DSL_DATA)
+            adapt_transfers(sdi, transfer);
     }
 
-    if (devc->status == DSL_DATA)
+    if (devc->status == DSL_DATA && devc->adapt.retire > 0) {
+        /* Shrink the queue, this transfer is not resubmitted. */
+        devc->adapt.retire--;
+        devc->adapt.count--;
+        free_transfer(transfer, 1);
+    }
+    else if (devc->status == DSL_DATA)
         resubmit_transfer(transfer);
     else
         free_transfer(transfer, 0);
@@ -2504,13 +3020,38 @@ SR_PRIV int dsl_start_transfers(const struct sr_dev_inst *sdi)
     num_transfers = get_number_of_transfers(sdi);
     size = get_buffer_size(sdi);
 
+    /* Streamed logic starts from the fixed sizes and adapts from there. */
+    devc->adapt.active = (sdi->mode == LOGIC && devc->stream && devc->adaptive);
+    devc->adapt.base_size = size;
+    devc->adapt.length = size;
+    devc->adapt.capacity = devc->adapt.active ? size * ADAPT_MAX_SCALE : size;
+    devc->adapt.base_count = num_transfers;
+    devc->adapt.max_count = devc->adapt.active ? min(2 * num_transfers, NUM_SIMUL_TRANSFERS) : num_transfers;
+    devc->adapt.count = 0;
+    devc->adapt.retire = 0;
+    devc->adapt.window_start = g_get_monotonic_time();
+    devc->adapt.window_headroom = 1.0;
+    devc->adapt.calm_windows = 0;
+    devc->adapt.window_busy_us = 0;
+    devc->adapt.min_headroom = 1.0;
+    devc->adapt.ingest_load = 0;
+    devc->adapt.grows = 0;
+    devc->adapt.shrinks = 0;
+
+    g_free(devc->adapt.submit_time);
+    devc->adapt.submit_time = g_try_malloc0(sizeof(int64_t) * (devc->adapt.max_count + 1));
+    if (!devc->adapt.submit_time) {
+        sr_err("%s: USB transfer malloc failed.", __func__);
+        return SR_ERR_MALLOC;
+    }
+
     /* trigger packet transfer */
     if (!(trigger_pos = g_try_malloc0(dsl_header_size(devc)))) {
         sr_err("%s: USB trigger_pos buffer malloc failed.", __func__);
         return SR_ERR_MALLOC;
     }
 
-    devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * (num_transfers + 1));
+    devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * (devc->adapt.max_count + 1));
     if (!devc->transfers) {
         sr_err("%s: USB transfer malloc failed.", __func__);
         return SR_ERR_MALLOC;
@@ -2532,9 +3073,16 @@ SR_PRIV int dsl_start_transfers(const struct sr_dev_inst *sdi)
         devc->submitted_transfers++;
     }
 
+    /* The ingest thread is stopped by finish_acquisition(). */
+    if (sdi->mode == LOGIC && (ret = ingest_start(sdi)) != SR_OK) {
+        devc->status = DSL_ERROR;
+        devc->abort = TRUE;
+        return ret;
+    }
+
     /* data packet transfer */
     for (i = 1; i <= num_transfers; i++) {
-        if (!(buf = g_try_malloc0(size))) {
+        if (!(buf = g_try_malloc0(devc->adapt.capacity))) {
             sr_err("%s: USB transfer buffer malloc failed.", __func__);
             return SR_ERR_MALLOC;
         }
@@ -2554,11 +3102,53 @@ SR_PRIV int dsl_start_transfers(const struct sr_dev_inst *sdi)
         devc->transfers[i] = transfer;
         devc->submitted_transfers++;
         devc->num_transfers++;
+        devc->adapt.count++;
+        stamp_transfer(devc, transfer, g_get_monotonic_time());
     }
 
     return SR_OK;
 }
 
+static gpointer event_proc(gpointer data)
+{
+    struct DSL_context *devc = data;
+    struct timeval tv;
+
+    /*
+     * The transfer callbacks run here. The timeout only bounds the time
+     * to notice event_exit, libusb returns as soon as there is work.
+     */
+    while (!g_atomic_int_get(&devc->event_exit)) {
+        tv.tv_sec = 0;
+        tv.tv_usec = 50 * 1000;
+        libusb_handle_events_timeout_completed(devc->event_ctx, &tv, &devc->event_exit);
+    }
+
+    return NULL;
+}
+
+SR_PRIV int dsl_start_events(const struct sr_dev_inst *sdi, libusb_context *ctx)
+{
+    struct DSL_context *devc = sdi->priv;
+
+    dsl_stop_events(devc);
+
+    devc->event_ctx = ctx;
+    devc->event_exit = 0;
+    devc->event_thread = g_thread_new("usb_event_proc", event_proc, devc);
+
+    return SR_OK;
+}
+
+SR_PRIV void dsl_stop_events(struct DSL_context *devc)
+{
+    if (devc->event_thread == NULL)
+        return;
+
+    g_atomic_int_set(&devc->event_exit, 1);
+    g_thread_join(devc->event_thread);
+    devc->event_thread = NULL;
+}
 
 SR_PRIV int dsl_destroy_device(struct sr_dev_inst *sdi)
 { 
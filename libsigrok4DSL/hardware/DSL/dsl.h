@@ -41,6 +41,17 @@
 #define NUM_TRIGGER_STAGES	16
 #define NUM_SIMUL_TRANSFERS	64
 #define MAX_EMPTY_POLL      16
+#define MAX_STATUS_PERIOD   100
+
+/* Adaptive streaming transfers, see adapt_transfers() */
+#define ADAPT_WINDOW_MS     250
+#define ADAPT_MAX_SCALE     2
+#define ADAPT_LOW_HEADROOM  0.5
+#define ADAPT_HIGH_HEADROOM 0.9
+#define ADAPT_CALM_WINDOWS  8
+#define ADAPT_INGEST_LOAD   0.8
+#define MIN_INGEST_SLOTS    16
+#define MAX_INGEST_BYTES    (64 * 1024 * 1024)
 
 #define DSL_REQUIRED_VERSION_MAJOR	2
 #define DSL_REQUIRED_VERSION_MINOR	0
@@ -1152,6 +1163,63 @@ enum {
     DSL_ABORT = 8,
 };
 
+/*
+ * Logic buffers handed from the libusb callback to the ingest thread.
+ * The callback is the only writer of head, the ingest thread of tail.
+ */
+struct DSL_ingest {
+    uint8_t **bufs;
+    uint64_t *lengths;
+    gint size;
+    gint head;
+    gint tail;
+    gint waiting;
+    gint exit;
+    GThread *thread;
+    GMutex mutex;
+    GCond cond;
+
+    /* Held while a buffer is forwarded, by the ingest thread or a flush */
+    GMutex consume;
+    void (*forward)(void *cb_data, uint8_t *buf, uint64_t length);
+    void *cb_data;
+
+    /* Kept after the capture for SR_CONF_INGEST_* */
+    gint high_water;
+    gint stalls; /* the buffers that found the ring full */
+
+    /* Written by the ingest thread, the time spent forwarding */
+    uint64_t busy_us;
+};
+
+/*
+ * Streaming transfer sizing. The buffers are allocated for ADAPT_MAX_SCALE
+ * times the base size, the length submitted and the transfers in flight
+ * move between the base values and the limits.
+ */
+struct DSL_adapt {
+    gboolean active;
+    size_t base_size;
+    size_t capacity;
+    size_t length;
+    unsigned int base_count;
+    unsigned int max_count;
+    unsigned int count;
+    unsigned int retire;
+    int64_t *submit_time; /* per devc->transfers slot */
+
+    int64_t window_start;
+    double window_headroom;
+    int calm_windows;
+    uint64_t window_busy_us;
+
+    /* Kept after the capture for SR_CONF_TRANSFER_* */
+    double min_headroom;
+    double ingest_load;
+    unsigned int grows;
+    unsigned int shrinks;
+};
+
 struct DSL_context {
     const struct DSL_profile *profile;
 	/*
@@ -1222,7 +1290,11 @@ struct DSL_context {
 	void *cb_data;
 	unsigned int num_transfers;
 	struct libusb_transfer **transfers;
-	int *usbfd;
+
+    /* libusb events are handled by their own thread during a capture */
+    libusb_context *event_ctx;
+    GThread *event_thread;
+    gint event_exit;
 
     int pipe_fds[2];
     GIOChannel *channel;
@@ -1237,6 +1309,9 @@ struct DSL_context {
     int empty_poll_count;
 
     int is_loop;
+    gboolean adaptive;
+    struct DSL_ingest ingest;
+    struct DSL_adapt adapt;
 };
 
 /*
@@ -1423,6 +1498,16 @@ SR_PRIV gboolean dsl_probe_fgain_inrange(struct sr_channel *probe, gboolean comb
 SR_PRIV int dsl_fpga_arm(const struct sr_dev_inst *sdi);
 SR_PRIV int dsl_fpga_config(struct libusb_device_handle *hdl, const char *filename);
 
+SR_PRIV gint dsl_ingest_slots(unsigned int max_count, size_t size);
+SR_PRIV int dsl_ingest_init(struct DSL_ingest *ing, gint slots, size_t size);
+SR_PRIV void dsl_ingest_free(struct DSL_ingest *ing);
+SR_PRIV gboolean dsl_ingest_put(struct DSL_ingest *ing, uint8_t **buf, uint64_t length);
+SR_PRIV gboolean dsl_ingest_get(struct DSL_ingest *ing, uint8_t **data, uint64_t *length);
+SR_PRIV void dsl_ingest_release(struct DSL_ingest *ing);
+SR_PRIV gboolean dsl_ingest_forward(struct DSL_ingest *ing);
+SR_PRIV void dsl_ingest_flush(struct DSL_ingest *ing, uint8_t *buf, uint64_t length);
+SR_PRIV gboolean dsl_adapt_window(struct DSL_adapt *ad, double load);
+
 SR_PRIV int dsl_config_get(int id, GVariant **data, const struct sr_dev_inst *sdi,
                       const struct sr_channel *ch,
                       const struct sr_channel_group *cg);
@@ -1438,7 +1523,10 @@ SR_PRIV int dsl_dev_acquisition_stop(const struct sr_dev_inst *sdi, void *cb_dat
 SR_PRIV int dsl_dev_status_get(const struct sr_dev_inst *sdi, struct sr_status *status, gboolean prg);
 
 SR_PRIV unsigned int dsl_get_timeout(const struct sr_dev_inst *sdi);
+SR_PRIV unsigned int dsl_get_status_period(const struct sr_dev_inst *sdi);
 SR_PRIV int dsl_start_transfers(const struct sr_dev_inst *sdi);
+SR_PRIV int dsl_start_events(const struct sr_dev_inst *sdi, libusb_context *ctx);
+SR_PRIV void dsl_stop_events(struct DSL_context *devc);
 SR_PRIV int dsl_header_size(const struct DSL_context *devc);
 
 SR_PRIV int dsl_destroy_device(struct sr_dev_inst *sdi);
@@ -142,6 +142,7 @@ static const int32_t hwoptions[] = {
     SR_CONF_RLE_SUPPORT,
     SR_CONF_CLOCK_TYPE,
     SR_CONF_CLOCK_EDGE,
+    SR_CONF_ADAPTIVE_TRANSFER,
 };
 
 static const int32_t hwoptions_pro[] = {
@@ -153,6 +154,7 @@ static const int32_t hwoptions_pro[] = {
     SR_CONF_RLE_SUPPORT,
     SR_CONF_CLOCK_TYPE,
     SR_CONF_CLOCK_EDGE,
+    SR_CONF_ADAPTIVE_TRANSFER,
 };
 
 static const int32_t sessions[] = {
@@ -172,6 +174,7 @@ static const int32_t sessions[] = {
     SR_CONF_HORIZ_TRIGGERPOS,
     SR_CONF_TRIGGER_HOLDOFF,
     SR_CONF_TRIGGER_MARGIN,
+    SR_CONF_ADAPTIVE_TRANSFER,
 };
 
 static const int32_t sessions_pro[] = {
@@ -192,6 +195,7 @@ static const int32_t sessions_pro[] = {
     SR_CONF_HORIZ_TRIGGERPOS,
     SR_CONF_TRIGGER_HOLDOFF,
     SR_CONF_TRIGGER_MARGIN,
+    SR_CONF_ADAPTIVE_TRANSFER,
 };
 
 SR_PRIV struct sr_dev_driver DSLogic_driver_info;
@@ -244,6 +248,7 @@ static struct DSL_context *DSLogic_dev_new(const struct DSL_profile *prof)
     devc->zero_comb = FALSE;
     devc->status = DSL_FINISH;
     devc->is_loop = 0;
+    devc->adaptive = FALSE;
 
     devc->mstatus_valid = FALSE;
     devc->data_lock = FALSE;
@@ -1173,6 +1178,9 @@ static int config_set(int id, GVariant *data, struct sr_dev_inst *sdi,
         devc->is_loop = g_variant_get_boolean(data);
         sr_info("Set device loop mode:%d", devc->is_loop);
     }
+    else if (id == SR_CONF_ADAPTIVE_TRANSFER) {
+        devc->adaptive = g_variant_get_boolean(data);
+    }
     else {
         ret = SR_ERR_NA;
 	}
@@ -1314,12 +1322,9 @@ static int cleanup(void)
 
 static void remove_sources(struct DSL_context *devc)
 {
-    int i;
-    sr_info("%s: remove fds from polling", __func__);
-    /* Remove fds from polling. */
-    for (i = 0; devc->usbfd[i] != -1; i++)
-        sr_source_remove(devc->usbfd[i]);
-    g_free(devc->usbfd);
+    sr_info("%s: remove the status timer", __func__);
+    sr_source_remove(-1);
+    dsl_stop_events(devc);
 }
 
 static void report_overflow(struct DSL_context *devc)
@@ -1335,9 +1340,6 @@ static void report_overflow(struct DSL_context *devc)
 
 static int receive_data(int fd, int revents, const struct sr_dev_inst *sdi)
 {
-    int completed = 0;
-    struct timeval tv;
-    struct drv_context *drvc;
     struct DSL_context *devc;
     struct sr_usb_dev_inst *usb;
     struct ctl_rd_cmd rd_cmd;
@@ -1347,13 +1349,10 @@ static int receive_data(int fd, int revents, const struct sr_dev_inst *sdi)
     (void)fd;
     (void)revents;
 
-    drvc = di->priv;
     devc = sdi->priv;
     usb = sdi->conn;
 
-    tv.tv_sec = tv.tv_usec = 0;
-    libusb_handle_events_timeout_completed(drvc->sr_ctx->libusb_ctx, &tv, &completed);
-
+    /* A timer tick, the transfers complete on the event thread. */
     if (devc->trf_completed)
         devc->empty_poll_count = 0;
     else
@@ -1384,14 +1383,15 @@ static int receive_data(int fd, int revents, const struct sr_dev_inst *sdi)
             rd_cmd.data = &hw_info;
             if ((ret = command_ctl_rd(usb->devhdl, rd_cmd)) != SR_OK)
                 sr_err("Failed to get hardware infos.");
-            else
-                devc->overflow = (hw_info & bmSYS_OVERFLOW) != 0;
-
-            if (devc->overflow)
-                report_overflow(devc);
+            else if (hw_info & bmSYS_OVERFLOW)
+                devc->overflow = TRUE;
 
             devc->empty_poll_count = 0;
         }
+
+        /* Set by the device, or by a full ingest ring that dropped data. */
+        if (devc->overflow)
+            report_overflow(devc);
     }
 
     if (devc->status == DSL_FINISH) {
@@ -1410,8 +1410,6 @@ static int dev_acquisition_start(struct sr_dev_inst *sdi, void *cb_data)
     struct DSL_context *devc;
     struct sr_usb_dev_inst *usb;
     struct drv_context *drvc;
-    const struct libusb_pollfd **lupfd;
-	unsigned int i;
     int ret;
     struct ctl_wr_cmd wr_cmd;
 
@@ -1485,23 +1483,6 @@ static int dev_acquisition_start(struct sr_dev_inst *sdi, void *cb_data)
         return ret;
     }
 
-    /* setup callback function for data transfer */
-    lupfd = libusb_get_pollfds(drvc->sr_ctx->libusb_ctx);
-    for (i = 0; lupfd[i]; i++);
-
-    if (!(devc->usbfd = g_try_malloc0(sizeof(struct libusb_pollfd) * (i + 1)))){
-        sr_err("%s,ERROR:failed to alloc memory.", __func__);
-    	return SR_ERR;
-    }
-
-    for (i = 0; lupfd[i]; i++) {
-        sr_source_add(lupfd[i]->fd, lupfd[i]->events,
-                  dsl_get_timeout(sdi), receive_data, sdi);
-        devc->usbfd[i] = lupfd[i]->fd;
-    }
-    devc->usbfd[i] = -1;
-    g_free(lupfd);
-
     wr_cmd.header.dest = DSL_CTL_START;
     wr_cmd.header.size = 0;
     if ((ret = command_ctl_wr(usb->devhdl, wr_cmd)) != SR_OK) {
@@ -1515,6 +1496,10 @@ static int dev_acquisition_start(struct sr_dev_inst *sdi, void *cb_data)
     //std_session_send_df_header(cb_data, LOG_PREFIX);
     std_session_send_df_header(sdi, LOG_PREFIX);
 
+    /* The transfers complete on the event thread, the timer only checks the status. */
+    sr_source_add(-1, 0, dsl_get_status_period(sdi), receive_data, sdi);
+    dsl_start_events(sdi, drvc->sr_ctx->libusb_ctx);
+
     return SR_OK;
 }
 
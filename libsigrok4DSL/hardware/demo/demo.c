@@ -161,6 +161,13 @@ static int vdev_init(struct sr_dev_inst *sdi)
 
     vdev->is_loop = FALSE;
     vdev->unit_bits = (sdi->mode == LOGIC) ? 1 : 8;
+
+    vdev->max_throughput = FALSE;
+    vdev->edge_density = THROUGHPUT_DEFAULT_EDGE_DENSITY;
+    vdev->throughput_packet_size = THROUGHPUT_DEFAULT_PACKET_SIZE;
+    vdev->throughput_bytes = 0;
+    vdev->throughput_start = 0;
+    vdev->throughput_rate = 0;
     
     return SR_OK;
 }
@@ -620,6 +627,79 @@ static int init_random_data(struct session_vdev *vdev)
    return SR_OK;
 }
 
+/*
+ * The bytes per channel of a throughput packet: whole rows of 64 samples of
+ * all the channels, as many as fit in packet_size, at least one.
+ */
+SR_PRIV uint64_t demo_throughput_packet_len(int chan_num, uint64_t packet_size)
+{
+    uint64_t row = chan_num * 8;
+    uint64_t rows = packet_size / row;
+
+    if (rows < 1){
+        rows = 1;
+    }
+    return rows * 8;
+}
+
+/*
+ * Fill one packet of cross data for the throughput mode. Each channel
+ * toggles with the probability of the edge density at every sample, so
+ * the run lengths follow a geometric distribution. The packet is built
+ * once and sent again and again.
+ */
+SR_PRIV void demo_throughput_data(uint64_t *words, int chan_num, uint64_t packet_len, gdouble density)
+{
+    uint64_t bits = packet_len * 8;
+    uint64_t pos;
+    uint64_t run;
+    uint64_t n;
+    uint64_t mask;
+    gdouble r;
+    int ch;
+    int level;
+
+    memset(words, 0, chan_num * packet_len);
+    srand((unsigned int)time(NULL));
+
+    for (ch = 0; ch < chan_num; ch++)
+    {
+        level = rand() & 1;
+        pos = 0;
+
+        while (pos < bits)
+        {
+            if (density >= 1){
+                run = 1;
+            }
+            else if (density <= 0){
+                run = bits;
+            }
+            else{
+                r = log((rand() + 1.0) / (RAND_MAX + 1.0)) / log1p(-density);
+                run = (r >= bits) ? bits : 1 + (uint64_t)r;
+            }
+            if (run > bits - pos){
+                run = bits - pos;
+            }
+
+            while (level && run > 0)
+            {
+                n = 64 - pos % 64;
+                if (n > run){
+                    n = run;
+                }
+                mask = (n == 64) ? ~0ULL : ((1ULL << n) - 1) << (pos % 64);
+                words[(pos / 64) * chan_num + ch] |= mask;
+                pos += n;
+                run -= n;
+            }
+            pos += run;
+            level = !level;
+        }
+    }
+}
+
 
 static int hw_init(struct sr_context *sr_ctx)
 {
@@ -925,6 +1005,18 @@ static int config_get(int id, GVariant **data, const struct sr_dev_inst *sdi,
     case SR_CONF_HORIZ_TRIGGERPOS:
         *data = g_variant_new_byte(vdev->trigger_hrate);
         break;
+    case SR_CONF_DEMO_THROUGHPUT:
+        *data = g_variant_new_boolean(vdev->max_throughput);
+        break;
+    case SR_CONF_DEMO_EDGE_DENSITY:
+        *data = g_variant_new_double(vdev->edge_density);
+        break;
+    case SR_CONF_DEMO_PACKET_SIZE:
+        *data = g_variant_new_uint64(vdev->throughput_packet_size);
+        break;
+    case SR_CONF_DEMO_THROUGHPUT_RATE:
+        *data = g_variant_new_double(vdev->throughput_rate);
+        break;
     default:
         return SR_ERR_NA;
     }
@@ -1126,6 +1218,27 @@ static int config_set(int id, GVariant *data, struct sr_dev_inst *sdi,
         vdev->is_loop = g_variant_get_boolean(data);
         sr_info("Set demo loop mode:%d", vdev->is_loop);
         break;
+    case SR_CONF_DEMO_THROUGHPUT:
+        vdev->max_throughput = g_variant_get_boolean(data);
+        sr_info("Set demo throughput mode:%d", vdev->max_throughput);
+        break;
+    case SR_CONF_DEMO_EDGE_DENSITY:
+        vdev->edge_density = g_variant_get_double(data);
+        if(vdev->edge_density < 0){
+            vdev->edge_density = 0;
+        }
+        else if(vdev->edge_density > 1){
+            vdev->edge_density = 1;
+        }
+        sr_dbg("Setting edge density to %f.", vdev->edge_density);
+        break;
+    case SR_CONF_DEMO_PACKET_SIZE:
+        vdev->throughput_packet_size = g_variant_get_uint64(data);
+        if(vdev->throughput_packet_size > THROUGHPUT_MAX_PACKET_SIZE){
+            vdev->throughput_packet_size = THROUGHPUT_MAX_PACKET_SIZE;
+        }
+        sr_dbg("Setting packet size to %llu.", (u64_t)vdev->throughput_packet_size);
+        break;
     case SR_CONF_CHANNEL_MODE:
         nv = g_variant_get_int16(data);
         if(sdi->mode == LOGIC && vdev->sample_generator == PATTERN_RANDOM)
@@ -1341,6 +1454,11 @@ static int hw_dev_acquisition_start(struct sr_dev_inst *sdi,
             vdev->logci_cur_packet_num = 1;
             safe_free(logic_post_buf);
 
+            if(vdev->max_throughput && vdev->enabled_probes > 0){
+                vdev->packet_len = demo_throughput_packet_len(vdev->enabled_probes,
+                                                              vdev->throughput_packet_size);
+            }
+
             logic_post_buf = g_try_malloc0(vdev->enabled_probes * vdev->packet_len);
             if(logic_post_buf == NULL)
             {
@@ -1352,9 +1470,21 @@ static int hw_dev_acquisition_start(struct sr_dev_inst *sdi,
 
             assert(run_time);
 
-            init_random_data(vdev);
-            g_timer_start(run_time);
-            sr_session_source_add(-1, 0, 0, receive_data_logic, sdi);
+            if(vdev->max_throughput)
+            {
+                demo_throughput_data(logic_post_buf, vdev->enabled_probes,
+                                     vdev->packet_len, vdev->edge_density);
+                vdev->throughput_bytes = 0;
+                vdev->throughput_rate = 0;
+                vdev->throughput_start = g_get_monotonic_time();
+                sr_session_source_add(-1, 0, 0, receive_data_throughput, sdi);
+            }
+            else
+            {
+                init_random_data(vdev);
+                g_timer_start(run_time);
+                sr_session_source_add(-1, 0, 0, receive_data_logic, sdi);
+            }
         }
         else{
             sr_session_source_add(-1, 0, 0, receive_data_logic_decoder, sdi);
@@ -1555,6 +1685,84 @@ static int receive_data_logic(int fd, int revents, const struct sr_dev_inst *sdi
     return TRUE;
 }
 
+/*
+ * Send the prepared packet as fast as the session takes it, without the
+ * real time pacing of receive_data_logic(), and report the rate reached.
+ */
+static int receive_data_throughput(int fd, int revents, const struct sr_dev_inst *sdi)
+{
+    assert(sdi);
+    assert(sdi->priv);
+
+    (void)fd;
+
+    struct session_vdev *vdev = sdi->priv;
+    struct sr_datafeed_packet packet;
+    struct sr_datafeed_logic logic;
+    uint64_t samples;
+    gint64 elapsed;
+    int bToEnd;
+
+    bToEnd = 0;
+
+    if (vdev->enabled_probes < 1)
+    {
+        sr_err("%s: channel count < 1.", __func__);
+        return SR_ERR_ARG;
+    }
+
+    if(!vdev->is_loop)
+    {
+        if(vdev->post_data_len >= vdev->total_samples/8){
+            bToEnd = 1;
+        }
+    }
+
+    packet.status = SR_PKT_OK;
+
+    if(!bToEnd && revents != -1)
+    {
+        packet.type = SR_DF_LOGIC;
+        packet.payload = &logic;
+        logic.format = LA_CROSS_DATA;
+        logic.index = 0;
+        logic.order = 0;
+        logic.length = vdev->enabled_probes * vdev->packet_len;
+        logic.data = logic_post_buf;
+
+        if(!vdev->is_loop)
+        {
+            vdev->post_data_len += logic.length / vdev->enabled_probes;
+            if(vdev->post_data_len >= vdev->total_samples/8){
+                get_last_packet_len(&logic,vdev);
+            }
+        }
+
+        ds_data_forward(sdi, &packet);
+        vdev->throughput_bytes += logic.length;
+        vdev->logci_cur_packet_num++;
+    }
+
+    if (bToEnd || revents == -1)
+    {
+        elapsed = g_get_monotonic_time() - vdev->throughput_start;
+        samples = vdev->throughput_bytes / vdev->enabled_probes * 8;
+        if (elapsed > 0){
+            vdev->throughput_rate = samples / (gdouble)elapsed;
+        }
+
+        sr_info("Demo throughput, channels:%d, samples:%llu, %.2f MSa/s, %.2f MB/s",
+            vdev->enabled_probes, (u64_t)samples, vdev->throughput_rate,
+            elapsed > 0 ? vdev->throughput_bytes / (gdouble)elapsed : 0.0);
+
+        packet.type = SR_DF_END;
+        ds_data_forward(sdi, &packet);
+        sr_session_source_remove(-1);
+    }
+
+    return TRUE;
+}
+
 static void free_temp_buffer(struct session_vdev *vdev)
 {   
     struct session_packet_buffer *pack_buf;
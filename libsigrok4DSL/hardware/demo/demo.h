@@ -101,6 +101,11 @@
 #define LOGIC_DEFAULT_TOTAL_SAMPLES SR_MHZ(1)
 #define LOGIC_DEFAULT_NUM_PROBE 16
 
+//throughput mode
+#define THROUGHPUT_DEFAULT_EDGE_DENSITY 0.01
+#define THROUGHPUT_DEFAULT_PACKET_SIZE SR_KB(512)
+#define THROUGHPUT_MAX_PACKET_SIZE SR_MB(16)
+
 #define DSO_DEFAULT_SAMPLERATE SR_MHZ(100)
 #define DSO_DEFAULT_TOTAL_SAMPLES SR_KHZ(10)
 #define DSO_DEFAULT_NUM_PROBE 2
@@ -233,6 +238,14 @@ struct session_vdev
     enum DEMO_LOGIC_CHANNEL_INDEX logic_ch_mode_index;
 
     int is_loop;
+
+    //throughput
+    gboolean max_throughput;
+    gdouble edge_density;
+    uint64_t throughput_packet_size;
+    uint64_t throughput_bytes;
+    gint64 throughput_start;
+    gdouble throughput_rate;
 };
 
 #define SESSION_MAX_CHANNEL_COUNT 512
@@ -367,6 +380,9 @@ static const char *probeMapUnits[] = {
 static const int hwoptions[] = {
     SR_CONF_PATTERN_MODE,
     SR_CONF_MAX_HEIGHT,
+    SR_CONF_DEMO_THROUGHPUT,
+    SR_CONF_DEMO_EDGE_DENSITY,
+    SR_CONF_DEMO_PACKET_SIZE,
 };
 
 static const int32_t sessions[] = {
@@ -374,6 +390,9 @@ static const int32_t sessions[] = {
     SR_CONF_LIMIT_SAMPLES,
     SR_CONF_PATTERN_MODE,
     SR_CONF_MAX_HEIGHT,
+    SR_CONF_DEMO_THROUGHPUT,
+    SR_CONF_DEMO_EDGE_DENSITY,
+    SR_CONF_DEMO_PACKET_SIZE,
 };
 
 static const int32_t probeOptions[] = {
@@ -493,6 +512,8 @@ static int receive_data_logic(int fd, int revents, const struct sr_dev_inst *sdi
 
 static int receive_data_logic_decoder(int fd, int revents, const struct sr_dev_inst *sdi);
 
+static int receive_data_throughput(int fd, int revents, const struct sr_dev_inst *sdi);
+
 static int receive_data_dso(int fd, int revents, const struct sr_dev_inst *sdi);
 
 static int receive_data_analog(int fd, int revents, const struct sr_dev_inst *sdi);
@@ -82,6 +82,11 @@ static struct sr_config_info sr_config_info_data[] = {
     {SR_CONF_PROBE_MAP_UNIT, SR_T_CHAR,"Map Unit"},
     {SR_CONF_PROBE_MAP_MIN, SR_T_FLOAT,"Map Min"},
     {SR_CONF_PROBE_MAP_MAX, SR_T_FLOAT,"Map Max"},
+    {SR_CONF_DEMO_THROUGHPUT, SR_T_BOOL,"Max Throughput"},
+    {SR_CONF_DEMO_EDGE_DENSITY, SR_T_FLOAT,"Edge Density"},
+    {SR_CONF_DEMO_PACKET_SIZE, SR_T_UINT64,"Packet Size"},
+    {SR_CONF_DEMO_THROUGHPUT_RATE, SR_T_FLOAT,"Throughput Rate"},
+    {SR_CONF_ADAPTIVE_TRANSFER, SR_T_BOOL,"Adaptive Transfers"},
     {0, 0, NULL},
 };
 
@@ -401,6 +401,12 @@ SR_PRIV int sr_session_destroy(void);
  */
 SR_PRIV int sr_new_virtual_device(const char *filename, struct sr_dev_inst **out_di);
 
+/**
+ * Read a SR_SESSION_CONST_BLOCK_ID record from a zip entry's global extra field.
+ */
+SR_PRIV int sr_session_get_const_block(const unsigned char *extra, uint64_t extra_len,
+                                       uint64_t *block_len, uint8_t *level);
+
 
 /*--- lib_main.c -------------------------------------------------*/
 /**
@@ -453,5 +459,9 @@ SR_PRIV int sr_dslogic_option_value_to_code(const struct sr_dev_inst *sdi, int c
 
 /*--- dscope.c ------------------------------------------------------------*/
 SR_PRIV int sr_dscope_option_value_to_code(const struct sr_dev_inst *sdi, int config_id, const char *value);
+
+/*--- demo.c ------------------------------------------------------------*/
+SR_PRIV uint64_t demo_throughput_packet_len(int chan_num, uint64_t packet_size);
+SR_PRIV void demo_throughput_data(uint64_t *words, int chan_num, uint64_t packet_len, gdouble density);
  
 #endif
@@ -105,6 +105,23 @@ enum {
 
 #define SAMPLES_ALIGN 1023ULL
 
+/*
+ * A session file logic block with one level is stored as an empty zip entry.
+ * Its global extra field has this id, followed by the little endian
+ * uint64 block length in bytes and one byte of the level (0x00 or 0xff).
+ */
+#define SR_SESSION_CONST_BLOCK_ID   0x4C44
+#define SR_SESSION_CONST_BLOCK_LEN  9
+
+/*
+ * A session file logic block saved with its mipmap is a stored (uncompressed)
+ * zip entry holding the whole leaf block of the snapshot, samples first.
+ * Its global extra field has this id, followed by the little endian uint64
+ * length of the sample data in bytes, the scale power and the scale level.
+ */
+#define SR_SESSION_LEAF_BLOCK_ID    0x4D44
+#define SR_SESSION_LEAF_BLOCK_LEN   10
+
 #define STR_ID(id) #id
 
 /* Handy little macros */
@@ -202,6 +219,8 @@ enum sr_datafeed_packet_type {
 	SR_DF_FRAME_BEGIN,
 	SR_DF_FRAME_END,
     SR_DF_OVERFLOW,
+    SR_DF_LOGIC_EDGE,
+    SR_DF_LOGIC_BLOCK,
 };
 
 /** Values for sr_datafeed_analog.mq. */
@@ -394,6 +413,40 @@ struct sr_datafeed_logic {
 	void *data;
 };
 
+/** Logic value changes, sorted by sample. */
+struct sr_datafeed_logic_edge {
+    /** number of changes in this packet */
+    uint64_t count;
+    /** sample of each change, relative to the first exported sample */
+    const uint64_t *samples;
+    /** channel position of each change, as the bit index in a cross unit */
+    const uint16_t *channels;
+    /** new level of each change */
+    const uint8_t *levels;
+    /** samples covered once this packet is consumed */
+    uint64_t length;
+};
+
+/** One leaf block of a channel, read from a session file without decoding. */
+struct sr_datafeed_logic_block {
+    /** channel order in the file */
+    uint16_t order;
+    /** leaf block index */
+    uint64_t index;
+    /** valid sample data in bytes */
+    uint64_t data_len;
+    /** bytes at data, the samples followed by the mipmap levels, 0 if constant */
+    uint64_t size;
+    /** level of a constant block */
+    uint8_t level;
+    /** scale power and scale level of the saved mipmap */
+    uint8_t scale_power;
+    uint8_t scale_level;
+    /** points into file, take a reference of file to keep it */
+    const void *data;
+    GMappedFile *file;
+};
+
 struct sr_datafeed_dso {
     /** The probes for which data is included in this packet. */
     GSList *probes;
@@ -1048,6 +1101,45 @@ enum sr_config_option_id
 
     SR_CONF_DEMO_CHANGE = 30107,
 
+    /** The most logic buffers waiting for the ingest thread. */
+    SR_CONF_INGEST_HIGH_WATER = 30108,
+
+    /**
+     * The logic buffers that found the ingest ring full. A stream drops them
+     * and reports an overflow, a buffered capture forwards them on the USB thread.
+     */
+    SR_CONF_INGEST_STALLS = 30109,
+
+    /** Adapt the streaming transfer size and count during a capture, off by default. */
+    SR_CONF_ADAPTIVE_TRANSFER = 30110,
+
+    /** The transfer length in use, in bytes. */
+    SR_CONF_TRANSFER_SIZE = 30111,
+
+    /** The data transfers in flight. */
+    SR_CONF_TRANSFER_COUNT = 30112,
+
+    /**
+     * The lowest completion headroom seen, the completion latency over the
+     * time the queued transfers take to fill. Near 0 the host fell behind.
+     */
+    SR_CONF_TRANSFER_HEADROOM = 30113,
+
+    /** The share of the ingest thread time spent forwarding data. */
+    SR_CONF_INGEST_LOAD = 30114,
+
+    /** Demo logic captures are sent as fast as the session accepts them. */
+    SR_CONF_DEMO_THROUGHPUT = 30115,
+
+    /** The share of samples where a demo throughput channel toggles. */
+    SR_CONF_DEMO_EDGE_DENSITY = 30116,
+
+    /** The demo throughput packet length, in bytes of cross data. */
+    SR_CONF_DEMO_PACKET_SIZE = 30117,
+
+    /** The samples per channel the last demo throughput capture sent, in MSa/s. */
+    SR_CONF_DEMO_THROUGHPUT_RATE = 30118,
+
 	/*--- Acquisition modes ---------------------------------------------*/
 
 	/**
@@ -176,10 +176,12 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 {
 	const struct sr_datafeed_meta *meta;
 	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_logic_edge *edge;
 	const struct sr_config *src;
 	GSList *l;
 	struct context *ctx;
 	unsigned int i;
+	uint64_t k;
 	int p, curbit, prevbit, index;
 	uint8_t *sample;
 	gboolean timestamp_written;
@@ -256,6 +258,36 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 			memcpy(ctx->prevsample, sample, logic->unitsize);
 		}
 		break;
+	case SR_DF_LOGIC_EDGE:
+		/* The changes are already extracted, no per sample scan. */
+		edge = packet->payload;
+
+		if (!ctx->header_done) {
+			*out = gen_header(o);
+			ctx->header_done = TRUE;
+		} else {
+			*out = g_string_sized_new(512);
+		}
+
+		for (k = 0; k < edge->count; k++) {
+			if (k == 0 || edge->samples[k] != edge->samples[k - 1]) {
+				if (k > 0)
+					g_string_append_c(*out, '\n');
+				g_string_append_printf(*out, "#%.0f",
+					(double)edge->samples[k] /
+						ctx->samplerate * ctx->period);
+			}
+
+			g_string_append_c(*out, ' ');
+			g_string_append_c(*out, '0' + (edge->levels[k] & 1));
+			g_string_append_c(*out, '!' + edge->channels[k]);
+		}
+
+		if (edge->count > 0)
+			g_string_append_c(*out, '\n');
+
+		ctx->samplecount = edge->length;
+		break;
 	case SR_DF_END:
 		/* Write final timestamp as length indicator. */
 		*out = g_string_sized_new(512);
@@ -144,6 +144,7 @@ SR_PRIV int sr_session_destroy(void)
 static int sr_session_iteration(gboolean block)
 {
 	unsigned int i;
+	unsigned int nfds;
 	int ret;
 
 	if (session == NULL){
@@ -151,7 +152,12 @@ static int sr_session_iteration(gboolean block)
 		return SR_ERR_CALL_STATUS;
 	}
 
-	ret = g_poll(session->pollfds, session->num_sources,
+	/* A lone timer source has no descriptor, g_poll() only sleeps. */
+	nfds = session->num_sources;
+	if (nfds == 1 && session->pollfds[0].fd == -1)
+		nfds = 0;
+
+	ret = g_poll(nfds ? session->pollfds : NULL, nfds,
 			block ? session->source_timeout : 0);
 	for (i = 0; i < session->num_sources; i++) {
 		if (session->pollfds[i].revents > 0 || (ret == 0
@@ -206,8 +212,9 @@ SR_PRIV int sr_session_run(void)
 
 	sr_dbg("Running...");
 
-	/* Do we have real sources? */
-	if (session->num_sources == 1 && session->pollfds[0].fd == -1) {
+	/* Do we have real sources? A dummy source with a timeout is a timer. */
+	if (session->num_sources == 1 && session->pollfds[0].fd == -1
+		&& session->sources[0].timeout <= 0) {
 		/* Dummy source, freewheel over it. */
         while (session->num_sources) {
             if (session->abort_session) {
@@ -400,6 +407,7 @@ SR_PRIV int sr_session_source_add(int fd, int events, int timeout,
 
 	p.fd = fd;
 	p.events = events;
+	p.revents = 0;
 
     return _sr_session_source_add(&p, timeout, cb, sdi, (gintptr)fd);
 }
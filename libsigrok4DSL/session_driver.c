@@ -25,6 +25,7 @@
 #include <sys/time.h>
 #include <assert.h>
 #include <string.h>
+#include <stdio.h>
 #include <minizip/unzip.h>
 #include "log.h"
 
@@ -39,6 +40,11 @@
 #define UNITLEN 64
 /** @endcond */
 
+/* The newest 'header' format version this driver reads.
+ * 4: a constant logic block is an empty entry, see SR_SESSION_CONST_BLOCK_ID.
+ */
+#define SESSION_MAX_FILE_VERSION 4
+
 extern struct sr_session *session;
 extern SR_PRIV struct sr_dev_driver session_driver;
 
@@ -97,6 +103,7 @@ static void get_file_short_name(const char *file, char *buf, int buflen)
 }
 
 struct session_packet_buffer;
+struct session_leaf_entry;
 
 struct session_vdev
 { 
@@ -124,10 +131,30 @@ struct session_vdev
     uint8_t max_height;
     struct sr_status mstatus;
     struct session_packet_buffer   *packet_buffer;
+    int leaf_mode; // logic blocks are saved with the mipmap, no replay
+    GMappedFile *mapped_file;
+    struct session_leaf_entry *leaf_entries;
 };
 
 #define SESSION_MAX_CHANNEL_COUNT 512
 
+enum {
+    LEAF_ENTRY_NONE = 0,
+    LEAF_ENTRY_DATA,
+    LEAF_ENTRY_CONST,
+};
+
+struct session_leaf_entry
+{
+    int         kind;
+    uint64_t    offset; // data position in the file
+    uint64_t    size;
+    uint64_t    data_len;
+    uint8_t     level;
+    uint8_t     scale_power;
+    uint8_t     scale_level;
+};
+
 struct session_packet_buffer
 {
     void       *post_buf;
@@ -413,6 +440,283 @@ static int receive_data(int fd, int revents, const struct sr_dev_inst *sdi)
     return TRUE;
 }
 
+/*
+ * Find the constant block record in a zip entry's global extra field.
+ * Returns 1 and fills the block length and level if it is present.
+ */
+SR_PRIV int sr_session_get_const_block(const unsigned char *extra, uint64_t extra_len,
+                                       uint64_t *block_len, uint8_t *level)
+{
+    uint64_t pos = 0;
+    uint16_t id, len;
+    int i;
+
+    while (pos + 4 <= extra_len)
+    {
+        id = extra[pos] | (extra[pos + 1] << 8);
+        len = extra[pos + 2] | (extra[pos + 3] << 8);
+        pos += 4;
+
+        if (pos + len > extra_len)
+            break;
+
+        if (id == SR_SESSION_CONST_BLOCK_ID && len == SR_SESSION_CONST_BLOCK_LEN){
+            *block_len = 0;
+            for (i = 7; i >= 0; i--)
+                *block_len = (*block_len << 8) | extra[pos + i];
+            *level = extra[pos + 8];
+            return 1;
+        }
+        pos += len;
+    }
+
+    return 0;
+}
+
+/*
+ * Find the leaf block record in a zip entry's global extra field.
+ * Returns 1 and fills the sample data length and mipmap layout if it is present.
+ */
+static int get_leaf_block(const unsigned char *extra, uint64_t extra_len, uint64_t *data_len,
+                          uint8_t *scale_power, uint8_t *scale_level)
+{
+    uint64_t pos = 0;
+    uint16_t id, len;
+    int i;
+
+    while (pos + 4 <= extra_len)
+    {
+        id = extra[pos] | (extra[pos + 1] << 8);
+        len = extra[pos + 2] | (extra[pos + 3] << 8);
+        pos += 4;
+
+        if (pos + len > extra_len)
+            break;
+
+        if (id == SR_SESSION_LEAF_BLOCK_ID && len == SR_SESSION_LEAF_BLOCK_LEN){
+            *data_len = 0;
+            for (i = 7; i >= 0; i--)
+                *data_len = (*data_len << 8) | extra[pos + i];
+            *scale_power = extra[pos + 8];
+            *scale_level = extra[pos + 9];
+            return 1;
+        }
+        pos += len;
+    }
+
+    return 0;
+}
+
+/*
+ * Check whether the logic blocks of the archive are saved with the mipmap.
+ * The first logic block entry decides it, all blocks of a file share the format.
+ */
+static int is_leaf_archive(unzFile archive)
+{
+    unz_file_info64 fileInfo;
+    char szFilePath[32];
+    unsigned char extra_field[64];
+    uint64_t data_len;
+    uint8_t scale_power, scale_level;
+    int ret;
+
+    for (ret = unzGoToFirstFile(archive); ret == UNZ_OK; ret = unzGoToNextFile(archive))
+    {
+        if (unzGetCurrentFileInfo64(archive, &fileInfo, szFilePath, sizeof(szFilePath),
+                                    extra_field, sizeof(extra_field), NULL, 0) != UNZ_OK)
+            return 0;
+
+        if (strncmp(szFilePath, "L-", 2) != 0)
+            continue;
+
+        return get_leaf_block(extra_field, MIN(fileInfo.size_file_extra, sizeof(extra_field)),
+                              &data_len, &scale_power, &scale_level);
+    }
+
+    return 0;
+}
+
+/*
+ * Index the logic block entries of the archive by channel and block,
+ * the channel order follows the ascending directory number as the replay does.
+ */
+static int load_leaf_entries(struct session_vdev *vdev)
+{
+    unz_file_info64 fileInfo;
+    char szFilePath[32];
+    unsigned char extra_field[64];
+    struct session_leaf_entry *entry;
+    int dir_rank[SESSION_MAX_CHANNEL_COUNT];
+    int dir, blk, ch_index, ret;
+    uint64_t extra_len;
+
+    for (dir = 0; dir < SESSION_MAX_CHANNEL_COUNT; dir++)
+        dir_rank[dir] = -1;
+
+    // Find the channel directories.
+    for (ret = unzGoToFirstFile(vdev->archive); ret == UNZ_OK; ret = unzGoToNextFile(vdev->archive))
+    {
+        if (unzGetCurrentFileInfo64(vdev->archive, &fileInfo, szFilePath, sizeof(szFilePath),
+                                    NULL, 0, NULL, 0) != UNZ_OK)
+            return SR_ERR;
+
+        if (sscanf(szFilePath, "L-%d/%d", &dir, &blk) == 2
+            && dir >= 0 && dir < SESSION_MAX_CHANNEL_COUNT)
+            dir_rank[dir] = 0;
+    }
+
+    ch_index = 0;
+    for (dir = 0; dir < SESSION_MAX_CHANNEL_COUNT; dir++){
+        if (dir_rank[dir] == 0)
+            dir_rank[dir] = ch_index++;
+    }
+
+    if (ch_index < vdev->num_probes){
+        sr_err("%s: logic block directories are missing.", __func__);
+        return SR_ERR;
+    }
+
+    vdev->leaf_entries = g_try_malloc0(sizeof(struct session_leaf_entry)
+                                        * vdev->num_probes * vdev->num_blocks);
+    if (vdev->leaf_entries == NULL){
+        sr_err("%s: leaf entry table malloc failed", __func__);
+        return SR_ERR_MALLOC;
+    }
+
+    for (ret = unzGoToFirstFile(vdev->archive); ret == UNZ_OK; ret = unzGoToNextFile(vdev->archive))
+    {
+        if (unzGetCurrentFileInfo64(vdev->archive, &fileInfo, szFilePath, sizeof(szFilePath),
+                                    extra_field, sizeof(extra_field), NULL, 0) != UNZ_OK)
+            return SR_ERR;
+
+        if (sscanf(szFilePath, "L-%d/%d", &dir, &blk) != 2
+            || dir < 0 || dir >= SESSION_MAX_CHANNEL_COUNT
+            || dir_rank[dir] >= vdev->num_probes
+            || blk < 0 || blk >= vdev->num_blocks)
+            continue;
+
+        entry = &vdev->leaf_entries[dir_rank[dir] * vdev->num_blocks + blk];
+        extra_len = MIN(fileInfo.size_file_extra, sizeof(extra_field));
+
+        if (sr_session_get_const_block(extra_field, extra_len, &entry->data_len, &entry->level)){
+            entry->kind = LEAF_ENTRY_CONST;
+        }
+        else if (fileInfo.compression_method == 0
+                && get_leaf_block(extra_field, extra_len, &entry->data_len,
+                                  &entry->scale_power, &entry->scale_level)){
+            // The data offset is known once the local header is read.
+            if (unzOpenCurrentFile(vdev->archive) != UNZ_OK)
+                return SR_ERR;
+            entry->offset = unzGetCurrentFileZStreamPos64(vdev->archive);
+            entry->size = fileInfo.uncompressed_size;
+            unzCloseCurrentFile(vdev->archive);
+
+            if (entry->offset + entry->size > g_mapped_file_get_length(vdev->mapped_file)){
+                sr_err("%s: block is out of file:\"%s\"", __func__, szFilePath);
+                return SR_ERR;
+            }
+            entry->kind = LEAF_ENTRY_DATA;
+        }
+        else{
+            sr_err("%s: block is not saved with mipmap:\"%s\"", __func__, szFilePath);
+            return SR_ERR;
+        }
+    }
+
+    return SR_OK;
+}
+
+static int receive_data_logic_blocks(int fd, int revents, const struct sr_dev_inst *sdi)
+{
+    struct session_vdev *vdev = NULL;
+    struct sr_datafeed_packet packet;
+    struct sr_datafeed_logic_block block;
+    struct session_leaf_entry *entry;
+    const char *contents;
+    GError *error = NULL;
+    int ch_index;
+
+    assert(sdi);
+    assert(sdi->priv);
+    (void)fd;
+
+    vdev = sdi->priv;
+    packet.status = SR_PKT_OK;
+
+    if (vdev->leaf_entries == NULL)
+    {
+        vdev->cur_block = 0;
+        vdev->mapped_file = g_mapped_file_new(sdi->path, FALSE, &error);
+
+        if (vdev->mapped_file == NULL){
+            sr_err("%s: failed to map file, %s", __func__, error ? error->message : "");
+            if (error)
+                g_error_free(error);
+            send_error_packet(sdi, vdev, &packet);
+            free_temp_buffer(vdev);
+            return FALSE;
+        }
+
+        if (load_leaf_entries(vdev) != SR_OK){
+            send_error_packet(sdi, vdev, &packet);
+            free_temp_buffer(vdev);
+            return FALSE;
+        }
+    }
+
+    contents = g_mapped_file_get_contents(vdev->mapped_file);
+
+    // One block index of all channels each time.
+    if (vdev->cur_block < vdev->num_blocks && revents != -1)
+    {
+        for (ch_index = 0; ch_index < vdev->num_probes; ch_index++)
+        {
+            entry = &vdev->leaf_entries[ch_index * vdev->num_blocks + vdev->cur_block];
+
+            if (entry->kind == LEAF_ENTRY_NONE){
+                sr_err("%s: can't locate block %d of channel %d", __func__,
+                        vdev->cur_block, ch_index);
+                send_error_packet(sdi, vdev, &packet);
+                free_temp_buffer(vdev);
+                return FALSE;
+            }
+
+            block.order = ch_index;
+            block.index = vdev->cur_block;
+            block.data_len = entry->data_len;
+            block.level = entry->level;
+            block.scale_power = entry->scale_power;
+            block.scale_level = entry->scale_level;
+            block.file = vdev->mapped_file;
+
+            if (entry->kind == LEAF_ENTRY_DATA){
+                block.size = entry->size;
+                block.data = contents + entry->offset;
+            }
+            else{
+                block.size = 0;
+                block.data = NULL;
+            }
+
+            packet.type = SR_DF_LOGIC_BLOCK;
+            packet.payload = &block;
+            ds_data_forward(sdi, &packet);
+        }
+        vdev->cur_block++;
+    }
+
+    if (vdev->cur_block >= vdev->num_blocks || revents == -1)
+    {
+        packet.type = SR_DF_END;
+        ds_data_forward(sdi, &packet);
+        sr_session_source_remove(-1);
+        close_archive(vdev);
+        free_temp_buffer(vdev);
+    }
+
+    return TRUE;
+}
+
 static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_inst *sdi)
 {
     struct session_vdev *vdev = NULL;
@@ -426,6 +730,10 @@ static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_in
     struct session_packet_buffer *pack_buffer;
     unz_file_info64 fileInfo;
     char szFilePath[15];
+    unsigned char extra_field[64];
+    uint64_t entry_len;
+    uint8_t const_level;
+    int is_const;
     int bToEnd;
     int read_chan_index; 
     int chan_num;
@@ -551,16 +859,21 @@ static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_in
                 }
 
                 if (unzGetCurrentFileInfo64(vdev->archive, &fileInfo, szFilePath,
-                                    sizeof(szFilePath), NULL, 0, NULL, 0) != UNZ_OK)
+                                    sizeof(szFilePath), extra_field, sizeof(extra_field), NULL, 0) != UNZ_OK)
                 { 
                     sr_err("%s: unzGetCurrentFileInfo64 error.", __func__);
                     send_error_packet(sdi, vdev, &packet);
                     return FALSE;
                 }
 
+                entry_len = fileInfo.uncompressed_size;
+                is_const = sr_session_get_const_block(extra_field,
+                                MIN(fileInfo.size_file_extra, sizeof(extra_field)),
+                                &entry_len, &const_level);
+
                 if (ch_index == 0){  
                     // Alloc the buffer for each channel to read block file data.
-                    pack_buffer->block_data_len = fileInfo.uncompressed_size;
+                    pack_buffer->block_data_len = entry_len;
                     
                     if (pack_buffer->block_data_len > pack_buffer->block_buf_len)
                     {
@@ -584,13 +897,19 @@ static int receive_data_logic_dso_v2(int fd, int revents, const struct sr_dev_in
                 }
                 else
                 {
-                    if (pack_buffer->block_data_len != fileInfo.uncompressed_size){
+                    if (pack_buffer->block_data_len != entry_len){
                         sr_err("The block size is not coincident:%s", file_name);
                         send_error_packet(sdi, vdev, &packet);
                         return FALSE;
                     }
                 }
 
+                // The block has one level, no data stored.
+                if (is_const){
+                    memset(pack_buffer->block_bufs[ch_index], const_level, entry_len);
+                    continue;
+                }
+
                 // Read the data to buffer. 
                 if (unzOpenCurrentFile(vdev->archive) != UNZ_OK)
                 {
@@ -806,6 +1125,13 @@ static void free_temp_buffer(struct session_vdev *vdev)
     safe_free(vdev->packet_buffer);    
     safe_free(vdev->buf);
     safe_free(vdev->logic_buf);
+    safe_free(vdev->leaf_entries);
+
+    // The receiver keeps its own reference of the mapped blocks.
+    if (vdev->mapped_file != NULL){
+        g_mapped_file_unref(vdev->mapped_file);
+        vdev->mapped_file = NULL;
+    }
 }
 
 static int dev_close(struct sr_dev_inst *sdi)
@@ -1447,8 +1773,14 @@ static int dev_acquisition_start(struct sr_dev_inst *sdi, void *cb_data)
         ds_data_forward(sdi, &packet);
     }
 
+    vdev->leaf_mode = (sdi->mode == LOGIC && vdev->version > 1
+                        && is_leaf_archive(vdev->archive));
+
     /* freewheeling source */
-    if ((sdi->mode == LOGIC && vdev->version > 1) 
+    if (vdev->leaf_mode){
+        sr_session_source_add(-1, 0, 0, receive_data_logic_blocks, sdi);
+    }
+    else if ((sdi->mode == LOGIC && vdev->version > 1) 
             || (sdi->mode == DSO && vdev->version > 2)){
         sr_session_source_add(-1, 0, 0, receive_data_logic_dso_v2, sdi);
     }
@@ -1667,6 +1999,17 @@ static int sr_load_virtual_device_session(struct sr_dev_inst *sdi)
                 {
                     version = strtoull(val, NULL, 10);
                     sr_info("The 'header' file format version:%d", version);
+
+                    if (version > SESSION_MAX_FILE_VERSION)
+                    {
+                        sr_err("%s: The file format version %d is not supported, the newest is %d.",
+                               __func__, version, SESSION_MAX_FILE_VERSION);
+                        g_strfreev(keys);
+                        g_strfreev(sections);
+                        g_key_file_free(kf);
+                        g_free(metafile);
+                        return SR_ERR;
+                    }
                 }
             }
         }
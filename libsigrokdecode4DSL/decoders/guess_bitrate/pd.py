@@ -39,8 +39,8 @@ class Decoder(srd.Decoder):
         ('bitrate', 'Bitrate / baudrate'),
     )
 
-    def putx(self, data):
-        self.put(self.ss_edge, self.samplenum, self.out_ann, data)
+    def putx(self, es, data):
+        self.put(self.ss_edge, es, self.out_ann, data)
 
     def __init__(self):
         self.reset()
@@ -67,13 +67,16 @@ class Decoder(srd.Decoder):
         # distance between any two transitions, assuming it corresponds
         # to one bit time of the respective bitrate of the input stream.
         # This heuristics keeps getting better for longer captures.
+        # The edges come in bulk, records of (samplenum, pins, matched).
         bitwidth = None
         while True:
-            self.wait({0: 'e'})
+            records = memoryview(self.wait_bulk({0: 'e'})).cast('Q')
 
-            b = self.samplenum - self.ss_edge
-            if bitwidth is None or b < bitwidth:
-                bitwidth = b
-                bitrate = int(float(self.samplerate) / float(b))
-                self.putx([0, ['%d' % bitrate]])
-            self.ss_edge = self.samplenum
+            for i in range(0, len(records), 3):
+                samplenum = records[i]
+                b = samplenum - self.ss_edge
+                if bitwidth is None or b < bitwidth:
+                    bitwidth = b
+                    bitrate = int(float(self.samplerate) / float(b))
+                    self.putx(samplenum, [0, ['%d' % bitrate]])
+                self.ss_edge = samplenum
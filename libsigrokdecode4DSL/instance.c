@@ -26,6 +26,7 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <assert.h>
 #include "log.h"
 
@@ -388,6 +389,7 @@ SRD_API struct srd_decoder_inst *srd_inst_new(struct srd_session *sess,
 	 * order in which the decoder class defined them.
 	 */
     di->py_pinvalues = NULL;
+    di->py_pinvalues_spare = NULL;
 	di->dec_num_channels = g_slist_length(di->decoder->channels) +
 			g_slist_length(di->decoder->opt_channels);
 			
@@ -406,6 +408,12 @@ SRD_API struct srd_decoder_inst *srd_inst_new(struct srd_session *sess,
         di->py_pinvalues = PyTuple_New(di->dec_num_channels);
 	}
 
+	di->py_pin_ints[0] = PyLong_FromLong(0);
+	di->py_pin_ints[1] = PyLong_FromLong(1);
+	di->py_pin_ints[2] = PyLong_FromLong(0xff);
+	di->py_attr_samplenum = PyUnicode_InternFromString("samplenum");
+	di->py_attr_matched = PyUnicode_InternFromString("matched");
+
 	/* Default to the initial pins being the same as in sample 0. */
 	oldpins_array_seed(di);
 
@@ -935,6 +943,216 @@ static gboolean all_terms_match(struct srd_decoder_inst *di,
 	return TRUE;
 }
 
+/**
+ * Load up to 8 bytes of packed samples into a word, first sample in bit 0.
+ *
+ * @private
+ */
+static inline uint64_t sample_word_load(const uint8_t *ptr, uint64_t nbytes)
+{
+	uint64_t word = 0;
+	uint64_t i;
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	if (nbytes >= 8) {
+		memcpy(&word, ptr, sizeof(word));
+		return word;
+	}
+#endif
+	nbytes = MIN(nbytes, 8);
+	for (i = 0; i < nbytes; i++)
+		word |= (uint64_t)ptr[i] << (8 * i);
+
+	return word;
+}
+
+/**
+ * Get 64 consecutive samples of one channel, starting at the relative
+ * sample number word_index * 64. Constant channels expand to all-0/all-1.
+ *
+ * @private
+ */
+static inline uint64_t channel_word(const struct srd_decoder_inst *di,
+		int ch, uint64_t word_index, uint64_t buf_bytes)
+{
+	const uint8_t *buf = *(di->inbuf + ch);
+	uint64_t pos;
+
+	if (buf == NULL)
+		return *(di->inbuf_const + ch) ? ~0ULL : 0ULL;
+
+	pos = word_index * 8;
+	return sample_word_load(buf + pos, buf_bytes - pos);
+}
+
+/**
+ * Get the sample value of one channel at a relative sample number.
+ *
+ * @private
+ */
+static inline uint64_t channel_bit(const struct srd_decoder_inst *di,
+		int ch, uint64_t rel_samplenum)
+{
+	const uint8_t *buf = *(di->inbuf + ch);
+
+	if (buf == NULL)
+		return *(di->inbuf_const + ch) ? 1 : 0;
+
+	return (*(buf + rel_samplenum / 8) >> (rel_samplenum % 8)) & 1;
+}
+
+/**
+ * Check whether the current condition list can be scanned word-wise.
+ *
+ * Conditions may combine any number of level/edge terms. A skip term
+ * is only supported as the single term of its condition, since its
+ * counter otherwise depends on the evaluation order of the other terms.
+ *
+ * @private
+ */
+static gboolean word_scan_allowed(const struct srd_decoder_inst *di)
+{
+	const GSList *l, *t;
+	const GSList *cond;
+	const struct srd_term *term;
+
+	for (l = di->condition_list; l; l = l->next) {
+		cond = l->data;
+		if (!cond)
+			continue;
+
+		for (t = cond; t; t = t->next) {
+			term = t->data;
+			if (term->type == SRD_TERM_SKIP) {
+				if (cond->next)
+					return FALSE;
+			} else if (term->type < SRD_TERM_HIGH
+					|| term->type > SRD_TERM_NO_EDGE
+					|| term->channel < 0
+					|| term->channel >= di->dec_num_channels) {
+				return FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Move di->abs_cur_samplenum forward to the next sample which may
+ * satisfy one of the conditions.
+ *
+ * The samples are processed 64 at a time: level terms are masks of the
+ * sample words, edge terms compare a word with a copy shifted by one
+ * sample. The first sample that satisfies all terms of any condition is
+ * left to the per-sample code in find_match(), so match results, the
+ * old pin values and the skip counters end up exactly as if every
+ * sample had been checked one by one.
+ *
+ * The caller must have checked the sample before di->abs_cur_samplenum
+ * within the current chunk, and word_scan_allowed() must be TRUE.
+ *
+ * @private
+ */
+static void skip_to_candidate(struct srd_decoder_inst *di)
+{
+	const GSList *l, *t;
+	const GSList *cond;
+	struct srd_term *term;
+	uint64_t cur, limit, hit, buf_bytes;
+	uint64_t w, base, valid, hits, cond_mask;
+	uint64_t x, p, remain;
+
+	cur = di->abs_cur_samplenum - di->abs_start_samplenum;
+	limit = di->abs_end_samplenum - di->abs_start_samplenum;
+	buf_bytes = (limit + 7) / 8;
+
+	/* A skip condition matches at a known sample, never scan beyond it. */
+	for (l = di->condition_list; l; l = l->next) {
+		cond = l->data;
+		if (!cond || ((struct srd_term *)cond->data)->type != SRD_TERM_SKIP)
+			continue;
+		term = cond->data;
+		remain = 0;
+		if (term->num_samples_to_skip > term->num_samples_already_skipped)
+			remain = term->num_samples_to_skip - term->num_samples_already_skipped;
+		limit = MIN(limit, cur + remain);
+	}
+
+	hit = limit;
+
+	for (w = cur / 64; w * 64 < limit; w++) {
+		base = w * 64;
+		valid = (cur > base) ? ~0ULL << (cur - base) : ~0ULL;
+		if (limit - base < 64)
+			valid &= ~(~0ULL << (limit - base));
+
+		hits = 0;
+
+		for (l = di->condition_list; l; l = l->next) {
+			cond = l->data;
+			if (!cond || ((struct srd_term *)cond->data)->type == SRD_TERM_SKIP)
+				continue;
+
+			cond_mask = valid;
+
+			for (t = cond; t && cond_mask; t = t->next) {
+				term = t->data;
+				x = channel_word(di, term->channel, w, buf_bytes);
+				p = x << 1;
+				if (base > 0)
+					p |= channel_bit(di, term->channel, base - 1);
+
+				switch (term->type) {
+				case SRD_TERM_HIGH:
+					cond_mask &= x;
+					break;
+				case SRD_TERM_LOW:
+					cond_mask &= ~x;
+					break;
+				case SRD_TERM_RISING_EDGE:
+					cond_mask &= x & ~p;
+					break;
+				case SRD_TERM_FALLING_EDGE:
+					cond_mask &= ~x & p;
+					break;
+				case SRD_TERM_EITHER_EDGE:
+					cond_mask &= x ^ p;
+					break;
+				case SRD_TERM_NO_EDGE:
+					cond_mask &= ~(x ^ p);
+					break;
+				}
+			}
+
+			hits |= cond_mask;
+		}
+
+		if (hits) {
+			hit = base + __builtin_ctzll(hits);
+			break;
+		}
+	}
+
+	if (hit <= cur)
+		return;
+
+	/* The passed over samples count for the pending skip terms. */
+	for (l = di->condition_list; l; l = l->next) {
+		cond = l->data;
+		if (cond && ((struct srd_term *)cond->data)->type == SRD_TERM_SKIP) {
+			term = cond->data;
+			term->num_samples_already_skipped += hit - cur;
+		}
+	}
+
+	/* Old pins are the values of the last skipped sample. */
+	di->abs_cur_samplenum = di->abs_start_samplenum + hit - 1;
+	update_old_pins_array(di);
+	di->abs_cur_samplenum++;
+	di->abs_cur_matched = FALSE;
+}
+
 static gboolean 
 find_match(struct srd_decoder_inst *di)
 {
@@ -942,6 +1160,7 @@ find_match(struct srd_decoder_inst *di)
 	GSList *l, *cond;
     gboolean skip_allow;
     gboolean all_skip_allow = TRUE;
+    gboolean word_scan;
 
 	/* Caller ensures di != NULL. */
 
@@ -960,14 +1179,20 @@ find_match(struct srd_decoder_inst *di)
     /* di->match_array is 0 here. Create a new GArray. */
     di->match_array = 0;
 
+    word_scan = word_scan_allowed(di);
+
 	/* Sample 0: Set di->old_pins_array for SRD_INITIAL_PIN_SAME_AS_SAMPLE0 pins. */
     if (di->first_pos) {
         di->first_pos = FALSE;
 		update_old_pins_array_initial_pins(di);
     }
 
-    if (di->abs_cur_matched)
+    if (di->abs_cur_matched) {
         di->abs_cur_samplenum++;
+        /* The match was the last sample of the chunk, the next one starts after it. */
+        if (di->abs_cur_samplenum >= di->abs_end_samplenum)
+            di->abs_cur_matched = FALSE;
+    }
 
     while (di->abs_cur_samplenum < di->abs_end_samplenum) {
 
@@ -994,10 +1219,13 @@ find_match(struct srd_decoder_inst *di)
         if (di->abs_cur_matched)
             return TRUE;
 
-        if (all_skip_allow)
+        if (all_skip_allow) {
             di->abs_cur_samplenum = di->abs_end_samplenum;
-        else
+        } else {
             di->abs_cur_samplenum++;
+            if (word_scan && di->abs_cur_samplenum < di->abs_end_samplenum)
+                skip_to_candidate(di);
+        }
     }
 
 	return FALSE;
@@ -1121,6 +1349,10 @@ static gpointer di_thread(gpointer data)
 		srd_exception_catch(&di->python_proc_error, "Protocol decoder instance %s: ", di->inst_id);
 	}
 
+	Py_BEGIN_ALLOW_THREADS
+	srd_inst_flush_annotations(di);
+	Py_END_ALLOW_THREADS
+
 	/*
 	 * Make sure to unblock potentially pending srd_inst_decode()
 	 * calls in application threads after the decode() method might
@@ -1350,18 +1582,27 @@ SRD_PRIV void srd_inst_free(struct srd_decoder_inst *di)
 	GSList *l;
 	struct srd_pd_output *pdo;
 	PyGILState_STATE gstate;
+	int i;
 
 	srd_dbg("Freeing instance %s.", di->inst_id);
 
 	srd_inst_join_decode_thread(di);
 
 	srd_inst_reset_state(di);
+	srd_inst_free_annotations(di);
 
 	gstate = PyGILState_Ensure();
 	Py_DecRef(di->py_inst);
     if (di->py_pinvalues) {
         Py_DecRef(di->py_pinvalues);
     }
+    if (di->py_pinvalues_spare) {
+        Py_DecRef(di->py_pinvalues_spare);
+    }
+	for (i = 0; i < 3; i++)
+		Py_DecRef(di->py_pin_ints[i]);
+	Py_DecRef(di->py_attr_samplenum);
+	Py_DecRef(di->py_attr_matched);
 	PyGILState_Release(gstate);
 
 	g_free(di->inst_id);
@@ -1380,6 +1621,18 @@ SRD_PRIV void srd_inst_free(struct srd_decoder_inst *di)
 	g_free(di);
 }
 
+/** @private */
+SRD_PRIV void srd_inst_join_all(struct srd_session *sess)
+{
+	GSList *l;
+
+	if (!sess)
+		return;
+
+	for (l = sess->di_list; l; l = l->next)
+		srd_inst_join_decode_thread(l->data);
+}
+
 /** @private */
 SRD_PRIV void srd_inst_free_all(struct srd_session *sess)
 {
@@ -31,6 +31,9 @@
 
 #define safe_free(p) if((p)){free((p)); (p) = NULL;}
 
+/* Annotations queued per decoder instance before a batch callback. */
+#define SRD_ANN_BATCH_SIZE	1024
+
 enum {
 	SRD_TERM_HIGH,
 	SRD_TERM_LOW,
@@ -76,6 +79,7 @@ SRD_PRIV int srd_inst_decode(struct srd_decoder_inst *di,
 SRD_PRIV int process_samples_until_condition_match(struct srd_decoder_inst *di, gboolean *found_match);
 SRD_PRIV int srd_inst_terminate_reset(struct srd_decoder_inst *di);
 SRD_PRIV void srd_inst_free(struct srd_decoder_inst *di);
+SRD_PRIV void srd_inst_join_all(struct srd_session *sess);
 SRD_PRIV void srd_inst_free_all(struct srd_session *sess);
 
 /* log.c */
@@ -96,6 +100,8 @@ SRD_PRIV long srd_decoder_apiver(const struct srd_decoder *d);
 /* type_decoder.c */
 SRD_PRIV PyObject *srd_Decoder_type_new(void);
 SRD_PRIV const char *output_type_name(unsigned int idx);
+SRD_PRIV void srd_inst_flush_annotations(struct srd_decoder_inst *di);
+SRD_PRIV void srd_inst_free_annotations(struct srd_decoder_inst *di);
 
 /* type_logic.c */
 SRD_PRIV PyObject *srd_logic_type_new(void);
@@ -257,6 +257,10 @@ struct srd_decoder_inst {
 	struct srd_session *sess;
 	void *py_inst;
     void *py_pinvalues;  /* is a python duple type, like (1,0,255,255)*/
+    void *py_pinvalues_spare; /* the tuple before, while the decoder held it */
+    void *py_pin_ints[3]; /* the pin values 0, 1 and 0xff, shared by the tuple */
+    void *py_attr_samplenum;
+    void *py_attr_matched;
 	char *inst_id;
 	GSList *pd_output;   /* srd_pd_output* type */
 	int dec_num_channels;
@@ -326,6 +330,11 @@ struct srd_decoder_inst {
 
 	/** the task normal ends flag */
 	int  is_task_stop_signal;
+
+	/** Annotations put by the decoder, handed to the frontend in batches. */
+	struct srd_proto_data *ann_batch;
+	struct srd_proto_data_annotation *ann_batch_data;
+	int ann_batch_count;
 };
 
 struct srd_pd_output {
@@ -361,9 +370,13 @@ struct srd_proto_data_binary {
 typedef void (*srd_pd_output_callback)(struct srd_proto_data *pdata,
 					void *cb_data);
 
+typedef void (*srd_pd_output_batch_callback)(struct srd_proto_data *pdata_list,
+					int count, void *cb_data);
+
 struct srd_pd_callback {
 	int output_type;
 	srd_pd_output_callback cb;
+	srd_pd_output_batch_callback batch_cb;
 	void *cb_data;
 };
 
@@ -385,6 +398,8 @@ SRD_API int srd_session_terminate_reset(struct srd_session *sess);
 SRD_API int srd_session_destroy(struct srd_session *sess);
 SRD_API int srd_pd_output_callback_add(struct srd_session *sess,
 		int output_type, srd_pd_output_callback cb, void *cb_data);
+SRD_API int srd_pd_output_batch_callback_add(struct srd_session *sess,
+		int output_type, srd_pd_output_batch_callback cb, void *cb_data);
 
 SRD_API int srd_session_end(struct srd_session *sess, char **error);
 
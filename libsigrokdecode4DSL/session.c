@@ -64,6 +64,7 @@ SRD_PRIV int max_session_id = -1;
 SRD_API int srd_session_new(struct srd_session **sess)
 {
 	struct srd_session *se = NULL;
+	PyGILState_STATE gstate;
 
 	if (!sess)
 		return SRD_ERR_ARG;
@@ -75,10 +76,16 @@ SRD_API int srd_session_new(struct srd_session **sess)
 	}
 	memset(se, 0, sizeof(struct srd_session));
 
+	/*
+	 * Keep a list of all sessions, so we can clean up as needed.
+	 * Decoder stacks may run in parallel, the decoder threads walk
+	 * this list with the GIL held, so it is changed under the GIL.
+	 * The GIL also keeps the session ids unique.
+	 */
+	gstate = PyGILState_Ensure();
 	se->session_id = ++max_session_id;
-
-	/* Keep a list of all sessions, so we can clean up as needed. */
 	sessions = g_slist_append(sessions, se);
+	PyGILState_Release(gstate);
 
 	*sess = se;
 
@@ -344,16 +351,27 @@ SRD_API int srd_session_terminate_reset(struct srd_session *sess)
 SRD_API int srd_session_destroy(struct srd_session *sess)
 {
 	int session_id;
+	PyGILState_STATE gstate;
 
 	if (!sess)
 		return SRD_ERR_ARG;
 
 	session_id = sess->session_id;
+
+	/*
+	 * Stop the decoder threads, then unlink the session under the GIL:
+	 * decoder threads of other sessions walk the list with the GIL held,
+	 * they must not see the instances which are going to be released.
+	 */
+	srd_inst_join_all(sess);
+	gstate = PyGILState_Ensure();
+	sessions = g_slist_remove(sessions, sess);
+	PyGILState_Release(gstate);
+
 	if (sess->di_list)
 		srd_inst_free_all(sess);
 	if (sess->callbacks)
 		g_slist_free_full(sess->callbacks, g_free);
-	sessions = g_slist_remove(sessions, sess);
 	g_free(sess);
 
 	srd_info("Destroyed session %d.", session_id);
@@ -403,6 +421,47 @@ SRD_API int srd_pd_output_callback_add(struct srd_session *sess,
 	return SRD_OK;
 }
 
+/**
+ * Register/add a decoder output callback function that receives
+ * annotations in batches.
+ *
+ * Annotations are queued per decoder instance and handed over when the
+ * queue is full, when a chunk of samples is done, and when decode()
+ * returns. The pdata_list items and their annotation text are only
+ * valid during the call.
+ *
+ * @param sess The output session in which to register the callback.
+ *             Must not be NULL.
+ * @param output_type The output type this callback will receive. Only
+ *                    SRD_OUTPUT_ANN is supported.
+ * @param cb The function to call. Must not be NULL.
+ * @param cb_data Private data for the callback function. Can be NULL.
+ */
+SRD_API int srd_pd_output_batch_callback_add(struct srd_session *sess,
+		int output_type, srd_pd_output_batch_callback cb, void *cb_data)
+{
+	struct srd_pd_callback *pd_cb;
+
+	if (!sess || !cb || output_type != SRD_OUTPUT_ANN)
+		return SRD_ERR_ARG;
+
+	srd_dbg("Registering new batch callback for output type %s.",
+		output_type_name(output_type));
+
+	pd_cb = g_try_malloc0(sizeof(struct srd_pd_callback));
+	if (pd_cb == NULL){
+		srd_err("%s,ERROR:failed to alloc memory.", __func__);
+		return SRD_ERR;
+	}
+
+	pd_cb->output_type = output_type;
+	pd_cb->batch_cb = cb;
+	pd_cb->cb_data = cb_data;
+	sess->callbacks = g_slist_append(sess->callbacks, pd_cb);
+
+	return SRD_OK;
+}
+
 /** @private */
 SRD_PRIV struct srd_pd_callback *srd_pd_output_callback_find(
 		struct srd_session *sess, int output_type)
@@ -470,6 +529,12 @@ SRD_API int srd_session_end(struct srd_session *sess, char **error)
 		}
 	}
 
+	/* Hand over what end() put, before the caller reports the decode done. */
+	Py_BEGIN_ALLOW_THREADS
+	for (d = sess->di_list; d; d = d->next)
+		srd_inst_flush_annotations(d->data);
+	Py_END_ALLOW_THREADS
+
 	PyGILState_Release(gstate);
 	return SRD_OK;
 }
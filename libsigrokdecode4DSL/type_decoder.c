@@ -266,6 +266,92 @@ err:
 	return SRD_ERR_PYTHON;
 }
 
+/*
+ * Hand the queued annotations of one instance to the batch callback,
+ * then drop their text. Doesn't need the GIL.
+ */
+static void flush_annotation_batch(struct srd_decoder_inst *di)
+{
+	struct srd_pd_callback *cb;
+	int i;
+
+	if (di->ann_batch_count == 0)
+		return;
+
+	cb = srd_pd_output_callback_find(di->sess, SRD_OUTPUT_ANN);
+	if (cb && cb->batch_cb)
+		cb->batch_cb(di->ann_batch, di->ann_batch_count, cb->cb_data);
+
+	for (i = 0; i < di->ann_batch_count; i++) {
+		release_annotation(&di->ann_batch_data[i]);
+		di->ann_batch_data[i].ann_text = NULL;
+	}
+	di->ann_batch_count = 0;
+}
+
+/* The next free queue slot, the queue is flushed first when it's full. */
+static struct srd_proto_data *next_annotation_slot(struct srd_decoder_inst *di)
+{
+	struct srd_proto_data *pdata;
+
+	if (di->ann_batch == NULL) {
+		di->ann_batch = g_try_malloc0(sizeof(struct srd_proto_data) * SRD_ANN_BATCH_SIZE);
+		di->ann_batch_data = g_try_malloc0(sizeof(struct srd_proto_data_annotation) * SRD_ANN_BATCH_SIZE);
+
+		if (di->ann_batch == NULL || di->ann_batch_data == NULL) {
+			srd_err("%s,ERROR:failed to alloc memory.", __func__);
+			g_free(di->ann_batch);
+			g_free(di->ann_batch_data);
+			di->ann_batch = NULL;
+			di->ann_batch_data = NULL;
+			return NULL;
+		}
+	}
+
+	if (di->ann_batch_count == SRD_ANN_BATCH_SIZE) {
+		Py_BEGIN_ALLOW_THREADS
+		flush_annotation_batch(di);
+		Py_END_ALLOW_THREADS
+	}
+
+	pdata = &di->ann_batch[di->ann_batch_count];
+	pdata->data = &di->ann_batch_data[di->ann_batch_count];
+	return pdata;
+}
+
+/**
+ * Flush the queued annotations of an instance and the instances stacked
+ * on top of it, which put from the same thread.
+ *
+ * @private
+ */
+SRD_PRIV void srd_inst_flush_annotations(struct srd_decoder_inst *di)
+{
+	GSList *l;
+
+	flush_annotation_batch(di);
+
+	for (l = di->next_di; l; l = l->next)
+		srd_inst_flush_annotations(l->data);
+}
+
+/** @private */
+SRD_PRIV void srd_inst_free_annotations(struct srd_decoder_inst *di)
+{
+	int i;
+
+	if (di->ann_batch_data) {
+		for (i = 0; i < di->ann_batch_count; i++)
+			release_annotation(&di->ann_batch_data[i]);
+	}
+
+	g_free(di->ann_batch);
+	g_free(di->ann_batch_data);
+	di->ann_batch = NULL;
+	di->ann_batch_data = NULL;
+	di->ann_batch_count = 0;
+}
+
 static void release_binary(struct srd_proto_data_binary *pdb)
 {
 	if (!pdb)
@@ -398,9 +484,11 @@ static inline struct srd_decoder_inst *srd_inst_find_by_obj(
 
 	/* Performance shortcut: Handle the most common case first. */
 	sess = sessions->data;
-	di = sess->di_list->data;
-	if (di->py_inst == obj)
-		return di;
+	if (sess->di_list) {
+		di = sess->di_list->data;
+		if (di->py_inst == obj)
+			return di;
+	}
 
 	di = NULL;
 	for (l = sessions; di == NULL && l != NULL; l = l->next) {
@@ -516,6 +604,20 @@ static PyObject *Decoder_put(PyObject *self, PyObject *args)
 	case SRD_OUTPUT_ANN:
 		/* Annotations are only fed to callbacks. */
 		if ((cb = srd_pd_output_callback_find(di->sess, pdo->output_type))) {
+			if (cb->batch_cb) {
+				/* Queue it, the frontend gets a whole batch in one call. */
+				struct srd_proto_data *slot = next_annotation_slot(di);
+				if (slot == NULL)
+					break;
+
+				slot->start_sample = start_sample;
+				slot->end_sample = end_sample;
+				slot->pdo = pdo;
+				if (convert_annotation(di, py_data, slot) == SRD_OK)
+					di->ann_batch_count++;
+				break;
+			}
+
 			pdata.data = &pda;
 			/* Convert from PyDict to srd_proto_data_annotation. */
 			if (convert_annotation(di, py_data, &pdata) != SRD_OK) {
@@ -736,21 +838,54 @@ static int get_term_type(const char *v)
 	return -1;
 }
 
+/* The value of a pin at the current sample number: 0, 1, or 0xff if unused. */
+static inline int current_pin_value(const struct srd_decoder_inst *di, int i)
+{
+	uint64_t offset;
+
+	/* A channelmap value of -1 means "unused optional channel". */
+	if (di->dec_channelmap[i] == -1)
+		return 0xff;
+
+	if (*(di->inbuf + i) == NULL)
+		return *(di->inbuf_const + i) ? 1 : 0;
+
+	offset = di->abs_cur_samplenum - di->abs_start_samplenum;
+	return (*(*(di->inbuf + i) + offset / 8) >> (offset % 8)) & 1;
+}
+
+/* The pins at the current sample number as bits, unused pins read 0. */
+static uint64_t current_pin_word(const struct srd_decoder_inst *di)
+{
+	uint64_t word;
+	int i;
+
+	word = 0;
+	for (i = 0; i < di->dec_num_channels && i < 64; i++) {
+		if (current_pin_value(di, i) == 1)
+			word |= 1ULL << i;
+	}
+
+	return word;
+}
+
 /**
  * Get the pin values at the current sample number.
  *
+ * The tuple is reused while the decoder doesn't keep a reference to it,
+ * and only the changed pins are replaced with the cached int objects.
+ * A decoder doing "pins = self.wait()" still holds the last tuple when
+ * it calls wait() again, so two tuples are used in turn. A new tuple is
+ * only allocated while the decoder holds both of them.
+ *
  * @param di The decoder instance to use. Must not be NULL.
  *           The number of channels must be >= 1.
- *
- * @return A newly allocated PyTuple containing the pin values at the
- *         current sample number.
  */
-static int get_current_pinvalues(const struct srd_decoder_inst *di)
+static int get_current_pinvalues(struct srd_decoder_inst *di)
 {
-	int i;
-	uint8_t sample;
-	const uint8_t *sample_pos;
-    int bit_offset;
+	int i, value;
+	PyObject *py_value;
+	PyObject *py_tuple;
 	PyGILState_STATE gstate;
 
 	if (!di) {
@@ -760,23 +895,25 @@ static int get_current_pinvalues(const struct srd_decoder_inst *di)
 
 	gstate = PyGILState_Ensure();
 
+	/* The decoder still holds the last tuple, it must not change. */
+	if (di->py_pinvalues && Py_REFCNT((PyObject *)di->py_pinvalues) > 1) {
+		py_tuple = di->py_pinvalues_spare;
+		di->py_pinvalues_spare = di->py_pinvalues;
+
+		if (py_tuple == NULL || Py_REFCNT(py_tuple) > 1) {
+			Py_XDECREF(py_tuple);
+			py_tuple = PyTuple_New(di->dec_num_channels);
+		}
+		di->py_pinvalues = py_tuple;
+	}
+
 	for (i = 0; i < di->dec_num_channels; i++) {
-		/* A channelmap value of -1 means "unused optional channel". */
-		if (di->dec_channelmap[i] == -1) {
-			/* Value of unused channel is 0xff, instead of 0 or 1. 
-			   Done set -1 by srd_inst_channel_set_all()
-			*/
-            PyTuple_SetItem(di->py_pinvalues, i, PyLong_FromLong(0xff));
-		} else {
-            if (*(di->inbuf + i) == NULL) {
-                sample = *(di->inbuf_const + i) ? 1 : 0;
-                PyTuple_SetItem(di->py_pinvalues, i, PyLong_FromLong(sample));
-            } else {
-                sample_pos = *(di->inbuf + i) + ((di->abs_cur_samplenum - di->abs_start_samplenum) / 8);
-                bit_offset = (di->abs_cur_samplenum - di->abs_start_samplenum) % 8;
-                sample = *sample_pos & (1 << bit_offset) ? 1 : 0;
-                PyTuple_SetItem(di->py_pinvalues, i, PyLong_FromLong(sample));
-            }
+		value = current_pin_value(di, i);
+		py_value = di->py_pin_ints[value == 0xff ? 2 : value];
+
+		if (PyTuple_GetItem(di->py_pinvalues, i) != py_value) {
+			Py_IncRef(py_value);
+			PyTuple_SetItem(di->py_pinvalues, i, py_value);
 		}
 	}
 
@@ -785,6 +922,20 @@ static int get_current_pinvalues(const struct srd_decoder_inst *di)
     return SRD_OK;
 }
 
+/* Set self.samplenum and self.matched. */
+static void set_match_attrs(struct srd_decoder_inst *di, uint64_t samplenum, uint64_t matched)
+{
+	PyObject *py_value;
+
+	py_value = PyLong_FromUnsignedLongLong(samplenum);
+	PyObject_SetAttr(di->py_inst, di->py_attr_samplenum, py_value);
+	Py_DECREF(py_value);
+
+	py_value = PyLong_FromUnsignedLongLong(matched);
+	PyObject_SetAttr(di->py_inst, di->py_attr_matched, py_value);
+	Py_DECREF(py_value);
+}
+
 /**
  * Create a list of terms in the specified condition.
  *
@@ -886,14 +1037,14 @@ err:
  *                 The contents of di->condition_list are undefined.
  * @retval 9999 TODO.
  */
-static int set_new_condition_list(struct srd_decoder_inst *di, PyObject *args)
+static int set_new_condition_list(struct srd_decoder_inst *di, PyObject *py_conds)
 {
 	GSList *term_list;
-	PyObject *py_conditionlist, *py_conds, *py_dict;
+	PyObject *py_conditionlist, *py_dict;
 	int i, num_conditions, ret;
 	PyGILState_STATE gstate;
 
-    if (!args)
+    if (!py_conds)
 		return SRD_ERR_ARG;
 
 	gstate = PyGILState_Ensure();
@@ -908,18 +1059,10 @@ static int set_new_condition_list(struct srd_decoder_inst *di, PyObject *args)
 	}
 
 	/*
-	 * Parse the argument of self.wait() into 'py_conds', and check
-	 * the data type. The argument is optional, None is assumed in
-	 * its absence. None or an empty dict or an empty list mean that
-	 * there is no condition, and the next available sample shall
-	 * get returned to the caller.
+	 * Check the data type of the self.wait() argument. None or an
+	 * empty dict or an empty list mean that there is no condition,
+	 * and the next available sample shall get returned to the caller.
 	 */
-    py_conds = Py_None;
-	if (!PyArg_ParseTuple(args, "|O", &py_conds)) {
-		/* Let Python raise this exception. */
-		goto err;
-	}
-
 	if (py_conds == Py_None) {
 		/* 'py_conds' is None. */
 		goto ret_9999;
@@ -1035,12 +1178,29 @@ static int set_skip_condition(struct srd_decoder_inst *di, uint64_t count)
 	return SRD_OK;
 }
 
+/*
+ * All samples of the current chunk were processed, reset state for the
+ * next chunk and signal the main thread. Caller holds the data mutex.
+ */
+static void release_chunk(struct srd_decoder_inst *di)
+{
+	di->got_new_samples = FALSE;
+	di->handled_all_samples = TRUE;
+	di->abs_start_samplenum = 0;
+	di->abs_end_samplenum = 0;
+	di->inbuf = NULL;
+	di->inbuflen = 0;
+
+	g_cond_signal(&di->handled_all_samples_cond);
+}
+
 static PyObject *Decoder_wait(PyObject *self, PyObject *args)
 {
 	int ret;
 	uint64_t skip_count;
 	gboolean found_match;
 	struct srd_decoder_inst *di;
+	PyObject *py_conds;
     PyGILState_STATE gstate; 
 
 	if (!self || !args)
@@ -1054,7 +1214,14 @@ static PyObject *Decoder_wait(PyObject *self, PyObject *args)
 		Py_RETURN_NONE;
 	}
 
-    ret = set_new_condition_list(di, args);
+	/* The argument is optional, None is assumed in its absence. */
+    py_conds = Py_None;
+	if (!PyArg_ParseTuple(args, "|O", &py_conds)) {
+		/* Let Python raise this exception. */
+		goto err;
+	}
+
+    ret = set_new_condition_list(di, py_conds);
     if (ret < 0) {
         srd_dbg("%s: %s: Aborting wait().", di->inst_id, __func__);
         goto err;
@@ -1105,40 +1272,30 @@ static PyObject *Decoder_wait(PyObject *self, PyObject *args)
         /* Ignore return value for now, should never be negative. */
         process_samples_until_condition_match(di, &found_match);
 
+        /* Hand over what this chunk produced before reporting it done. */
+        if (!found_match)
+            srd_inst_flush_annotations(di);
+
         Py_END_ALLOW_THREADS
 
         /* If there's a match, set self.samplenum etc. and return. */
         if (found_match) {
-            /* Set self.samplenum to the (absolute) sample number that matched. */
-            PyObject *py_cur_samplenum = PyLong_FromUnsignedLongLong(di->abs_cur_samplenum);
-            PyObject_SetAttrString(di->py_inst, "samplenum", py_cur_samplenum);
-            Py_DECREF(py_cur_samplenum);
-
-            /* Set self.matched to math_array. */
-            PyObject *py_matched = PyLong_FromUnsignedLongLong(di->match_array);
-            PyObject_SetAttrString(di->py_inst, "matched", py_matched);
-            Py_DECREF(py_matched);
+            /* The (absolute) sample number that matched, and math_array. */
+            set_match_attrs(di, di->abs_cur_samplenum, di->match_array);
 
             get_current_pinvalues(di);
 
             g_mutex_unlock(&di->data_mutex);
 
+            Py_INCREF(di->py_pinvalues);
+
             PyGILState_Release(gstate);
 
-            Py_INCREF(di->py_pinvalues);
             return (PyObject *)di->py_pinvalues;
         } 
  
 		/* No match, reset state for the next chunk. */
-		di->got_new_samples = FALSE;
-		di->handled_all_samples = TRUE;
-		di->abs_start_samplenum = 0;
-		di->abs_end_samplenum = 0;
-		di->inbuf = NULL;
-		di->inbuflen = 0;
-
-		/* Signal the main thread that we handled all samples. */
-		g_cond_signal(&di->handled_all_samples_cond);
+		release_chunk(di);
 
 		/*
 		 * When termination of wait() and decode() was requested,
@@ -1164,6 +1321,151 @@ err:
 	return NULL;
 }
 
+static gboolean have_skip_term(const struct srd_decoder_inst *di)
+{
+	const GSList *l, *t;
+
+	for (l = di->condition_list; l; l = l->next) {
+		for (t = l->data; t; t = t->next) {
+			if (((struct srd_term *)t->data)->type == SRD_TERM_SKIP)
+				return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Wait for up to max_count consecutive matches of the same conditions.
+ *
+ * Returns a bytes object of records with three native uint64 values:
+ * the sample number, the pin word (bit n is pin n, unused pins read 0)
+ * and the matched bits. Decoders can walk it with
+ * memoryview(records).cast('Q'). Fewer records are returned when the
+ * current chunk of samples is used up. self.samplenum and self.matched
+ * are those of the last record.
+ *
+ * Only level and edge conditions are supported, skip counts and empty
+ * condition lists need wait().
+ */
+static PyObject *Decoder_wait_bulk(PyObject *self, PyObject *args)
+{
+	int ret;
+	Py_ssize_t max_count, count;
+	gboolean found_match;
+	struct srd_decoder_inst *di;
+	PyObject *py_conds, *py_res;
+	uint64_t *records, *rec;
+	PyGILState_STATE gstate;
+
+	if (!self || !args)
+		return NULL;
+
+	gstate = PyGILState_Ensure();
+
+	if (!(di = srd_inst_find_by_obj(NULL, self))) {
+		PyErr_SetString(PyExc_Exception, "decoder instance not found");
+		PyGILState_Release(gstate);
+		Py_RETURN_NONE;
+	}
+
+	max_count = 4096;
+	if (!PyArg_ParseTuple(args, "O|n", &py_conds, &max_count))
+		goto err;
+
+	if (max_count < 1) {
+		PyErr_SetString(PyExc_ValueError, "max_count must be positive");
+		goto err;
+	}
+
+	ret = set_new_condition_list(di, py_conds);
+	if (ret < 0) {
+		srd_dbg("%s: %s: Aborting wait_bulk().", di->inst_id, __func__);
+		goto err;
+	}
+
+	if (ret == 9999 || have_skip_term(di)) {
+		PyErr_SetString(PyExc_ValueError, "wait_bulk() needs level or edge conditions");
+		goto err;
+	}
+
+	records = g_try_malloc(sizeof(uint64_t) * 3 * max_count);
+	if (records == NULL) {
+		PyErr_NoMemory();
+		goto err;
+	}
+	count = 0;
+
+	while (1) {
+
+		Py_BEGIN_ALLOW_THREADS
+
+		/* Wait for new samples to process, or termination request. */
+		g_mutex_lock(&di->data_mutex);
+		while (!di->got_new_samples && !di->want_wait_terminate)
+			g_cond_wait(&di->got_new_samples_cond, &di->data_mutex);
+
+		found_match = FALSE;
+
+		while (count < max_count) {
+			process_samples_until_condition_match(di, &found_match);
+			if (!found_match)
+				break;
+
+			rec = records + count * 3;
+			rec[0] = di->abs_cur_samplenum;
+			rec[1] = current_pin_word(di);
+			rec[2] = di->match_array;
+			count++;
+		}
+
+		/* Hand over what this chunk produced before reporting it done. */
+		if (!found_match)
+			srd_inst_flush_annotations(di);
+
+		Py_END_ALLOW_THREADS
+
+		/*
+		 * The chunk is released by the next call, once the decoder has
+		 * put what the records give. Else the last annotations of the
+		 * stream could come after srd_session_end(). A full buffer
+		 * leaves the rest of the chunk for the next call too.
+		 */
+		if (found_match || count > 0) {
+			g_mutex_unlock(&di->data_mutex);
+			break;
+		}
+
+		release_chunk(di);
+
+		if (di->want_wait_terminate) {
+			srd_dbg("%s: %s: Will return from wait_bulk().",
+				di->inst_id, __func__);
+			g_mutex_unlock(&di->data_mutex);
+			g_free(records);
+			goto err;
+		}
+
+		g_mutex_unlock(&di->data_mutex);
+	}
+
+	rec = records + (count - 1) * 3;
+	set_match_attrs(di, rec[0], rec[2]);
+
+	py_res = PyBytes_FromStringAndSize((const char *)records,
+			sizeof(uint64_t) * 3 * count);
+	g_free(records);
+
+	PyGILState_Release(gstate);
+
+	return py_res;
+
+err:
+	PyGILState_Release(gstate);
+
+	return NULL;
+}
+
 /**
  * Return whether the specified channel was supplied to the decoder.
  *
@@ -1285,6 +1587,9 @@ static PyMethodDef Decoder_methods[] = {
 	{ "wait", Decoder_wait, METH_VARARGS,
 			"Wait for one or more conditions to occur" },
 
+	{ "wait_bulk", Decoder_wait_bulk, METH_VARARGS,
+			"Wait for many matches of the conditions, returns packed records" },
+
 	{ "has_channel", Decoder_has_channel, METH_VARARGS,
 			"Report whether a channel was supplied" },
 